@@ -11,12 +11,16 @@ failed_assertion::failed_assertion(const char* file, int line, const char* cond,
   stream_ << "[" << func << "] Assertion `" << cond << "` failed: ";
 }
 
+#ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4722)  // dtor never returns
+#endif
 failed_assertion::~failed_assertion() {
-  LOG_FULL(error, file_, line_) << stream_.str();
+  logging::impl::log_fatal(file_, line_, stream_.str());  // the process is about to die
   std::terminate();
 }
+#ifdef _MSC_VER
 #pragma warning(pop)
+#endif
 
 }  // namespace base::impl
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "delayed_task_handle.h"
+
+#include "base/event_loop/impl/task_queue.h"
+#include "base/event_loop/loop_task_runner.h"
+#include <utility>
+
+namespace base {
+
+delayed_task_handle::delayed_task_handle(delayed_task_handle&& rhs) noexcept {
+  swap(rhs);
+}
+
+delayed_task_handle& delayed_task_handle::operator=(delayed_task_handle rhs) noexcept {
+  rhs.swap(*this);
+  return *this;
+}
+
+void delayed_task_handle::swap(delayed_task_handle& other) noexcept {
+  std::swap(runner_, other.runner_);
+  std::swap(node_, other.node_);
+
+  // keep the back-pointers from the nodes in sync
+  if (node_) {
+    node_->handle = this;
+  }
+  if (other.node_) {
+    other.node_->handle = &other;
+  }
+}
+
+
+void delayed_task_handle::cancel() {
+  if (node_) {
+    runner_->cancel_task(node_);  // detaches us as well
+  }
+}
+
+
+// PRIVATE
+
+void delayed_task_handle::attach(loop_task_runner* runner, impl::task_node* node) {
+  cancel();
+
+  runner_ = runner;
+  node_ = node;
+  node->handle = this;
+}
+
+}  // namespace base
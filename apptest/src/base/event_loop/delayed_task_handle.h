@@ -0,0 +1,44 @@
+#pragma once
+
+#include "base/non_copyable.h"
+
+namespace base {
+
+class loop_task_runner;
+
+namespace impl {
+struct task_node;
+}
+
+// Refers to a task posted with loop_task_runner::post_cancelable_task. The handle (and the
+// task it refers to) may only be used on the thread the task was posted from. Destroying the
+// handle cancels the task.
+class delayed_task_handle : public non_copyable {
+public:
+  delayed_task_handle() = default;
+  delayed_task_handle(delayed_task_handle&& rhs) noexcept;
+  ~delayed_task_handle() { cancel(); }
+
+  delayed_task_handle& operator=(delayed_task_handle rhs) noexcept;
+  void swap(delayed_task_handle& other) noexcept;
+
+  // Removes the task from its runner's queues. Does nothing if the task has already started
+  // running or has been canceled.
+  void cancel();
+  bool is_pending() const { return !!node_; }
+
+private:
+  friend loop_task_runner;
+  friend impl::task_node;
+
+  void attach(loop_task_runner* runner, impl::task_node* node);
+
+  loop_task_runner* runner_ = nullptr;
+  impl::task_node* node_ = nullptr;
+};
+
+inline void swap(delayed_task_handle& lhs, delayed_task_handle& rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+}  // namespace base
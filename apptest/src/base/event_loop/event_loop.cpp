@@ -65,6 +65,13 @@ void event_loop::run() {
       break;
     }
 
+    if (!ran_task) {
+      ran_task = run_idle_task();
+      if (should_quit_) {
+        break;
+      }
+    }
+
     if (!ran_task) {
       auto next_run_time = get_next_run_time();
       if (next_run_time) {
@@ -115,6 +122,10 @@ bool event_loop::run_delayed_task() {
   return get_runner()->run_delayed_task();
 }
 
+bool event_loop::run_idle_task() {
+  return get_runner()->run_idle_task();
+}
+
 std::optional<task::run_time_type> event_loop::get_next_run_time() const {
   return get_runner()->get_next_run_time();
 }
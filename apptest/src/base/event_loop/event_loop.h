@@ -28,6 +28,7 @@ public:
 protected:
   bool run_pending_task();
   bool run_delayed_task();
+  bool run_idle_task();  // only call this when there is nothing else to do
   std::optional<task::run_time_type> get_next_run_time() const;
 
 private:
@@ -0,0 +1,70 @@
+#include "delayed_task_queue.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace base::impl {
+namespace {
+
+bool node_less(const task_node_ptr& lhs, const task_node_ptr& rhs) {
+  return lhs->tsk < rhs->tsk;
+}
+
+}  // namespace
+
+void delayed_task_heap::push(task_node_ptr node) {
+  heap_.push_back(std::move(node));
+  std::push_heap(heap_.begin(), heap_.end(), node_less);
+}
+
+task_node_ptr delayed_task_heap::pop_due(const task::run_time_type& now) {
+  auto next_run_time = this->next_run_time();  // discards canceled tasks
+  if (!next_run_time || *next_run_time > now) {
+    return nullptr;
+  }
+  return pop_top();
+}
+
+std::optional<task::run_time_type> delayed_task_heap::next_run_time() {
+  while (!heap_.empty() && heap_.front()->is_canceled()) {
+    pop_top();
+  }
+
+  if (heap_.empty()) {
+    return std::nullopt;
+  }
+  return heap_.front()->tsk.run_time;
+}
+
+void delayed_task_heap::cancel(task_node* node) {
+  node->cancel();  // discarded once it reaches the top
+}
+
+void delayed_task_heap::remove_canceled() {
+  auto it = std::remove_if(heap_.begin(), heap_.end(), [](const task_node_ptr& node) {
+    return node->is_canceled();
+  });
+  heap_.erase(it, heap_.end());
+  std::make_heap(heap_.begin(), heap_.end(), node_less);
+}
+
+task_list delayed_task_heap::take_all() {
+  task_list ret;
+  for (auto& node : heap_) {
+    ret.push(std::move(node));
+  }
+  heap_.clear();
+  return ret;
+}
+
+
+// PRIVATE
+
+task_node_ptr delayed_task_heap::pop_top() {
+  std::pop_heap(heap_.begin(), heap_.end(), node_less);
+  task_node_ptr ret = std::move(heap_.back());
+  heap_.pop_back();
+  return ret;
+}
+
+}  // namespace base::impl
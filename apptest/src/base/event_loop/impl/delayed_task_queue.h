@@ -0,0 +1,54 @@
+#pragma once
+
+#include "base/event_loop/impl/task_queue.h"
+#include "base/non_copyable.h"
+#include "base/task_runner/task.h"
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace base::impl {
+
+class delayed_task_queue : public non_copy_movable {
+public:
+  virtual ~delayed_task_queue() = default;
+
+  virtual void push(task_node_ptr node) = 0;
+
+  // Returns the next task due at `now`, or null if there is none. This is only guaranteed to
+  // succeed if `now` is no earlier than the value returned by next_run_time().
+  virtual task_node_ptr pop_due(const task::run_time_type& now) = 0;
+
+  // May discard canceled tasks at the front of the queue, hence non-const
+  virtual std::optional<task::run_time_type> next_run_time() = 0;
+
+  // `node` must be owned by this queue; it is detached from its handle and never run
+  virtual void cancel(task_node* node) = 0;
+
+  // frees all canceled tasks still held by the queue
+  virtual void remove_canceled() = 0;
+
+  virtual std::size_t size() const = 0;  // including canceled tasks not yet removed
+  virtual task_list take_all() = 0;
+};
+
+
+// Binary heap ordered by run time. Canceled tasks are discarded once they reach the top, or when
+// the whole heap is swept by remove_canceled().
+class delayed_task_heap : public delayed_task_queue {
+public:
+  void push(task_node_ptr node) override;
+  task_node_ptr pop_due(const task::run_time_type& now) override;
+  std::optional<task::run_time_type> next_run_time() override;
+  void cancel(task_node* node) override;
+  void remove_canceled() override;
+  std::size_t size() const override { return heap_.size(); }
+  task_list take_all() override;
+
+private:
+  task_node_ptr pop_top();
+
+  std::vector<task_node_ptr> heap_;
+};
+
+}  // namespace base::impl
@@ -0,0 +1,130 @@
+#include "task_queue.h"
+
+#include "base/assert.h"
+#include "base/event_loop/delayed_task_handle.h"
+#include <utility>
+
+namespace base::impl {
+
+void task_node::cancel() {
+  tsk.callback = nullptr;
+  detach_handle();
+}
+
+void task_node::detach_handle() {
+  if (handle) {
+    handle->node_ = nullptr;
+    handle = nullptr;
+  }
+}
+
+
+task_list::task_list(task_list&& rhs) noexcept
+  : head_(std::exchange(rhs.head_, nullptr))
+  , tail_(std::exchange(rhs.tail_, nullptr)) {
+}
+
+task_list& task_list::operator=(task_list rhs) noexcept {
+  rhs.swap(*this);
+  return *this;
+}
+
+void task_list::swap(task_list& other) noexcept {
+  std::swap(head_, other.head_);
+  std::swap(tail_, other.tail_);
+}
+
+
+void task_list::push(task_node_ptr node) {
+  task_node* raw_node = node.release();
+  raw_node->next = nullptr;
+
+  if (tail_) {
+    tail_->next = raw_node;
+  } else {
+    head_ = raw_node;
+  }
+  tail_ = raw_node;
+}
+
+task_node_ptr task_list::pop() {
+  ASSERT(!empty()) << "Popping from empty task list";
+
+  task_node_ptr node(head_);
+  head_ = node->next;
+  if (!head_) {
+    tail_ = nullptr;
+  }
+
+  node->next = nullptr;
+  return node;
+}
+
+void task_list::clear() {
+  while (head_) {
+    delete std::exchange(head_, head_->next);
+  }
+  tail_ = nullptr;
+}
+
+
+incoming_task_queue::~incoming_task_queue() {
+  take_all();  // the returned list frees any remaining nodes
+}
+
+
+bool incoming_task_queue::push(task_node_ptr node) {
+  task_node* raw_node = node.release();
+
+  task_node* old_head = head_.load(std::memory_order_relaxed);
+  do {
+    raw_node->next = old_head;
+  } while (!head_.compare_exchange_weak(old_head, raw_node, std::memory_order_release, std::memory_order_relaxed));
+
+  return !old_head;
+}
+
+bool incoming_task_queue::push_all(task_list nodes) {
+  if (nodes.empty()) {
+    return false;
+  }
+
+  // link the nodes up in LIFO order beforehand, so that the chain can be pushed as a whole
+  task_node* bottom = nodes.head_;
+  task_node* top = nullptr;
+  for (task_node* node = std::exchange(nodes.head_, nullptr); node;) {
+    task_node* next = node->next;
+    node->next = top;
+    top = node;
+    node = next;
+  }
+  nodes.tail_ = nullptr;
+
+  task_node* old_head = head_.load(std::memory_order_relaxed);
+  do {
+    bottom->next = old_head;
+  } while (!head_.compare_exchange_weak(old_head, top, std::memory_order_release, std::memory_order_relaxed));
+
+  return !old_head;
+}
+
+task_list incoming_task_queue::take_all() {
+  // The consumer always detaches the whole stack, so individual nodes are never popped
+  // concurrently with a push and the usual ABA problem can't arise.
+  task_node* node = head_.exchange(nullptr, std::memory_order_acquire);
+
+  task_list ret;
+  ret.tail_ = node;
+
+  // the stack is in LIFO order - reverse it
+  while (node) {
+    task_node* next = node->next;
+    node->next = ret.head_;
+    ret.head_ = node;
+    node = next;
+  }
+
+  return ret;
+}
+
+}  // namespace base::impl
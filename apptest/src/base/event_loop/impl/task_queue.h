@@ -0,0 +1,79 @@
+#pragma once
+
+#include "base/non_copyable.h"
+#include "base/task_runner/task.h"
+#include <atomic>
+#include <memory>
+
+namespace base {
+
+class delayed_task_handle;
+
+namespace impl {
+
+struct task_node : public non_copy_movable {
+  explicit task_node(task&& tsk)
+    : tsk(std::move(tsk)) {}
+  ~task_node() { detach_handle(); }
+
+  bool is_canceled() const { return !tsk.callback || tsk.is_canceled(); }
+  void cancel();
+  void detach_handle();
+
+  task tsk;
+  task_node* next = nullptr;
+  bool delayed = false;  // set once the node is owned by a delayed_task_queue
+
+  // only used while the node is linked into a timer_wheel
+  task_node* prev = nullptr;
+  task_node** list = nullptr;
+
+  delayed_task_handle* handle = nullptr;
+};
+
+using task_node_ptr = std::unique_ptr<task_node>;
+
+
+// FIFO list of task nodes, accessed by a single thread only
+class task_list : public non_copyable {
+public:
+  task_list() = default;
+  task_list(task_list&& rhs) noexcept;
+  ~task_list() { clear(); }
+
+  task_list& operator=(task_list rhs) noexcept;
+  void swap(task_list& other) noexcept;
+
+  bool empty() const { return !head_; }
+
+  void push(task_node_ptr node);
+  task_node_ptr pop();
+  void clear();
+
+private:
+  friend class incoming_task_queue;
+
+  task_node* head_ = nullptr;
+  task_node* tail_ = nullptr;
+};
+
+
+// Lock-free multi-producer, single-consumer queue. Producers push onto an intrusive stack with a
+// single CAS, while the consumer detaches the entire stack at once and restores posting order.
+class incoming_task_queue : public non_copy_movable {
+public:
+  incoming_task_queue() = default;
+  ~incoming_task_queue();
+
+  // returns true if the queue was empty before `node` was pushed
+  bool push(task_node_ptr node);
+  // pushes all of `nodes` in order, with a single CAS; returns true if the queue was empty before
+  bool push_all(task_list nodes);
+  task_list take_all();
+
+private:
+  std::atomic<task_node*> head_ = nullptr;
+};
+
+}  // namespace impl
+}  // namespace base
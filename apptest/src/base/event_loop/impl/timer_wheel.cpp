@@ -0,0 +1,332 @@
+#include "timer_wheel.h"
+
+#include "base/assert.h"
+#include <algorithm>
+#include <utility>
+
+namespace base::impl {
+
+timer_wheel::timer_wheel(task::delay_type resolution)
+  : epoch_(task::clock_type::now())
+  , resolution_(resolution) {
+  ASSERT(resolution > task::delay_type::zero()) << "Timer wheel resolution must be positive";
+}
+
+timer_wheel::~timer_wheel() {
+  take_all();  // the returned list frees all remaining nodes
+}
+
+
+void timer_wheel::push(task_node_ptr node) {
+  task_node* raw_node = node.release();
+  place(raw_node);
+
+  if (next_run_time_valid_) {
+    // cheaper than recomputing: the new task can only bring the next run time forward
+    auto run_time = raw_node->list == &expired_ ?
+      raw_node->tsk.run_time : tick_to_run_time(run_time_to_tick(raw_node->tsk.run_time));
+
+    if (!cached_next_run_time_ || run_time < *cached_next_run_time_) {
+      cached_next_run_time_ = run_time;
+    }
+  }
+}
+
+task_node_ptr timer_wheel::pop_due(const task::run_time_type& now) {
+  advance(now_to_tick(now));
+
+  while (expired_) {
+    task_node_ptr node(expired_);
+    unlink(node.get());
+    next_run_time_valid_ = false;
+
+    if (!node->is_canceled()) {
+      return node;
+    }
+  }
+
+  return nullptr;
+}
+
+std::optional<task::run_time_type> timer_wheel::next_run_time() {
+  if (!next_run_time_valid_) {
+    cached_next_run_time_ = compute_next_run_time();
+    next_run_time_valid_ = true;
+  }
+  return cached_next_run_time_;
+}
+
+void timer_wheel::cancel(task_node* node) {
+  ASSERT(node->list) << "Canceling task not owned by timer wheel";
+
+  unlink(node);
+  next_run_time_valid_ = false;
+  delete node;  // detaches the handle
+}
+
+void timer_wheel::remove_canceled() {
+  remove_canceled(&expired_);
+  for (auto& level : slots_) {
+    for (auto& slot : level) {
+      remove_canceled(&slot);
+    }
+  }
+  remove_canceled(&overflow_);
+
+  next_run_time_valid_ = false;
+}
+
+task_list timer_wheel::take_all() {
+  task_list ret;
+
+  auto take_list = [&](task_node** list) {
+    while (*list) {
+      task_node* node = *list;
+      unlink(node);
+      ret.push(task_node_ptr(node));
+    }
+  };
+
+  take_list(&expired_);
+  for (auto& level : slots_) {
+    for (auto& slot : level) {
+      take_list(&slot);
+    }
+  }
+  take_list(&overflow_);
+
+  next_run_time_valid_ = false;
+  return ret;
+}
+
+
+// PRIVATE
+
+timer_wheel::tick_type timer_wheel::run_time_to_tick(const task::run_time_type& run_time) const {
+  if (run_time <= epoch_) {
+    return 0;
+  }
+  auto ticks = (run_time - epoch_ + resolution_ - task::delay_type(1)) / resolution_;
+  return static_cast<tick_type>(ticks);
+}
+
+timer_wheel::tick_type timer_wheel::now_to_tick(const task::run_time_type& now) const {
+  if (now <= epoch_) {
+    return 0;
+  }
+  return static_cast<tick_type>((now - epoch_) / resolution_);
+}
+
+task::run_time_type timer_wheel::tick_to_run_time(tick_type tick) const {
+  return epoch_ + resolution_ * tick;
+}
+
+
+int timer_wheel::level_of(task_node** list) const {
+  if (list == &overflow_) {
+    return level_count;
+  }
+  return static_cast<int>((list - &slots_[0][0]) / slot_count);
+}
+
+
+void timer_wheel::place(task_node* node) {
+  tick_type tick = run_time_to_tick(node->tsk.run_time);
+
+  if (tick <= current_tick_) {
+    link(node, &expired_);
+    return;
+  }
+
+  // find the lowest level whose current block contains `tick`
+  for (int level = 0; level < level_count; level++) {
+    int block_shift = (level + 1) * level_bits;
+    if ((tick >> block_shift) == (current_tick_ >> block_shift)) {
+      link(node, &slots_[level][slot_index(tick, level)]);
+      return;
+    }
+  }
+
+  link(node, &overflow_);
+}
+
+void timer_wheel::link(task_node* node, task_node** list) {
+  node->list = list;
+  node->prev = nullptr;
+
+  if (list == &expired_) {
+    // the expired list is kept in FIFO order
+    node->next = nullptr;
+    node->prev = expired_tail_;
+    if (expired_tail_) {
+      expired_tail_->next = node;
+    } else {
+      expired_ = node;
+    }
+    expired_tail_ = node;
+    ++expired_count_;
+    return;
+  }
+
+  node->next = *list;
+  if (node->next) {
+    node->next->prev = node;
+  }
+  *list = node;
+  ++level_counts_[level_of(list)];
+  ++scheduled_count_;
+}
+
+void timer_wheel::unlink(task_node* node) {
+  if (node->prev) {
+    node->prev->next = node->next;
+  } else {
+    *node->list = node->next;
+  }
+
+  if (node->next) {
+    node->next->prev = node->prev;
+  }
+
+  if (node->list == &expired_) {
+    if (node == expired_tail_) {
+      expired_tail_ = node->prev;
+    }
+    --expired_count_;
+  } else {
+    --level_counts_[level_of(node->list)];
+    --scheduled_count_;
+  }
+
+  node->list = nullptr;
+  node->prev = nullptr;
+  node->next = nullptr;
+}
+
+
+void timer_wheel::advance(tick_type target) {
+  while (current_tick_ < target) {
+    if (!scheduled_count_) {
+      current_tick_ = target;  // nothing to expire or cascade along the way
+      break;
+    }
+
+    int lowest = 0;
+    while (!level_counts_[lowest]) {
+      ++lowest;
+    }
+
+    if (lowest == 0) {
+      // expire the rest of the current level 0 block, up to `target`
+      tick_type upto = std::min(target, current_tick_ | slot_mask);
+      for (tick_type tick = current_tick_ + 1; tick <= upto; tick++) {
+        expire_all(&slots_[0][slot_index(tick, 0)]);
+      }
+      current_tick_ = upto;
+    } else {
+      // lower levels are empty, so nothing happens until the next slot on `lowest` is reached
+      tick_type block_mask = (tick_type(1) << (lowest * level_bits)) - 1;
+      current_tick_ = std::min(target, current_tick_ | block_mask);
+    }
+
+    if (current_tick_ == target) {
+      break;
+    }
+
+    // move into the next block
+    ++current_tick_;
+    cascade();
+    expire_all(&slots_[0][slot_index(current_tick_, 0)]);
+  }
+}
+
+void timer_wheel::cascade() {
+  // `current_tick_` has just entered a new level 0 block; it may also have entered new blocks on
+  // higher levels, which must be cascaded first (top-down) so that their tasks can trickle down
+  int top = 1;
+  while (top < level_count && slot_index(current_tick_, top) == 0) {
+    ++top;
+  }
+
+  if (top == level_count) {
+    replace_all(&overflow_);
+  }
+
+  for (int level = std::min(top, level_count - 1); level > 0; level--) {
+    replace_all(&slots_[level][slot_index(current_tick_, level)]);
+  }
+}
+
+void timer_wheel::replace_all(task_node** list) {
+  task_node* node = *list;
+  while (node) {
+    task_node* next = node->next;
+    unlink(node);
+    place(node);
+    node = next;
+  }
+}
+
+void timer_wheel::expire_all(task_node** list) {
+  while (*list) {
+    task_node* node = *list;
+    unlink(node);
+    link(node, &expired_);
+  }
+}
+
+
+void timer_wheel::remove_canceled(task_node** list) {
+  task_node* node = *list;
+  while (node) {
+    task_node* next = node->next;
+    if (node->is_canceled()) {
+      unlink(node);
+      delete node;
+    }
+    node = next;
+  }
+}
+
+
+std::optional<timer_wheel::tick_type> timer_wheel::min_tick(task_node* list) const {
+  std::optional<tick_type> ret;
+  for (task_node* node = list; node; node = node->next) {
+    if (node->is_canceled()) {
+      continue;
+    }
+
+    tick_type tick = run_time_to_tick(node->tsk.run_time);
+    if (!ret || tick < *ret) {
+      ret = tick;
+    }
+  }
+  return ret;
+}
+
+std::optional<task::run_time_type> timer_wheel::compute_next_run_time() const {
+  if (expired_) {
+    return expired_->tsk.run_time;  // already due
+  }
+
+  if (!scheduled_count_) {
+    return std::nullopt;
+  }
+
+  // Every task on a level is due after all tasks on lower levels, and the slots of a level
+  // following the current one are in order of expiry - the first non-empty slot wins.
+  for (int level = 0; level < level_count; level++) {
+    for (tick_type slot = slot_index(current_tick_, level) + 1; slot < slot_count; slot++) {
+      if (auto tick = min_tick(slots_[level][slot])) {
+        return tick_to_run_time(*tick);
+      }
+    }
+  }
+
+  if (auto tick = min_tick(overflow_)) {
+    return tick_to_run_time(*tick);
+  }
+  return std::nullopt;  // everything left has been canceled
+}
+
+}  // namespace base::impl
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "base/event_loop/impl/delayed_task_queue.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace base::impl {
+
+// Hierarchical timer wheel with `level_count` levels of `slot_count` slots each. Level 0 holds
+// tasks due in the current block of `slot_count` ticks, one slot per tick; each slot of level
+// `k` covers a whole block of level `k - 1` and is cascaded down once that block becomes current.
+// Tasks too far in the future to fit in the top level are kept in an overflow list.
+//
+// Insertion and cancellation are O(1). Tasks are ordered only to the resolution of the wheel,
+// and never run before their run time.
+class timer_wheel : public delayed_task_queue {
+public:
+  explicit timer_wheel(task::delay_type resolution = std::chrono::milliseconds(1));
+  ~timer_wheel();
+
+  void push(task_node_ptr node) override;
+  task_node_ptr pop_due(const task::run_time_type& now) override;
+  std::optional<task::run_time_type> next_run_time() override;
+  void cancel(task_node* node) override;
+  void remove_canceled() override;
+  std::size_t size() const override { return scheduled_count_ + expired_count_; }
+  task_list take_all() override;
+
+private:
+  using tick_type = std::uint64_t;
+
+  static constexpr int level_bits = 6;
+  static constexpr int slot_count = 1 << level_bits;
+  static constexpr tick_type slot_mask = slot_count - 1;
+  static constexpr int level_count = 4;
+
+  static constexpr tick_type slot_index(tick_type tick, int level) {
+    return (tick >> (level * level_bits)) & slot_mask;
+  }
+
+  tick_type run_time_to_tick(const task::run_time_type& run_time) const;  // rounds up
+  tick_type now_to_tick(const task::run_time_type& now) const;  // rounds down
+  task::run_time_type tick_to_run_time(tick_type tick) const;
+
+  int level_of(task_node** list) const;  // `level_count` for the overflow list
+
+  void place(task_node* node);
+  void link(task_node* node, task_node** list);
+  void unlink(task_node* node);
+
+  void advance(tick_type target);
+  void cascade();
+  void replace_all(task_node** list);
+  void expire_all(task_node** list);
+
+  void remove_canceled(task_node** list);
+
+  std::optional<tick_type> min_tick(task_node* list) const;
+  std::optional<task::run_time_type> compute_next_run_time() const;
+
+  const task::run_time_type epoch_;
+  const task::delay_type resolution_;
+  tick_type current_tick_ = 0;
+
+  task_node* slots_[level_count][slot_count] = {};
+  task_node* overflow_ = nullptr;
+  std::size_t level_counts_[level_count + 1] = {};  // number of tasks on each level, and in overflow_
+  std::size_t scheduled_count_ = 0;  // number of tasks in slots_ and overflow_
+
+  // tasks that are already due, in expiry order
+  task_node* expired_ = nullptr;
+  task_node* expired_tail_ = nullptr;
+  std::size_t expired_count_ = 0;
+
+  std::optional<task::run_time_type> cached_next_run_time_;
+  bool next_run_time_valid_ = true;
+};
+
+}  // namespace base::impl
@@ -1,7 +1,11 @@
 #include "loop_task_runner.h"
 
 #include "base/assert.h"
+#include "base/event_loop/delayed_task_handle.h"
 #include "base/event_loop/event_loop.h"
+#include "base/event_loop/impl/timer_wheel.h"
+#include <algorithm>
+#include <thread>
 #include <utility>
 
 namespace base {
@@ -9,6 +13,16 @@ namespace {
 
 thread_local loop_task_runner::ptr current_runner;
 
+// delayed queues smaller than this are never swept for canceled tasks
+constexpr std::size_t min_sweep_size = 64;
+
+// after this many high priority tasks in a row, a pending normal task gets to run first
+constexpr int max_high_priority_streak = 8;
+
+std::size_t queue_index(task_priority priority) {
+  return static_cast<std::size_t>(priority);
+}
+
 }  // namespace
 
 void loop_task_runner::post_quit() {
@@ -25,6 +39,57 @@ void loop_task_runner::quit_now() {
 }
 
 
+void loop_task_runner::post_cancelable_task(task::callback_type callback, task::delay_type delay,
+  delayed_task_handle& handle, task_priority priority) {
+  ASSERT(current_runner.get() == this) << "Cancelable tasks must be posted from the runner's thread";
+
+  auto run_time = delay > task::delay_type::zero() ?
+    task::clock_type::now() + delay : task::run_time_type();
+
+  auto node = std::make_unique<impl::task_node>(task(std::move(callback), run_time, {}, priority));
+  handle.attach(this, node.get());
+
+  if (run_time == task::run_time_type()) {
+    // go through the incoming queue to preserve ordering with other tasks
+    if (incoming_tasks_[queue_index(priority)].push(std::move(node))) {
+      wake_loop();
+    }
+  } else {
+    schedule_delayed_task(std::move(node));  // we're on the right thread, so skip the incoming queue
+  }
+}
+
+
+void loop_task_runner::set_delayed_task_strategy(delayed_task_strategy strategy) {
+  ASSERT(current_runner.get() == this) << "Delayed task strategy must be set on the runner's thread";
+
+  impl::task_list nodes = delayed_tasks_->take_all();
+
+  switch (strategy) {
+  case delayed_task_strategy::heap:
+    delayed_tasks_ = std::make_unique<impl::delayed_task_heap>();
+    break;
+  case delayed_task_strategy::timer_wheel:
+    delayed_tasks_ = std::make_unique<impl::timer_wheel>();
+    break;
+  default:
+    NOTREACHED() << "Invalid delayed task strategy";
+  }
+
+  while (!nodes.empty()) {
+    auto node = nodes.pop();
+    if (!node->is_canceled()) {
+      delayed_tasks_->push(std::move(node));
+    }
+  }
+}
+
+
+bool loop_task_runner::runs_tasks_on_current_thread() const {
+  return current_runner.get() == this;
+}
+
+
 // static
 void loop_task_runner::init_for_this_thread() {
   current_runner = ptr(new loop_task_runner);
@@ -40,86 +105,172 @@ loop_task_runner::ptr loop_task_runner::current() {
 // PRIVATE
 
 void loop_task_runner::do_post_task(task&& tsk) {
-  bool was_empty;
-  {
-    std::scoped_lock hold(task_lock_);
+  auto& queue = incoming_tasks_[queue_index(tsk.priority)];
+  if (queue.push(std::make_unique<impl::task_node>(std::move(tsk)))) {
+    wake_loop();  // the loop only needs waking when a queue becomes non-empty
+  }
+}
 
-    was_empty = task_queue_.empty();
-    task_queue_.push(std::move(tsk));
+void loop_task_runner::do_post_tasks(std::vector<task>&& tasks) {
+  impl::task_list nodes[task_priority_count];
+  for (auto& tsk : tasks) {
+    nodes[queue_index(tsk.priority)].push(std::make_unique<impl::task_node>(std::move(tsk)));
   }
 
-  if (was_empty) {
-    std::scoped_lock hold_loop(loop_lock_);  // current_loop_ mustn't change until after wake_up
-    if (current_loop_) {
-      current_loop_->wake_up();
-    }
+  bool needs_wake = false;
+  for (int i = 0; i < task_priority_count; i++) {
+    needs_wake |= incoming_tasks_[i].push_all(std::move(nodes[i]));
+  }
+  if (needs_wake) {
+    wake_loop();
   }
 }
 
+void loop_task_runner::wake_loop() {
+  // Announce ourselves before loading current_loop_: set_loop won't return (and the old loop
+  // won't be destroyed) until every waker that could have seen the old value has finished.
+  active_wakers_.fetch_add(1);
+  if (event_loop* loop = current_loop_.load()) {
+    loop->wake_up();
+  }
+  active_wakers_.fetch_sub(1);
+}
 
-bool loop_task_runner::run_pending_task() {
-  while (true) {
-    swap_queues();
-    if (current_tasks_.empty()) {
-      break;  // no more tasks, not even in the incoming queue
-    }
 
-    while (!current_tasks_.empty()) {
-      task current_task = std::move(current_tasks_.front());
-      current_tasks_.pop();
+bool loop_task_runner::run_pending_task() {
+  // high priority tasks go first, but can't starve normal ones completely
+  bool normal_first = high_priority_streak_ >= max_high_priority_streak;
+  task_priority order[] = {task_priority::high, task_priority::normal};
+  if (normal_first) {
+    std::swap(order[0], order[1]);
+  }
 
-      if (current_task.run_time == task::run_time_type()) {
-        current_task.run();
-        return true;
-      }
-      delayed_tasks_.push(std::move(current_task));
+  for (task_priority priority : order) {
+    if (auto node = next_ready_task(priority)) {
+      high_priority_streak_ = priority == task_priority::high ? high_priority_streak_ + 1 : 0;
+      run_task_node(std::move(node));
+      return true;
     }
   }
 
+  high_priority_streak_ = 0;
   return false;
 }
 
 bool loop_task_runner::run_delayed_task() {
-  if (delayed_tasks_.empty()) {
+  auto next_run_time = delayed_tasks_->next_run_time();
+  if (!next_run_time) {
     return false;
   }
 
-  const task& current_task = delayed_tasks_.top();
-
-  if (current_task.run_time > cached_now_) {
-    if (current_task.run_time > (cached_now_ = task::clock_type::now())) {
+  if (*next_run_time > cached_now_) {
+    if (*next_run_time > (cached_now_ = task::clock_type::now())) {
       return false;
     }
   }
 
-  task tmp_task = std::move(const_cast<task&>(current_task));  // current_task will still be at the top
-  delayed_tasks_.pop();  // the task must be dequeued *before* running
-  tmp_task.run();
+  // the task must be dequeued *before* running
+  while (auto node = delayed_tasks_->pop_due(cached_now_)) {
+    if (node->is_canceled()) {
+      continue;  // may have been canceled by its token in the meantime
+    }
+
+    if (node->tsk.priority == task_priority::idle) {
+      // now just like any other idle task, which waits until there is nothing else to do
+      node->delayed = false;
+      node->tsk.run_time = task::run_time_type();
+      current_tasks_[queue_index(task_priority::idle)].push(std::move(node));
+      continue;
+    }
 
-  return true;
+    run_task_node(std::move(node));
+    return true;
+  }
+
+  return false;
+}
+
+bool loop_task_runner::run_idle_task() {
+  if (auto node = next_ready_task(task_priority::idle)) {
+    run_task_node(std::move(node));
+    return true;
+  }
+  return false;
 }
 
 
 std::optional<task::run_time_type> loop_task_runner::get_next_run_time() const {
-  if (delayed_tasks_.empty()) {
-    return std::nullopt;
+  return delayed_tasks_->next_run_time();
+}
+
+
+impl::task_node_ptr loop_task_runner::next_ready_task(task_priority priority) {
+  impl::task_list& tasks = current_tasks_[queue_index(priority)];
+
+  while (true) {
+    swap_queues(priority);
+    if (tasks.empty()) {
+      return nullptr;  // no more tasks, not even in the incoming queue
+    }
+
+    while (!tasks.empty()) {
+      auto node = tasks.pop();
+
+      if (node->is_canceled()) {
+        continue;
+      }
+
+      if (node->tsk.run_time == task::run_time_type()) {
+        return node;
+      }
+      schedule_delayed_task(std::move(node));
+    }
   }
+}
 
-  return delayed_tasks_.top().run_time;
+void loop_task_runner::swap_queues(task_priority priority) {
+  std::size_t index = queue_index(priority);
+  if (current_tasks_[index].empty()) {
+    current_tasks_[index] = incoming_tasks_[index].take_all();
+  }
 }
 
 
-void loop_task_runner::swap_queues() {
-  if (current_tasks_.empty()) {
-    std::scoped_lock hold(task_lock_);
-    task_queue_.swap(current_tasks_);
+void loop_task_runner::schedule_delayed_task(impl::task_node_ptr node) {
+  node->delayed = true;
+  delayed_tasks_->push(std::move(node));
+
+  // Tasks canceled through their token stay queued until they are due, so sweep them out every
+  // time the queue doubles in size, for amortized O(1) cost per task.
+  if (delayed_tasks_->size() >= next_sweep_size_) {
+    delayed_tasks_->remove_canceled();
+    next_sweep_size_ = std::max(min_sweep_size, 2 * delayed_tasks_->size());
+  }
+}
+
+void loop_task_runner::run_task_node(impl::task_node_ptr node) {
+  node->detach_handle();  // the task can no longer be canceled
+  node->tsk.run();
+}
+
+void loop_task_runner::cancel_task(impl::task_node* node) {
+  if (node->delayed) {
+    delayed_tasks_->cancel(node);
+  } else {
+    // the node is still in one of the incoming queues, which can't unlink it -
+    // it will be discarded once dequeued
+    node->cancel();
   }
 }
 
 
 void loop_task_runner::set_loop(event_loop* loop) {
-  std::scoped_lock hold(loop_lock_);
-  current_loop_ = loop;
+  current_loop_.store(loop);
+
+  // a concurrent poster may still be waking the previous loop
+  while (active_wakers_.load() > 0) {
+    std::this_thread::yield();
+  }
 }
 
 }  // namespace base
\ No newline at end of file
@@ -1,16 +1,25 @@
 #pragma once
 
+#include "base/event_loop/impl/delayed_task_queue.h"
+#include "base/event_loop/impl/task_queue.h"
 #include "base/non_copyable.h"
 #include "base/task_runner/task_runner.h"
+#include <atomic>
+#include <cstddef>
 #include <memory>
-#include <mutex>
 #include <optional>
-#include <queue>
+#include <vector>
 
 namespace base {
 
+class delayed_task_handle;
 class event_loop;
 
+enum class delayed_task_strategy {
+  heap,  // exact ordering, O(log n) insertion, canceled tasks linger until due
+  timer_wheel  // ordering to 1ms, O(1) insertion and cancellation
+};
+
 class loop_task_runner : public task_runner {
   friend event_loop;
 
@@ -22,33 +31,49 @@ public:
   void quit_now();
   void post_quit();
 
+  // Posts a task that can be canceled through `handle`. Must be called on the runner's thread.
+  void post_cancelable_task(task::callback_type callback, task::delay_type delay, delayed_task_handle& handle,
+    task_priority priority = task_priority::normal);
+
+  // Must be called on the runner's thread; already-posted delayed tasks are migrated.
+  void set_delayed_task_strategy(delayed_task_strategy strategy);
+
+  bool runs_tasks_on_current_thread() const override;
+
   static void init_for_this_thread();
   static ptr current();
 
 private:
-  using task_queue = std::queue<task>;
-  using delayed_task_queue = std::priority_queue<task>;
+  friend delayed_task_handle;
 
   void do_post_task(task&& tsk) override;
+  void do_post_tasks(std::vector<task>&& tasks) override;
+  void wake_loop();
 
   bool run_pending_task();
   bool run_delayed_task();
+  bool run_idle_task();
   std::optional<task::run_time_type> get_next_run_time() const;
 
-  void swap_queues();
+  impl::task_node_ptr next_ready_task(task_priority priority);
+  void swap_queues(task_priority priority);
+  void schedule_delayed_task(impl::task_node_ptr node);
+  void run_task_node(impl::task_node_ptr node);
+  void cancel_task(impl::task_node* node);
 
   void set_loop(event_loop* loop);
 
-  task_queue task_queue_;
-  std::mutex task_lock_;  // protects task_queue_
-
-  task_queue current_tasks_;  // to avoid locking the mutex every time, process tasks in batches
-  delayed_task_queue delayed_tasks_;
+  // one queue per task_priority
+  impl::incoming_task_queue incoming_tasks_[task_priority_count];
+  impl::task_list current_tasks_[task_priority_count];  // to avoid touching the shared queues every time, process tasks in batches
+  int high_priority_streak_ = 0;  // number of high priority tasks run in a row
+  std::unique_ptr<impl::delayed_task_queue> delayed_tasks_ = std::make_unique<impl::delayed_task_heap>();
+  std::size_t next_sweep_size_ = 0;  // size of delayed_tasks_ at which canceled tasks are next swept
 
   task::run_time_type cached_now_;  // make running more efficient when multiple tasks have to run now
 
-  event_loop* current_loop_ = nullptr;
-  std::mutex loop_lock_;  // prevents current_loop_ from changing while it is waking up
+  std::atomic<event_loop*> current_loop_ = nullptr;
+  std::atomic<int> active_wakers_ = 0;  // number of threads currently inside wake_loop
 };
 
-}  // namespace base
\ No newline at end of file
+}  // namespace base
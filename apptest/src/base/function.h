@@ -3,7 +3,9 @@
 #include "base/assert.h"
 #include "base/non_copyable.h"
 #include <cstddef>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <new>
 #include <type_traits>
 #include <utility>
@@ -11,86 +13,108 @@
 // base::function is similar in design and purpose to std::function,
 // but doesn't require copyability (and hence is move-only itself). It
 // is also noexcept movable/swappable, unlike std::function.
+//
+// base::basic_function additionally lets the user choose how many bytes
+// of callable are stored inline before falling back to the heap; the
+// type-erased operations live in a static table of function pointers
+// rather than in virtual functions of the stored object, and callables
+// which are trivially copyable are moved with a plain memcpy.
+//
+// base::function_ref is a non-owning reference to a callable, for
+// callbacks which are only called before the callee returns.
 
 namespace base {
 
-template<typename Sig>
-class function;
-
-
 namespace impl {
 
-constexpr int func_space_ptr_size = 7;  // base::function is 8 pointers total together with the impl_ pointer
-using func_space = std::aligned_union_t<func_space_ptr_size * sizeof(void*), std::max_align_t>;
+constexpr std::size_t func_default_inline_size = 7 * sizeof(void*);  // base::function is 8 pointers total together with the vtable pointer
 
-template<typename Impl>
-constexpr bool needs_heap =
-  sizeof(Impl) > sizeof(func_space)  // too big
-  || alignof(func_space) % alignof(Impl) != 0  // over-aligned
-  || !std::is_nothrow_move_constructible_v<Impl>;  // can't guarentee noexcept move/swap
+}  // namespace impl
 
+template<typename Sig, std::size_t InlineSize = impl::func_default_inline_size>
+class basic_function;
 
-template<typename Ret, typename... Args>
-struct func_impl_base {
-  // note: no virtual dtor due to destroy()
+template<typename Sig>
+using function = basic_function<Sig>;
 
-  virtual func_impl_base* move(void* space) noexcept = 0;
-  virtual void destroy() = 0;
+template<typename Sig>
+class function_ref;
 
-  virtual Ret call(Args&&... args) = 0;
-};
 
-template<typename F, typename Ret, typename... Args>
-class func_impl : public func_impl_base<Ret, Args...> {
-  template<typename G>
-  func_impl(G&& func) : func_(std::forward<G>(func)) {}
+namespace impl {
 
-public:
-  template<typename G>
-  static func_impl* create(G&& func, [[maybe_unused]] void* space);
+template<typename F, std::size_t InlineSize>
+constexpr bool func_needs_heap =
+  sizeof(F) > InlineSize  // too big
+  || alignof(std::max_align_t) % alignof(F) != 0  // over-aligned
+  || !std::is_nothrow_move_constructible_v<F>;  // can't guarentee noexcept move/swap
 
-  func_impl_base<Ret, Args...>* move(void* space) noexcept override;
-  void destroy() override;
+// whether a moved-to copy can be made by copying the bytes, leaving nothing to destroy in the source
+template<typename F>
+constexpr bool func_is_trivially_relocatable = std::is_trivially_copyable_v<F>;
 
-  Ret call(Args&&... args) override;
 
-private:
-  F func_;
+template<typename Ret, typename... Args>
+struct func_vtable {
+  using call_type = Ret(*)(void* space, Args&&... args);
+  using relocate_type = void(*)(void* to, void* from) noexcept;
+  using destroy_type = void(*)(void* space) noexcept;
+
+  call_type call;
+  relocate_type relocate;  // null if the space can just be copied
+  destroy_type destroy;  // null if there is nothing to destroy
 };
 
-template<typename F, typename Ret, typename... Args>
-template<typename G>
-func_impl<F, Ret, Args...>* func_impl<F, Ret, Args...>::create(G&& func, [[maybe_unused]] void* space) {
-  if constexpr (needs_heap<func_impl>) {
-    return new func_impl(std::forward<G>(func));
-  } else {
-    return new (space) func_impl(std::forward<G>(func));
+// operations on an `F` stored in the space of a basic_function, either directly or through a heap pointer
+template<typename F, bool Heap, typename Ret, typename... Args>
+struct func_ops {
+  using vtable_type = func_vtable<Ret, Args...>;
+
+  static F& get(void* space) {
+    if constexpr (Heap) {
+      return **static_cast<F**>(space);
+    } else {
+      return *std::launder(static_cast<F*>(space));
+    }
   }
-}
 
-template<typename F, typename Ret, typename... Args>
-func_impl_base<Ret, Args...>* func_impl<F, Ret, Args...>::move(void* space) noexcept {
-  ASSERT(!needs_heap<func_impl>) << "Attempting to move heap-allocated function into local space";
-  return new (space) func_impl(std::move(*this));
-}
+  template<typename G>
+  static void create(void* space, G&& func) {
+    if constexpr (Heap) {
+      new (space) F*(new F(std::forward<G>(func)));
+    } else {
+      new (space) F(std::forward<G>(func));
+    }
+  }
 
-template<typename F, typename Ret, typename... Args>
-void func_impl<F, Ret, Args...>::destroy() {
-  if constexpr (needs_heap<func_impl>) {
-    delete this;
-  } else {
-    this->~func_impl();
+  static Ret call(void* space, Args&&... args) {
+    if constexpr (std::is_void_v<Ret>) {
+      std::invoke(get(space), std::forward<Args>(args)...);  // discard return value (if any)
+    } else {
+      return std::invoke(get(space), std::forward<Args>(args)...);
+    }
   }
-}
 
-template<typename F, typename Ret, typename... Args>
-Ret func_impl<F, Ret, Args...>::call(Args&&... args) {
-  if constexpr (std::is_void_v<Ret>) {
-    std::invoke(func_, std::forward<Args>(args)...);  // discard return value (if any)
-  } else {
-    return std::invoke(func_, std::forward<Args>(args)...);
+  static void relocate(void* to, void* from) noexcept {
+    F& src = get(from);
+    new (to) F(std::move(src));
+    src.~F();
   }
-}
+
+  static void destroy(void* space) noexcept {
+    if constexpr (Heap) {
+      delete &get(space);
+    } else {
+      get(space).~F();
+    }
+  }
+
+  static constexpr vtable_type vtable = {
+    &call,
+    !Heap && !func_is_trivially_relocatable<F> ? &relocate : nullptr,  // heap pointers are always copied
+    Heap || !std::is_trivially_destructible_v<F> ? &destroy : nullptr
+  };
+};
 
 
 // nullness checks
@@ -100,8 +124,8 @@ constexpr bool func_is_null(const T&) {
   return false;
 }
 
-template<typename Sig>
-constexpr bool func_is_null(const function<Sig>& fn) {
+template<typename Sig, std::size_t InlineSize>
+constexpr bool func_is_null(const basic_function<Sig, InlineSize>& fn) {
   return !fn;
 }
 
@@ -123,73 +147,75 @@ constexpr bool func_is_null(Mem Class::* ptr) {
 }  // namespace impl
 
 
-template<typename Ret, typename... Args>
-class function<Ret(Args...)> : public non_copyable {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+class basic_function<Ret(Args...), InlineSize> : public non_copyable {
+  static_assert(InlineSize >= sizeof(void*), "The inline space must at least hold a heap pointer");
+
   template<typename F>
   using enable_if_compatible_impl = std::enable_if_t<
     std::is_invocable_r_v<Ret, F&, Args&&...>
-    && !std::is_same_v<F, function>
+    && !std::is_same_v<F, basic_function>
   >;
 
   template<typename F>
   using enable_if_compatible = enable_if_compatible_impl<std::decay_t<F>>;
-  
+
 public:
-  constexpr function() = default;
-  constexpr function(std::nullptr_t) {}
-  function(function&& rhs) noexcept;
-  
+  // whether a callable of type `F` is stored on the heap rather than inline
+  template<typename F>
+  static constexpr bool stored_on_heap = impl::func_needs_heap<std::decay_t<F>, InlineSize>;
+
+  constexpr basic_function() = default;
+  constexpr basic_function(std::nullptr_t) {}
+  basic_function(basic_function&& rhs) noexcept;
+
   template<typename F, typename = enable_if_compatible<F>>
-  function(F&& func);
-  
-  ~function() { reset(); }
-  
-  function& operator=(std::nullptr_t);
-  function& operator=(function&& rhs) noexcept;
-  
+  basic_function(F&& func);
+
+  ~basic_function() { reset(); }
+
+  basic_function& operator=(std::nullptr_t);
+  basic_function& operator=(basic_function&& rhs) noexcept;
+
   template<typename F, typename = enable_if_compatible<F>>
-  function& operator=(F&& func);
-  
+  basic_function& operator=(F&& func);
+
   void reset();
-  void swap(function& other) noexcept;
-  
+  void swap(basic_function& other) noexcept;
+
   Ret operator()(Args... args);
 
-  explicit operator bool() const { return !!impl_; }
-  
-private:
-  void* get_space() { return &space_; }
-  const void* get_space() const { return &space_; }
-  bool is_local() const { return impl_ == get_space(); }
+  explicit operator bool() const { return !!vtable_; }
 
+private:
   template<typename F>
   void set_from(F&& func);
-  void move_from(function&& rhs) noexcept;
+  void move_from(basic_function&& rhs) noexcept;
 
-  impl::func_space space_;
-  impl::func_impl_base<Ret, Args...>* impl_ = nullptr;
+  alignas(std::max_align_t) unsigned char space_[InlineSize];
+  const impl::func_vtable<Ret, Args...>* vtable_ = nullptr;
 };
 
 
-template<typename Ret, typename... Args>
-function<Ret(Args...)>::function(function&& rhs) noexcept {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+basic_function<Ret(Args...), InlineSize>::basic_function(basic_function&& rhs) noexcept {
   move_from(std::move(rhs));
 }
 
-template<typename Ret, typename... Args>
+template<typename Ret, typename... Args, std::size_t InlineSize>
 template<typename F, typename>
-function<Ret(Args...)>::function(F&& func) {
+basic_function<Ret(Args...), InlineSize>::basic_function(F&& func) {
   set_from(std::forward<F>(func));
 }
 
-template<typename Ret, typename... Args>
-function<Ret(Args...)>& function<Ret(Args...)>::operator=(std::nullptr_t) {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+auto basic_function<Ret(Args...), InlineSize>::operator=(std::nullptr_t) -> basic_function& {
   reset();
   return *this;
 }
 
-template<typename Ret, typename... Args>
-function<Ret(Args...)>& function<Ret(Args...)>::operator=(function&& rhs) noexcept {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+auto basic_function<Ret(Args...), InlineSize>::operator=(basic_function&& rhs) noexcept -> basic_function& {
   if (this != &rhs) {
     reset();
     move_from(std::move(rhs));
@@ -197,105 +223,178 @@ function<Ret(Args...)>& function<Ret(Args...)>::operator=(function&& rhs) noexce
   return *this;
 }
 
-template<typename Ret, typename... Args>
+template<typename Ret, typename... Args, std::size_t InlineSize>
 template<typename F, typename>
-function<Ret(Args...)>& function<Ret(Args...)>::operator=(F&& func) {
-  function(std::forward<F>(func)).swap(*this);
+auto basic_function<Ret(Args...), InlineSize>::operator=(F&& func) -> basic_function& {
+  basic_function(std::forward<F>(func)).swap(*this);
   return *this;
 }
 
 
-template<typename Ret, typename... Args>
-void function<Ret(Args...)>::reset() {
-  if (impl_) {
-    impl_->destroy();
-    impl_ = nullptr;
+template<typename Ret, typename... Args, std::size_t InlineSize>
+void basic_function<Ret(Args...), InlineSize>::reset() {
+  if (auto* vtable = std::exchange(vtable_, nullptr); vtable && vtable->destroy) {
+    vtable->destroy(space_);
   }
 }
 
-template<typename Ret, typename... Args>
-void function<Ret(Args...)>::swap(function& other) noexcept {
-  if (!is_local() && !other.is_local()) {
-    std::swap(impl_, other.impl_);  // both on heap - swap pointers
-  } else {
-    function tmp = std::move(other);  // three-way move
-    other = std::move(*this);
-    *this = std::move(tmp);
-  }
+template<typename Ret, typename... Args, std::size_t InlineSize>
+void basic_function<Ret(Args...), InlineSize>::swap(basic_function& other) noexcept {
+  basic_function tmp = std::move(other);  // three-way move, which is usually just copying the space
+  other = std::move(*this);
+  *this = std::move(tmp);
 }
 
 
-template<typename Ret, typename... Args>
-Ret function<Ret(Args...)>::operator()(Args... args) {
-  if (!impl_) {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+Ret basic_function<Ret(Args...), InlineSize>::operator()(Args... args) {
+  if (!vtable_) {
     throw std::bad_function_call();
   }
-  return impl_->call(std::forward<Args>(args)...);
+  return vtable_->call(space_, std::forward<Args>(args)...);
 }
 
 
 // PRIVATE
 
-template<typename Ret, typename... Args>
+template<typename Ret, typename... Args, std::size_t InlineSize>
 template<typename F>
-void function<Ret(Args...)>::set_from(F&& func) {
-  ASSERT(!impl_) << "This assumes that the function is empty";
+void basic_function<Ret(Args...), InlineSize>::set_from(F&& func) {
+  ASSERT(!vtable_) << "This assumes that the function is empty";
 
   if (impl::func_is_null(func)) {
     return;  // already empty
   }
 
-  using impl_type = impl::func_impl<std::decay_t<F>, Ret, Args...>;
+  using ops = impl::func_ops<std::decay_t<F>, stored_on_heap<F>, Ret, Args...>;
 
-  impl_ = impl_type::create(std::forward<F>(func), get_space());
+  ops::create(space_, std::forward<F>(func));
+  vtable_ = &ops::vtable;
 }
 
-template<typename Ret, typename... Args>
-void function<Ret(Args...)>::move_from(function&& rhs) noexcept {
-  ASSERT(!impl_) << "This assumes that the function is empty";
+template<typename Ret, typename... Args, std::size_t InlineSize>
+void basic_function<Ret(Args...), InlineSize>::move_from(basic_function&& rhs) noexcept {
+  ASSERT(!vtable_) << "This assumes that the function is empty";
 
   if (!rhs) {
     return;  // already empty
   }
 
-  if (rhs.is_local()) {
-    impl_ = rhs.impl_->move(get_space());  // stored locally - move target
+  if (rhs.vtable_->relocate) {
+    rhs.vtable_->relocate(space_, rhs.space_);
   } else {
-    impl_ = rhs.impl_;  // stored on heap - steal pointer
-    rhs.impl_ = nullptr;
+    std::memcpy(space_, rhs.space_, InlineSize);  // trivially relocatable or a heap pointer
   }
+  vtable_ = std::exchange(rhs.vtable_, nullptr);
 }
 
 
 // NONMEMBER
 
-template<typename Ret, typename... Args>
-inline void swap(function<Ret(Args...)>& lhs, function<Ret(Args...)>& rhs) noexcept {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+inline void swap(basic_function<Ret(Args...), InlineSize>& lhs, basic_function<Ret(Args...), InlineSize>& rhs) noexcept {
   lhs.swap(rhs);
 }
 
 
-template<typename Ret, typename... Args>
-bool operator==(const function<Ret(Args...)>& func, std::nullptr_t) {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+bool operator==(const basic_function<Ret(Args...), InlineSize>& func, std::nullptr_t) {
   return !func;
 }
 
-template<typename Ret, typename... Args>
-bool operator==(std::nullptr_t, const function<Ret(Args...)>& func) {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+bool operator==(std::nullptr_t, const basic_function<Ret(Args...), InlineSize>& func) {
   return !func;
 }
 
-template<typename Ret, typename... Args>
-bool operator!=(const function<Ret(Args...)>& func, std::nullptr_t) {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+bool operator!=(const basic_function<Ret(Args...), InlineSize>& func, std::nullptr_t) {
   return !!func;
 }
 
-template<typename Ret, typename... Args>
-bool operator!=(std::nullptr_t, const function<Ret(Args...)>& func) {
+template<typename Ret, typename... Args, std::size_t InlineSize>
+bool operator!=(std::nullptr_t, const basic_function<Ret(Args...), InlineSize>& func) {
   return !!func;
 }
 
 
+// FUNCTION_REF
+
+// A non-owning reference to a callable, which must outlive the function_ref; cheap to pass by value.
+// Meant for parameters which are only called before the callee returns, e.g.
+//   void for_each_child(function_ref<void(widget&)> callback);
+template<typename Ret, typename... Args>
+class function_ref<Ret(Args...)> {
+  template<typename F>
+  using enable_if_compatible = std::enable_if_t<
+    std::is_invocable_r_v<Ret, F&, Args&&...>
+    && !std::is_same_v<std::decay_t<F>, function_ref>
+  >;
+
+  // function pointers are referred to as the function itself
+  template<typename F>
+  using target_type = std::conditional_t<
+    std::is_pointer_v<std::decay_t<F>> && std::is_function_v<std::remove_pointer_t<std::decay_t<F>>>,
+    std::remove_pointer_t<std::decay_t<F>>,
+    std::remove_reference_t<F>
+  >;
+
+public:
+  template<typename F, typename = enable_if_compatible<F>>
+  function_ref(F&& func) noexcept;
+
+  Ret operator()(Args... args) const { return call_(target_, std::forward<Args>(args)...); }
+
+private:
+  // function pointers can't be stored as a `void*`
+  union target {
+    void* obj;
+    void (*func)();
+  };
+
+  template<typename T>
+  static T& get(target tgt);
+  template<typename T>
+  static Ret call(target tgt, Args&&... args);
+
+  target target_;
+  Ret (*call_)(target, Args&&...);
+};
+
+
+template<typename Ret, typename... Args>
+template<typename F, typename>
+function_ref<Ret(Args...)>::function_ref(F&& func) noexcept
+  : call_(&call<target_type<F>>) {
+  if constexpr (std::is_function_v<target_type<F>>) {
+    ASSERT(!impl::func_is_null(func)) << "Referencing a null function pointer";
+    target_.func = reinterpret_cast<void(*)()>(static_cast<target_type<F>*>(func));
+  } else {
+    target_.obj = const_cast<void*>(static_cast<const void*>(std::addressof(func)));
+  }
+}
+
+template<typename Ret, typename... Args>
+template<typename T>
+T& function_ref<Ret(Args...)>::get(target tgt) {
+  if constexpr (std::is_function_v<T>) {
+    return *reinterpret_cast<T*>(tgt.func);
+  } else {
+    return *static_cast<T*>(tgt.obj);
+  }
+}
+
+template<typename Ret, typename... Args>
+template<typename T>
+Ret function_ref<Ret(Args...)>::call(target tgt, Args&&... args) {
+  if constexpr (std::is_void_v<Ret>) {
+    std::invoke(get<T>(tgt), std::forward<Args>(args)...);  // discard return value (if any)
+  } else {
+    return std::invoke(get<T>(tgt), std::forward<Args>(args)...);
+  }
+}
+
+
 // DEDUCTION GUIDES
 
 namespace impl {
@@ -326,9 +425,9 @@ struct get_signature<Ret(T::*)(Args...) const &> {
 }  // namespace impl
 
 template<typename Ret, typename... Args>
-function(Ret(*)(Args...)) -> function<Ret(Args...)>;
+basic_function(Ret(*)(Args...)) -> basic_function<Ret(Args...)>;
 
 template<typename F>
-function(F) -> function<typename impl::get_signature<decltype(&F::operator())>::type>;
+basic_function(F) -> basic_function<typename impl::get_signature<decltype(&F::operator())>::type>;
 
 }  // namespace base
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "coroutine.h"
+
+#include "base/future/impl/core_alloc.h"
+
+namespace base {
+namespace impl {
+namespace {
+
+void* pool_allocate_frame(std::size_t size) {
+  return allocate_core(size, alignof(std::max_align_t));
+}
+
+void pool_free_frame(void* ptr, std::size_t size) {
+  free_core(ptr, size, alignof(std::max_align_t));
+}
+
+coroutine_frame_allocator frame_allocator = { pool_allocate_frame, pool_free_frame };
+
+}  // namespace
+
+
+void* allocate_coroutine_frame(std::size_t size) {
+  return frame_allocator.allocate(size);
+}
+
+void free_coroutine_frame(void* ptr, std::size_t size) noexcept {
+  frame_allocator.deallocate(ptr, size);
+}
+
+}  // namespace impl
+
+
+void set_coroutine_frame_allocator(coroutine_frame_allocator alloc) {
+  impl::frame_allocator = alloc;
+}
+
+}  // namespace base
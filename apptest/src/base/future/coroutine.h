@@ -0,0 +1,148 @@
+#pragma once
+
+#include "base/expected.h"
+#include "base/future/future.h"
+#include "base/task_runner/task_runner.h"
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#else
+#include <experimental/coroutine>  // MSVC with /await
+#endif
+
+// Coroutines may return base::future<T>, and may co_await any base::future rvalue (awaiting
+// consumes the future, so write `co_await std::move(fut)`). A coroutine starts running immediately
+// when called, and after each co_await resumes on the task runner it was running on when it
+// suspended (the same runner future::then would use). Resumption happens inline when the awaited
+// future is fulfilled on that runner's thread, and is posted otherwise.
+
+namespace base {
+
+struct coroutine_frame_allocator {
+  void* (*allocate)(std::size_t size);
+  void (*deallocate)(void* ptr, std::size_t size);
+};
+
+// Replaces the allocator used for coroutine frames (by default, the small-block pool used for
+// future cores). Must be called before any coroutine is started.
+void set_coroutine_frame_allocator(coroutine_frame_allocator alloc);
+
+
+namespace impl {
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+namespace coro = std;
+#else
+namespace coro = std::experimental;
+#endif
+
+void* allocate_coroutine_frame(std::size_t size);
+void free_coroutine_frame(void* ptr, std::size_t size) noexcept;
+
+
+template<typename T>
+class future_coro_promise_base {
+public:
+  future<T> get_return_object() {
+    return prom_.get_future();
+  }
+
+  coro::suspend_never initial_suspend() noexcept { return {}; }
+  coro::suspend_never final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() {
+    prom_.set_exception(std::current_exception());
+  }
+
+  // note: frames elided by the compiler (HALO) never reach these
+  static void* operator new(std::size_t size) {
+    return allocate_coroutine_frame(size);
+  }
+
+  static void operator delete(void* ptr, std::size_t size) noexcept {
+    free_coroutine_frame(ptr, size);
+  }
+
+protected:
+  promise<T> prom_;
+};
+
+template<typename T>
+class future_coro_promise : public future_coro_promise_base<T> {
+public:
+  void return_value(expected<T> val) {
+    this->prom_.set(std::move(val));
+  }
+};
+
+template<>
+class future_coro_promise<void> : public future_coro_promise_base<void> {
+public:
+  void return_void() {
+    prom_.set();
+  }
+};
+
+
+template<typename T>
+class future_awaiter {
+public:
+  explicit future_awaiter(future<T>&& fut);
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(coro::coroutine_handle<> handle);
+  T await_resume();
+
+private:
+  future<T> fut_;
+  expected<T> val_;
+};
+
+
+template<typename T>
+future_awaiter<T>::future_awaiter(future<T>&& fut)
+  : fut_(std::move(fut)) {
+  fut_.check_valid();
+}
+
+template<typename T>
+void future_awaiter<T>::await_suspend(coro::coroutine_handle<> handle) {
+  // the awaiter lives in the coroutine frame, which may be resumed (and even destroyed) before
+  // set_cont returns, so the future is moved out first
+  future<T> fut = std::move(fut_);
+  fut.set_cont([this, handle, runner = default_then_task_runner()](expected<T>&& val) mutable {
+    val_ = std::move(val);
+
+    if (auto strong_runner = runner.lock()) {
+      if (can_run_cont_inline(*strong_runner)) {
+        inline_cont_scope scope;
+        handle.resume();
+      } else {
+        strong_runner->post_task([handle]() mutable {
+          handle.resume();
+        });
+      }
+    } else {
+      handle.destroy();  // the coroutine's own future is abandoned
+    }
+  });
+}
+
+template<typename T>
+T future_awaiter<T>::await_resume() {
+  return std::move(val_).get();
+}
+
+}  // namespace impl
+
+
+template<typename T>
+impl::future_awaiter<T> operator co_await(future<T>&& fut) {
+  return impl::future_awaiter<T>(std::move(fut));
+}
+
+}  // namespace base
@@ -14,4 +14,9 @@ future_already_retrieved::future_already_retrieved()
   : future_error("Future already retrieved") {
 }
 
+
+continuation_canceled::continuation_canceled()
+  : future_error("Continuation canceled") {
+}
+
 }  // namespace base
\ No newline at end of file
@@ -30,4 +30,12 @@ public:
   future_already_retrieved();
 };
 
+
+// future-related
+
+class continuation_canceled : public future_error {
+public:
+  continuation_canceled();
+};
+
 }  // namespace base
\ No newline at end of file
@@ -1,11 +1,35 @@
 #include "future.h"
 
 #include "base/event_loop/loop_task_runner.h"
+#include "base/thread/thread_pool_task_runner.h"
 
 namespace base::impl {
+namespace {
+
+thread_local int inline_cont_depth = 0;
+
+}  // namespace
+
 
 std::weak_ptr<task_runner> default_then_task_runner() {
+  // continuations of work running in a thread pool stay in that pool
+  if (auto pool = thread_pool_task_runner::current()) {
+    return pool;
+  }
   return loop_task_runner::current();
 }
 
+
+bool can_run_cont_inline(const task_runner& runner) {
+  return inline_cont_depth < max_inline_cont_depth && runner.runs_tasks_on_current_thread();
+}
+
+inline_cont_scope::inline_cont_scope() {
+  ++inline_cont_depth;
+}
+
+inline_cont_scope::~inline_cont_scope() {
+  --inline_cont_depth;
+}
+
 }  // namespace base::impl
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "base/expected.h"
 #include "base/future/impl/core.h"
 #include "base/non_copyable.h"
+#include "base/task_runner/cancellation.h"
 #include "base/task_runner/task_runner.h"
 #include <functional>
 #include <memory>
@@ -44,12 +45,46 @@ struct unwrap_future<expected<T>> {
 // task runner used for posting future::then calls (may be different for different threads)
 std::weak_ptr<task_runner> default_then_task_runner();
 
+
+// maximum number of continuations run inline (see inline_if_current) nested on one stack, past
+// which they are posted instead
+constexpr int max_inline_cont_depth = 64;
+
+bool can_run_cont_inline(const task_runner& runner);
+
+class inline_cont_scope : public non_copy_movable {
+public:
+  inline_cont_scope();
+  ~inline_cont_scope();
+};
+
+
+// coroutine support, defined in base/future/coroutine.h
+template<typename T>
+class future_coro_promise;
+
+template<typename T>
+class future_awaiter;
+
+// grants combinators (see base/future/when.h) direct access to future continuations
+struct future_access;
+
 }  // namespace impl
 
 template<typename T>
 using unwrap_future_t = typename impl::unwrap_future<T>::inner_type;
 
 
+// Passed to future::then to run the continuation directly on the thread fulfilling the promise
+// when that thread already runs the target runner's tasks, saving a post and a loop wake-up. If
+// the future is already fulfilled, the continuation may run before `then` returns.
+struct inline_if_current_t {
+  explicit inline_if_current_t() = default;
+};
+
+inline constexpr inline_if_current_t inline_if_current{};
+
+
 template<typename T>
 class promise : public non_copyable {
 public:
@@ -96,8 +131,10 @@ inline void swap(promise<T>& lhs, promise<T>& rhs) noexcept {
 template<typename T>
 class future : public non_copyable {
 public:
-  template<typename T>
-  friend future<T> make_future(expected<T> val);
+  template<typename U>
+  friend future<U> make_future(expected<U> val);
+
+  using promise_type = impl::future_coro_promise<T>;  // allows coroutines to return future<T>
 
   future() = default;
   void swap(future& other) noexcept;
@@ -110,15 +147,36 @@ public:
     return then(impl::default_then_task_runner(), std::forward<Cont>(cont));
   }
 
+  // the continuation is skipped (failing the returned future with continuation_canceled) if
+  // `token` is canceled before it runs
+  template<typename Cont>
+  auto then(std::weak_ptr<task_runner> runner, cancellation_token token, Cont&& cont);
+
+  template<typename Cont>
+  auto then(cancellation_token token, Cont&& cont) {
+    return then(impl::default_then_task_runner(), std::move(token), std::forward<Cont>(cont));
+  }
+
+  template<typename Cont>
+  auto then(inline_if_current_t, std::weak_ptr<task_runner> runner, Cont&& cont);
+
+  template<typename Cont>
+  auto then(inline_if_current_t, Cont&& cont) {
+    return then(inline_if_current, impl::default_then_task_runner(), std::forward<Cont>(cont));
+  }
+
   bool is_valid() const { return !!core_; }
 
 private:
-  template<typename T>
+  template<typename U>
   friend class future;
 
-  template<typename T>
+  template<typename U>
   friend class promise;
 
+  friend impl::future_awaiter<T>;
+  friend impl::future_access;
+
   future(std::shared_ptr<impl::future_core<T>> core);
 
   void check_valid() const {
@@ -127,6 +185,9 @@ private:
     }
   }
 
+  template<typename Cont>
+  auto then_impl(std::weak_ptr<task_runner> runner, bool allow_inline, cancellation_token token, Cont&& cont);
+
   template<typename Cont>
   void set_cont(Cont&& cont);
 
@@ -145,7 +206,7 @@ inline void swap(future<T>& lhs, future<T>& rhs) noexcept {
 
 template<typename T>
 promise<T>::promise()
-  : core_(std::make_shared<impl::future_core<T>>()) {
+  : core_(impl::make_future_core<T>()) {
 }
 
 template<typename T>
@@ -293,6 +354,24 @@ void future<T>::swap(future& other) noexcept {
 template<typename T>
 template<typename Cont>
 auto future<T>::then(std::weak_ptr<task_runner> runner, Cont&& cont) {
+  return then_impl(std::move(runner), false, cancellation_token(), std::forward<Cont>(cont));
+}
+
+template<typename T>
+template<typename Cont>
+auto future<T>::then(std::weak_ptr<task_runner> runner, cancellation_token token, Cont&& cont) {
+  return then_impl(std::move(runner), false, std::move(token), std::forward<Cont>(cont));
+}
+
+template<typename T>
+template<typename Cont>
+auto future<T>::then(inline_if_current_t, std::weak_ptr<task_runner> runner, Cont&& cont) {
+  return then_impl(std::move(runner), true, cancellation_token(), std::forward<Cont>(cont));
+}
+
+template<typename T>
+template<typename Cont>
+auto future<T>::then_impl(std::weak_ptr<task_runner> runner, bool allow_inline, cancellation_token token, Cont&& cont) {
   check_valid();
 
   using result_type = typename impl::cont_call_info<Cont, T>::ret_type;
@@ -303,15 +382,33 @@ auto future<T>::then(std::weak_ptr<task_runner> runner, Cont&& cont) {
   set_cont([
     cont = std::forward<Cont>(cont),
     prom = std::move(prom),
-    runner = std::move(runner)
+    runner = std::move(runner),
+    allow_inline,
+    token = std::move(token)
   ](expected<T>&& val) mutable {
+    if (token.is_canceled()) {
+      prom.set_exception(continuation_canceled());
+      return;
+    }
+
     if (auto strong_runner = runner.lock()) {
+      if (allow_inline && impl::can_run_cont_inline(*strong_runner)) {
+        impl::inline_cont_scope scope;
+        impl::call_cont(prom, std::forward<Cont>(cont), std::move(val));
+        return;
+      }
+
       strong_runner->post_task([
         cont = std::forward<Cont>(cont),
         prom = std::move(prom),
-        val = std::move(val)
+        val = std::move(val),
+        token = std::move(token)
       ]() mutable {
-        impl::call_cont(prom, std::forward<Cont>(cont), std::move(val));
+        if (token.is_canceled()) {
+          prom.set_exception(continuation_canceled());
+        } else {
+          impl::call_cont(prom, std::forward<Cont>(cont), std::move(val));
+        }
       });
     }
   });
@@ -330,7 +427,7 @@ void future<T>::set_cont(Cont&& cont) {
 
 template<typename T>
 future<T> make_future(expected<T> val) {
-  auto core = std::make_shared<impl::future_core<T>>(std::move(val));
+  auto core = impl::make_future_core<T>(std::move(val));
   return future<T>(std::move(core));
 }
 
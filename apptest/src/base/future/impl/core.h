@@ -4,9 +4,11 @@
 #include "base/expected.h"
 #include "base/function.h"
 #include "base/future/exceptions.h"
+#include "base/future/impl/core_alloc.h"
 #include "base/non_copyable.h"
+#include <atomic>
 #include <exception>
-#include <mutex>
+#include <memory>
 
 namespace base::impl {
 
@@ -23,21 +25,36 @@ public:
   void fulfill(expected<T>&& val);
 
 private:
-  void call_cont(std::unique_lock<std::mutex> hold) noexcept;
+  // each side publishes its half (val_ or cont_) by setting its bit in state_; whichever side
+  // completes the pair is responsible for calling the continuation
+  enum state_bits {
+    fulfilled_bit = 1 << 0,
+    cont_set_bit = 1 << 1
+  };
+
+  void call_cont() noexcept;
 
   expected<T> val_;
   function<void(expected<T>&&)> cont_;
-  std::mutex lock_;  // protects val_, cont_
-
-  bool cont_set_ = false;
-  bool fulfilled_ = false;
+  std::atomic<int> state_ = 0;
 };
 
 
+template<typename T>
+std::shared_ptr<future_core<T>> make_future_core() {
+  return std::allocate_shared<future_core<T>>(core_allocator<future_core<T>>());
+}
+
+template<typename T>
+std::shared_ptr<future_core<T>> make_future_core(expected<T>&& val) {
+  return std::allocate_shared<future_core<T>>(core_allocator<future_core<T>>(), std::move(val));
+}
+
+
 template<typename T>
 future_core<T>::future_core(expected<T>&& val)
   : val_(std::move(val))
-  , fulfilled_(true) {
+  , state_(fulfilled_bit) {
 }
 
 template<typename T>
@@ -50,39 +67,32 @@ future_core<T>::~future_core() {
 template<typename T>
 template<typename Cont>
 void future_core<T>::set_cont(Cont&& cont) {
-  std::unique_lock hold(lock_);
-
-  ASSERT(!cont_set_) << "Future continuation already set";
+  ASSERT(!(state_.load(std::memory_order_relaxed) & cont_set_bit)) << "Future continuation already set";
   cont_ = std::forward<Cont>(cont);
-  cont_set_ = true;
 
-  call_cont(std::move(hold));
+  if (state_.fetch_or(cont_set_bit, std::memory_order_acq_rel) & fulfilled_bit) {
+    call_cont();
+  }
 }
 
 template<typename T>
 void future_core<T>::fulfill(expected<T>&& val) {
-  std::unique_lock hold(lock_);
-
-  ASSERT(!fulfilled_) << "Promise already fulfilled";
+  ASSERT(!(state_.load(std::memory_order_relaxed) & fulfilled_bit)) << "Promise already fulfilled";
   val_ = std::move(val);
-  fulfilled_ = true;
 
-  call_cont(std::move(hold));
+  if (state_.fetch_or(fulfilled_bit, std::memory_order_acq_rel) & cont_set_bit) {
+    call_cont();
+  }
 }
 
 
 // PRIVATE
 
 template<typename T>
-void future_core<T>::call_cont(std::unique_lock<std::mutex> hold) noexcept {
-  if (cont_set_ && fulfilled_) {
-    hold.unlock();
-
-    // at this point, it is safe to access cont_ and val_ without locking,
-    // since they are guaranteed not to be mutated elsewhere
-    cont_(std::move(val_));
-    val_.reset();
-  }
+void future_core<T>::call_cont() noexcept {
+  // both halves have been published, and nobody else will touch them from now on
+  cont_(std::move(val_));
+  val_.reset();
 }
 
-}  // namespace base::impl
\ No newline at end of file
+}  // namespace base::impl
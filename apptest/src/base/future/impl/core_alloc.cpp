@@ -0,0 +1,84 @@
+#include "core_alloc.h"
+
+#include <new>
+
+namespace base::impl {
+namespace {
+
+constexpr std::size_t size_granularity = 32;
+constexpr std::size_t size_class_count = 16;  // blocks of up to 512 bytes are cached
+constexpr int max_cached_blocks = 1024;  // per size class
+
+struct free_block {
+  free_block* next;
+};
+
+struct block_cache {
+  ~block_cache();
+
+  free_block* heads[size_class_count] = {};
+  int counts[size_class_count] = {};
+};
+
+thread_local bool cache_destroyed = false;  // cores may still be freed during thread exit
+thread_local block_cache cache;
+
+block_cache::~block_cache() {
+  cache_destroyed = true;
+
+  for (std::size_t size_class = 0; size_class < size_class_count; size_class++) {
+    while (free_block* block = heads[size_class]) {
+      heads[size_class] = block->next;
+      ::operator delete(block);
+    }
+  }
+}
+
+
+bool is_small(std::size_t size, std::size_t align) {
+  return size <= size_class_count * size_granularity && align <= alignof(std::max_align_t);
+}
+
+std::size_t get_size_class(std::size_t size) {
+  return (size + size_granularity - 1) / size_granularity - 1;
+}
+
+}  // namespace
+
+
+void* allocate_core(std::size_t size, std::size_t align) {
+  if (!is_small(size, align)) {
+    return ::operator new(size, std::align_val_t(align));
+  }
+
+  std::size_t size_class = get_size_class(size);
+  if (!cache_destroyed) {
+    if (free_block* block = cache.heads[size_class]) {
+      cache.heads[size_class] = block->next;
+      --cache.counts[size_class];
+      return block;
+    }
+  }
+
+  return ::operator new((size_class + 1) * size_granularity);
+}
+
+void free_core(void* ptr, std::size_t size, std::size_t align) noexcept {
+  if (!is_small(size, align)) {
+    ::operator delete(ptr, std::align_val_t(align));
+    return;
+  }
+
+  std::size_t size_class = get_size_class(size);
+  if (cache_destroyed || cache.counts[size_class] == max_cached_blocks) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  auto block = static_cast<free_block*>(ptr);
+  block->next = cache.heads[size_class];
+  cache.heads[size_class] = block;
+  ++cache.counts[size_class];
+}
+
+}  // namespace base::impl
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+namespace base::impl {
+
+// Small-block allocator backed by per-thread free lists, used for future cores and signal slots. Blocks may be
+// freed on any thread; they are then cached by that thread.
+void* allocate_core(std::size_t size, std::size_t align);
+void free_core(void* ptr, std::size_t size, std::size_t align) noexcept;
+
+
+template<typename T>
+class core_allocator {
+public:
+  using value_type = T;
+
+  core_allocator() = default;
+
+  template<typename U>
+  core_allocator(const core_allocator<U>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(allocate_core(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, std::size_t n) noexcept {
+    free_core(ptr, n * sizeof(T), alignof(T));
+  }
+};
+
+template<typename T, typename U>
+bool operator==(const core_allocator<T>&, const core_allocator<U>&) {
+  return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const core_allocator<T>&, const core_allocator<U>&) {
+  return false;
+}
+
+}  // namespace base::impl
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "base/assert.h"
+#include "base/expected.h"
+#include "base/future/future.h"
+#include "base/future/impl/core.h"
+#include "base/future/impl/core_alloc.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Combinators joining several futures. Each call allocates a single state block shared by all of
+// its inputs, which is also the core of the returned future; the inputs' continuations write their
+// results directly into it (on whichever thread fulfills them) and the last (for when_all) or first
+// (for when_any) one completes the returned future. Errors are not thrown, but reported through the per-input expected<T> results.
+
+namespace base {
+
+template<typename T>
+struct when_any_result {
+  std::size_t index;  // index of the first future to complete
+  expected<T> result;
+};
+
+
+namespace impl {
+
+struct future_access {
+  template<typename T>
+  static void check_valid(const future<T>& fut) {
+    fut.check_valid();
+  }
+
+  template<typename T, typename Cont>
+  static void set_cont(future<T>& fut, Cont&& cont) {
+    fut.set_cont(std::forward<Cont>(cont));
+  }
+
+  template<typename T>
+  static future<T> make_future(std::shared_ptr<future_core<T>> core) {
+    return future<T>(std::move(core));
+  }
+};
+
+
+template<typename T>
+constexpr bool is_future = unwrap_future<std::decay_t<T>>::is_future;
+
+
+// the states are the cores of the futures they complete
+template<typename Results>
+struct when_all_state : future_core<Results> {
+  explicit when_all_state(std::size_t count)
+    : remaining(count) {
+  }
+
+  void complete_one() {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      this->fulfill(std::move(results));
+    }
+  }
+
+  Results results;
+  std::atomic<std::size_t> remaining;
+};
+
+template<typename T>
+struct when_any_state : future_core<when_any_result<T>> {
+  void complete(std::size_t index, expected<T>&& val) {
+    if (!done.exchange(true, std::memory_order_acq_rel)) {
+      this->fulfill(when_any_result<T>{ index, std::move(val) });
+    }
+  }
+
+  std::atomic<bool> done = false;
+};
+
+
+template<typename State, typename T, std::size_t Index>
+void join_tuple_element(const std::shared_ptr<State>& state, future<T>& fut) {
+  future_access::set_cont(fut, [state](expected<T>&& val) {
+    std::get<Index>(state->results) = std::move(val);
+    state->complete_one();
+  });
+}
+
+template<typename State, typename... T, std::size_t... Indices>
+void join_tuple(const std::shared_ptr<State>& state, std::index_sequence<Indices...>, future<T>&... futs) {
+  (join_tuple_element<State, T, Indices>(state, futs), ...);
+}
+
+}  // namespace impl
+
+
+template<typename... T>
+future<std::tuple<expected<T>...>> when_all(future<T>... futs) {
+  using state_type = impl::when_all_state<std::tuple<expected<T>...>>;
+
+  (impl::future_access::check_valid(futs), ...);
+  if constexpr (sizeof...(T) == 0) {
+    return make_future(expected<std::tuple<>>(std::tuple<>()));
+  } else {
+    auto state = std::allocate_shared<state_type>(impl::core_allocator<state_type>(), sizeof...(T));
+    auto fut = impl::future_access::make_future<std::tuple<expected<T>...>>(state);
+    impl::join_tuple(state, std::index_sequence_for<T...>(), futs...);
+    return fut;
+  }
+}
+
+template<typename It, typename = std::enable_if_t<!impl::is_future<It>>>
+auto when_all(It first, It last) {
+  using value_type = unwrap_future_t<typename std::iterator_traits<It>::value_type>;
+  using state_type = impl::when_all_state<std::vector<expected<value_type>>>;
+
+  std::for_each(first, last, impl::future_access::check_valid<value_type>);
+
+  auto count = static_cast<std::size_t>(std::distance(first, last));
+  auto state = std::allocate_shared<state_type>(impl::core_allocator<state_type>(), count);
+  state->results.resize(count);
+  auto fut = impl::future_access::make_future<std::vector<expected<value_type>>>(state);
+
+  if (!count) {
+    state->fulfill(std::move(state->results));
+    return fut;
+  }
+
+  for (std::size_t i = 0; first != last; ++first, ++i) {
+    impl::future_access::set_cont(*first, [state, i](expected<value_type>&& val) {
+      state->results[i] = std::move(val);
+      state->complete_one();
+    });
+  }
+
+  return fut;
+}
+
+
+template<typename It, typename = std::enable_if_t<!impl::is_future<It>>>
+auto when_any(It first, It last) {
+  using value_type = unwrap_future_t<typename std::iterator_traits<It>::value_type>;
+  using state_type = impl::when_any_state<value_type>;
+
+  ASSERT(first != last) << "when_any requires at least one future";
+  std::for_each(first, last, impl::future_access::check_valid<value_type>);
+
+  auto state = std::allocate_shared<state_type>(impl::core_allocator<state_type>());
+  auto fut = impl::future_access::make_future<when_any_result<value_type>>(state);
+
+  for (std::size_t i = 0; first != last; ++first, ++i) {
+    impl::future_access::set_cont(*first, [state, i](expected<value_type>&& val) {
+      state->complete(i, std::move(val));
+    });
+  }
+
+  return fut;
+}
+
+template<typename T, typename... Rest>
+future<when_any_result<T>> when_any(future<T> first, future<Rest>... rest) {
+  static_assert((std::is_same_v<T, Rest> && ...), "when_any requires futures of the same type");
+
+  future<T> futs[] = { std::move(first), std::move(rest)... };
+  return when_any(std::begin(futs), std::end(futs));
+}
+
+}  // namespace base
@@ -0,0 +1,244 @@
+#include "binary_log.h"
+
+#include <charconv>
+#include <cstdio>
+
+namespace logging {
+namespace {
+
+constexpr char file_magic[4] = {'B', 'L', 'O', 'G'};
+constexpr std::uint32_t file_version = 1;
+
+// tags of the entries in the binary log stream
+enum class entry_tag : char {
+  site = 'S',  // u64 id, u8 level, i32 line, str file, str format, u8 arg count, u8 arg types[]
+  thread = 'T',  // u32 id, str name
+  message = 'M',  // u64 site id, u32 thread id, encoded args
+  text = 'L'  // str line
+};
+
+const char* level_name(level log_level) {
+  // note: this depends on the order of the values defined in logging::level
+  static constexpr const char* names[] = {"TRACE", "INFO", "WARN", "ERROR"};
+  return names[static_cast<std::underlying_type_t<level>>(log_level)];
+}
+
+template<typename T>
+void append_value(std::string& out, T val) {
+  out.append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+void append_string(std::string& out, std::string_view str) {
+  append_value(out, static_cast<std::uint32_t>(str.size()));
+  out += str;
+}
+
+template<typename T>
+void append_number(std::string& out, T val, int base = 10) {
+  char buf[24];
+  auto result = std::to_chars(std::begin(buf), std::end(buf), val, base);
+  out.append(buf, result.ptr);
+}
+
+void format_arg(std::string& out, impl::arg_type type, impl::byte_reader& args) {
+  using impl::arg_type;
+
+  switch (type) {
+  case arg_type::boolean:
+    out += args.read<char>() ? "true" : "false";
+    break;
+  case arg_type::character:
+    out += args.read<char>();
+    break;
+  case arg_type::int32:
+    append_number(out, args.read<std::int32_t>());
+    break;
+  case arg_type::uint32:
+    append_number(out, args.read<std::uint32_t>());
+    break;
+  case arg_type::int64:
+    append_number(out, args.read<std::int64_t>());
+    break;
+  case arg_type::uint64:
+    append_number(out, args.read<std::uint64_t>());
+    break;
+  case arg_type::float64: {
+    char buf[32];
+    int size = std::snprintf(buf, sizeof(buf), "%g", args.read<double>());  // same as the iostream default
+    out.append(buf, static_cast<std::size_t>(size));
+    break;
+  }
+  case arg_type::pointer:
+    out += "0x";
+    append_number(out, args.read<std::uint64_t>(), 16);
+    break;
+  case arg_type::string:
+    out += args.read_string();
+    break;
+  default:
+    throw std::runtime_error("Bad binary log argument type");
+  }
+}
+
+}  // namespace
+
+
+void binary_sink::write(const char* str) {
+  std::string entry;
+  impl::write_text_entry(entry, str);
+  write_binary(entry);
+}
+
+
+namespace impl {
+
+std::string_view byte_reader::read_bytes(std::size_t size) {
+  if (size > data_.size()) {
+    throw std::runtime_error("Truncated binary log");
+  }
+
+  std::string_view ret = data_.substr(0, size);
+  data_.remove_prefix(size);
+  return ret;
+}
+
+
+void format_message(std::string& out, const char* level_str, std::string_view thread, std::string_view file,
+    int line, std::string_view format, const arg_type* types, std::size_t arg_count, byte_reader& args) {
+  out += '[';
+  out += level_str;
+  out += "][thread ";
+  out += thread;
+  out += "][";
+  out += file;
+  out += ':';
+  append_number(out, line);
+  out += "] ";
+
+  std::size_t arg = 0;
+  for (std::size_t i = 0; i < format.size(); ++i) {
+    char c = format[i];
+    bool escaped = (c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c;
+
+    if (escaped) {
+      out += c;
+      ++i;
+    } else if (c == '{' && i + 1 < format.size() && format[i + 1] == '}' && arg < arg_count) {
+      format_arg(out, types[arg++], args);
+      ++i;
+    } else {
+      out += c;
+    }
+  }
+
+  // arguments without a placeholder still need to be consumed
+  std::string unused;
+  while (arg < arg_count) {
+    format_arg(unused, types[arg++], args);
+  }
+
+  out += '\n';
+}
+
+
+void write_file_header(std::string& out) {
+  out.append(file_magic, sizeof(file_magic));
+  append_value(out, file_version);
+}
+
+void write_site_entry(std::string& out, const call_site& site) {
+  out += static_cast<char>(entry_tag::site);
+  append_value(out, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&site)));
+  append_value(out, static_cast<std::uint8_t>(site.log_level));
+  append_value(out, static_cast<std::int32_t>(site.line));
+  append_string(out, site.file);
+  append_string(out, site.format);
+  append_value(out, static_cast<std::uint8_t>(site.arg_count));
+  out.append(reinterpret_cast<const char*>(site.arg_types), site.arg_count);
+}
+
+void write_thread_entry(std::string& out, std::uint32_t thread, std::string_view name) {
+  out += static_cast<char>(entry_tag::thread);
+  append_value(out, thread);
+  append_string(out, name);
+}
+
+void write_message_entry(std::string& out, const call_site& site, std::uint32_t thread, std::string_view args) {
+  out += static_cast<char>(entry_tag::message);
+  append_value(out, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&site)));
+  append_value(out, thread);
+  out += args;
+}
+
+void write_text_entry(std::string& out, std::string_view text) {
+  out += static_cast<char>(entry_tag::text);
+  append_string(out, text);
+}
+
+}  // namespace impl
+
+
+binary_log_reader::binary_log_reader(std::string_view data)
+  : reader_(data) {
+  if (reader_.read_bytes(sizeof(file_magic)) != std::string_view(file_magic, sizeof(file_magic))
+      || reader_.read<std::uint32_t>() != file_version) {
+    throw std::runtime_error("Not a binary log, or an unsupported version");
+  }
+}
+
+bool binary_log_reader::read_next(std::string& out) {
+  while (!reader_.empty()) {
+    switch (static_cast<entry_tag>(reader_.read<char>())) {
+    case entry_tag::site: {
+      auto id = reader_.read<std::uint64_t>();
+      auto log_level = reader_.read<std::uint8_t>();
+      if (log_level > static_cast<std::uint8_t>(level::error)) {
+        throw std::runtime_error("Bad binary log level");
+      }
+
+      site_info& site = sites_[id];
+      site.log_level = static_cast<level>(log_level);
+      site.line = reader_.read<std::int32_t>();
+      site.file = reader_.read_string();
+      site.format = reader_.read_string();
+
+      std::string_view types = reader_.read_bytes(reader_.read<std::uint8_t>());
+      auto* types_begin = reinterpret_cast<const impl::arg_type*>(types.data());
+      site.arg_types.assign(types_begin, types_begin + types.size());
+      break;
+    }
+
+    case entry_tag::thread: {
+      auto id = reader_.read<std::uint32_t>();
+      threads_[id] = reader_.read_string();
+      break;
+    }
+
+    case entry_tag::message: {
+      auto site_it = sites_.find(reader_.read<std::uint64_t>());
+      if (site_it == sites_.end()) {
+        throw std::runtime_error("Binary log message refers to an unknown call site");
+      }
+      const site_info& site = site_it->second;
+
+      auto thread_it = threads_.find(reader_.read<std::uint32_t>());
+      std::string_view thread = thread_it != threads_.end() ? thread_it->second : std::string_view();
+
+      impl::format_message(out, level_name(site.log_level), thread, site.file, site.line, site.format,
+        site.arg_types.data(), site.arg_types.size(), reader_);
+      return true;
+    }
+
+    case entry_tag::text:
+      out += reader_.read_string();
+      return true;
+
+    default:
+      throw std::runtime_error("Bad binary log entry");
+    }
+  }
+
+  return false;
+}
+
+}  // namespace logging
\ No newline at end of file
@@ -0,0 +1,266 @@
+#pragma once
+
+#include "base/logging/logging.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Logs a message whose formatting is deferred until it is written out; e.g.
+//   LOG_BINARY(info, "loaded {} glyphs in {}ms", count, elapsed);
+// Only the arguments are copied on the calling thread. Each {} in `FORMAT` (which must be a string
+// literal) is replaced by the next argument. Supported arguments are arithmetic types, enums, strings
+// and pointers.
+#define LOG_BINARY_FULL(LEVEL, FILE, LINE, FORMAT, ...) \
+  do { \
+    if constexpr (LOG_IS_COMPILED_IN(LEVEL)) { \
+      static ::logging::impl::site_filter log_site_filter_; \
+      if (!log_site_filter_.filter_out(::logging::level::LEVEL, FILE)) { \
+        using log_arg_list_ = decltype(::logging::impl::arg_list(__VA_ARGS__)); \
+        static constexpr ::logging::impl::call_site log_call_site_ = ::logging::impl::make_call_site( \
+          ::logging::level::LEVEL, FILE, LINE, FORMAT, static_cast<log_arg_list_*>(nullptr)); \
+        ::logging::impl::log_binary(log_call_site_, ##__VA_ARGS__); \
+      } \
+    } \
+  } while (false)
+
+#define LOG_BINARY(LEVEL, FORMAT, ...) LOG_BINARY_FULL(LEVEL, __FILE__, __LINE__, FORMAT, ##__VA_ARGS__)
+
+
+namespace logging {
+
+// Receives the binary log stream instead of formatted text. The stream starts with a header (see
+// impl::write_file_header) followed by entries; call sites and thread names are written once, before
+// the first message which refers to them, and messages only contain the raw argument bytes.
+// binary_log_reader decodes the stream back into text.
+struct binary_sink : sink {
+  // called with messages logged through LOG, which are stored as text entries
+  void write(const char* str) final;
+
+  // called on the logging thread with a batch of one or more complete entries
+  virtual void write_binary(std::string_view data) = 0;
+};
+
+
+namespace impl {
+
+// the first byte of each record in a log_buffer
+enum class record_kind : char {
+  text,  // a formatted line
+  binary,  // a call_site pointer followed by the encoded arguments
+  thread_name  // the name of the thread which owns the buffer
+};
+
+// how an argument is encoded; the numeric values are part of the file format
+enum class arg_type : std::uint8_t {
+  boolean = 0,  // 1 byte
+  character,  // 1 byte
+  int32,
+  uint32,
+  int64,
+  uint64,
+  float64,
+  pointer,  // uint64
+  string  // uint32 size followed by the characters
+};
+
+struct call_site {
+  level log_level;
+  const char* file;
+  int line;
+  const char* format;
+  const arg_type* arg_types;
+  std::size_t arg_count;
+};
+
+
+template<typename T>
+constexpr bool always_false = false;
+
+template<typename T>
+constexpr bool is_c_string = std::is_same_v<T, const char*> || std::is_same_v<T, char*>;
+
+template<typename T>
+constexpr arg_type arg_type_of() {
+  if constexpr (std::is_same_v<T, bool>) {
+    return arg_type::boolean;
+  } else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+    return arg_type::character;  // like iostreams, which print (u)int8_t as characters too
+  } else if constexpr (std::is_enum_v<T>) {
+    return arg_type_of<std::underlying_type_t<T>>();
+  } else if constexpr (std::is_integral_v<T>) {
+    if constexpr (sizeof(T) <= sizeof(std::int32_t)) {
+      return std::is_signed_v<T> ? arg_type::int32 : arg_type::uint32;
+    } else {
+      return std::is_signed_v<T> ? arg_type::int64 : arg_type::uint64;
+    }
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return arg_type::float64;
+  } else if constexpr (is_c_string<T> || std::is_convertible_v<const T&, std::string_view>) {
+    return arg_type::string;
+  } else if constexpr (std::is_pointer_v<T>) {
+    return arg_type::pointer;
+  } else {
+    static_assert(always_false<T>, "Unsupported LOG_BINARY argument type");
+  }
+}
+
+
+template<typename... Args>
+struct type_list {};
+
+// only used in decltype(), to name the (decayed) argument types
+template<typename... Args>
+type_list<std::decay_t<Args>...> arg_list(const Args&...);
+
+template<typename... Args>
+struct arg_types {
+  static constexpr arg_type value[sizeof...(Args) + 1] = {arg_type_of<Args>()..., arg_type::boolean};  // never empty
+};
+
+template<typename... Args>
+constexpr call_site make_call_site(level log_level, const char* file, int line, const char* format,
+    type_list<Args...>*) {
+  return {log_level, file, line, format, arg_types<Args...>::value, sizeof...(Args)};
+}
+
+
+template<typename T>
+std::string_view string_arg(const T& val) {
+  if constexpr (is_c_string<T>) {
+    return val ? std::string_view(val) : std::string_view("(null)");
+  } else {
+    return val;
+  }
+}
+
+template<typename T>
+std::size_t encoded_size(const T& val) {
+  constexpr arg_type type = arg_type_of<T>();
+
+  if constexpr (type == arg_type::boolean || type == arg_type::character) {
+    return 1;
+  } else if constexpr (type == arg_type::int32 || type == arg_type::uint32) {
+    return sizeof(std::uint32_t);
+  } else if constexpr (type == arg_type::string) {
+    return sizeof(std::uint32_t) + string_arg(val).size();
+  } else {
+    return sizeof(std::uint64_t);
+  }
+}
+
+template<typename T>
+void encode_value(char*& out, T val) {
+  std::memcpy(out, &val, sizeof(val));
+  out += sizeof(val);
+}
+
+template<typename T>
+void encode(char*& out, const T& val) {
+  constexpr arg_type type = arg_type_of<T>();
+
+  if constexpr (type == arg_type::boolean || type == arg_type::character) {
+    *out++ = static_cast<char>(val);
+  } else if constexpr (type == arg_type::int32) {
+    encode_value(out, static_cast<std::int32_t>(val));
+  } else if constexpr (type == arg_type::uint32) {
+    encode_value(out, static_cast<std::uint32_t>(val));
+  } else if constexpr (type == arg_type::int64) {
+    encode_value(out, static_cast<std::int64_t>(val));
+  } else if constexpr (type == arg_type::uint64) {
+    encode_value(out, static_cast<std::uint64_t>(val));
+  } else if constexpr (type == arg_type::float64) {
+    encode_value(out, static_cast<double>(val));
+  } else if constexpr (type == arg_type::pointer) {
+    encode_value(out, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(val)));
+  } else {
+    std::string_view str = string_arg(val);
+    encode_value(out, static_cast<std::uint32_t>(str.size()));
+    std::memcpy(out, str.data(), str.size());
+    out += str.size();
+  }
+}
+
+void push_binary_record(std::string_view record);  // defined in logging.cpp
+
+template<typename... Args>
+void log_binary(const call_site& site, const Args&... args) {
+  const call_site* site_ptr = &site;
+  std::size_t size = 1 + sizeof(site_ptr) + (encoded_size(args) + ... + 0);
+
+  char stack_data[256];
+  std::unique_ptr<char[]> heap_data;
+  char* data = size <= sizeof(stack_data) ? stack_data : (heap_data = std::make_unique<char[]>(size)).get();
+
+  char* out = data;
+  *out++ = static_cast<char>(record_kind::binary);
+  encode_value(out, site_ptr);
+  (encode(out, args), ...);
+
+  push_binary_record(std::string_view(data, size));
+}
+
+
+// bounds-checked reads from encoded data; throws std::runtime_error if there isn't enough left
+class byte_reader {
+public:
+  explicit byte_reader(std::string_view data) : data_(data) {}
+
+  bool empty() const { return data_.empty(); }
+
+  template<typename T>
+  T read() {
+    T val;
+    std::memcpy(&val, read_bytes(sizeof(val)).data(), sizeof(val));
+    return val;
+  }
+
+  std::string_view read_bytes(std::size_t size);
+  std::string_view read_string() { return read_bytes(read<std::uint32_t>()); }
+
+private:
+  std::string_view data_;
+};
+
+// appends "[LEVEL][thread THREAD][FILE:LINE] " followed by the formatted message and a newline
+void format_message(std::string& out, const char* level_str, std::string_view thread, std::string_view file,
+  int line, std::string_view format, const arg_type* types, std::size_t arg_count, byte_reader& args);
+
+// writers for the binary log stream
+void write_file_header(std::string& out);
+void write_site_entry(std::string& out, const call_site& site);
+void write_thread_entry(std::string& out, std::uint32_t thread, std::string_view name);
+void write_message_entry(std::string& out, const call_site& site, std::uint32_t thread, std::string_view args);
+void write_text_entry(std::string& out, std::string_view text);
+
+}  // namespace impl
+
+
+// Decodes a binary log stream into the same text LOG would have produced.
+class binary_log_reader {
+public:
+  explicit binary_log_reader(std::string_view data);  // throws std::runtime_error on a bad header
+
+  // appends the next message to `out`; returns false once the end of the stream has been reached
+  bool read_next(std::string& out);
+
+private:
+  struct site_info {
+    level log_level;
+    std::string_view file;
+    int line;
+    std::string_view format;
+    std::vector<impl::arg_type> arg_types;
+  };
+
+  impl::byte_reader reader_;
+  std::unordered_map<std::uint64_t, site_info> sites_;
+  std::unordered_map<std::uint32_t, std::string_view> threads_;
+};
+
+}  // namespace logging
\ No newline at end of file
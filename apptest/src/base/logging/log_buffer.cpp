@@ -0,0 +1,66 @@
+#include "log_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace logging::impl {
+namespace {
+
+std::size_t round_up_pow2(std::size_t val) {
+  std::size_t ret = 1;
+  while (ret < val) {
+    ret <<= 1;
+  }
+  return ret;
+}
+
+}  // namespace
+
+
+log_buffer::log_buffer(std::size_t capacity)
+  : mask_(round_up_pow2(std::max<std::size_t>(capacity, 64)) - 1) {
+  data_ = std::make_unique<char[]>(mask_ + 1);
+}
+
+
+bool log_buffer::try_push(std::string_view record) {
+  std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+  std::uint64_t head = head_.load(std::memory_order_acquire);
+
+  std::size_t needed = sizeof(size_type) + record.size();
+  if (needed > (mask_ + 1) - (tail - head)) {
+    return false;
+  }
+
+  auto size = static_cast<size_type>(record.size());
+  copy_in(tail, &size, sizeof(size));
+  copy_in(tail + sizeof(size), record.data(), record.size());
+  tail_.store(tail + needed, std::memory_order_release);
+  return true;
+}
+
+
+bool log_buffer::empty() const {
+  return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+}
+
+
+// PRIVATE
+
+void log_buffer::copy_in(std::uint64_t pos, const void* data, std::size_t size) {
+  std::size_t offset = pos & mask_;
+  std::size_t first = std::min(size, (mask_ + 1) - offset);
+
+  std::memcpy(&data_[offset], data, first);
+  std::memcpy(&data_[0], static_cast<const char*>(data) + first, size - first);
+}
+
+void log_buffer::copy_out(std::uint64_t pos, void* data, std::size_t size) const {
+  std::size_t offset = pos & mask_;
+  std::size_t first = std::min(size, (mask_ + 1) - offset);
+
+  std::memcpy(data, &data_[offset], first);
+  std::memcpy(static_cast<char*>(data) + first, &data_[0], size - first);
+}
+
+}  // namespace logging::impl
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "base/non_copyable.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace logging::impl {
+
+// Single-producer, single-consumer ring of log records. The owning thread appends records without
+// locking, while the draining thread consumes them in bulk.
+class log_buffer : public base::non_copy_movable {
+  using size_type = std::uint32_t;
+
+public:
+  explicit log_buffer(std::size_t capacity);  // rounded up to a power of 2
+
+  // whether a record of `size` bytes can ever fit
+  bool fits(std::size_t size) const { return size + sizeof(size_type) <= mask_ + 1; }
+
+  // producer side; fails if there isn't enough room for `record`
+  bool try_push(std::string_view record);
+
+  // consumer side; passes each available record to `consume` and returns whether there were any
+  template<typename F>
+  bool drain(F&& consume);
+  bool empty() const;
+
+  std::atomic<std::uint64_t> dropped = 0;  // records discarded because the buffer was full
+  std::atomic<bool> retired = false;  // set once the owning thread has exited
+
+private:
+  void copy_in(std::uint64_t pos, const void* data, std::size_t size);
+  void copy_out(std::uint64_t pos, void* data, std::size_t size) const;
+
+  std::unique_ptr<char[]> data_;
+  std::size_t mask_;
+  std::string scratch_;  // holds records which wrap around the end of data_
+
+  // monotonically increasing positions, taken modulo the capacity
+  alignas(64) std::atomic<std::uint64_t> head_ = 0;  // written by the consumer
+  alignas(64) std::atomic<std::uint64_t> tail_ = 0;  // written by the producer
+};
+
+
+template<typename F>
+bool log_buffer::drain(F&& consume) {
+  std::uint64_t head = head_.load(std::memory_order_relaxed);
+  std::uint64_t tail = tail_.load(std::memory_order_acquire);
+  if (head == tail) {
+    return false;
+  }
+
+  while (head != tail) {
+    size_type size;
+    copy_out(head, &size, sizeof(size));
+
+    std::size_t offset = (head + sizeof(size)) & mask_;
+    if (offset + size <= mask_ + 1) {
+      consume(std::string_view(&data_[offset], size));
+    } else {
+      scratch_.resize(size);
+      copy_out(head + sizeof(size), scratch_.data(), size);
+      consume(std::string_view(scratch_));
+    }
+
+    head += sizeof(size) + size;
+  }
+
+  head_.store(head, std::memory_order_release);
+  return true;
+}
+
+}  // namespace logging::impl
\ No newline at end of file
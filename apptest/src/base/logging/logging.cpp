@@ -1,21 +1,37 @@
 #include "logging.h"
 
+#include "base/assert.h"
+#include "base/auto_restore.h"
+#include "base/event_loop/event_loop.h"
+#include "base/event_loop/loop_task_runner.h"
+#include "base/logging/binary_log.h"
+#include "base/logging/log_buffer.h"
+#include "base/thread/thread.h"
 #include "base/thread/thread_name.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iterator>
 #include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
 #include <thread>
 #include <type_traits>
+#include <unordered_set>
+#include <vector>
 
 namespace {
 
-std::mutex logging_lock;
+using level_type = std::underlying_type_t<logging::level>;
 
 std::unique_ptr<logging::sink> logging_sink;
-logging::level min_logging_level;
 bool colorize_logging;
+logging::async_options logging_options;
 
 const char* level_to_string(logging::level log_level) {
-  using level_type = std::underlying_type_t<logging::level>;
-
   // maps [level log_level][bool color] to string
   // note: this depends on the order of the values defined in logging::level
   static constexpr const char* table[][2] = {
@@ -28,37 +44,504 @@ const char* level_to_string(logging::level log_level) {
   return table[static_cast<level_type>(log_level)][colorize_logging];
 }
 
+void write_prefix(std::ostream& out, logging::level log_level, const char* file, int line) {
+  out << "[" << level_to_string(log_level) << "][thread " << base::get_current_thread_name() << "]["
+    << file << ":" << line << "] ";
+}
+
+
+constexpr level_type level_off = static_cast<level_type>(logging::level::error) + 1;
+
+struct module_level {
+  std::string pattern;
+  bool match_path;  // whether the pattern is matched against the path instead of the name
+  level_type min_level;
+};
+
+std::mutex levels_lock;  // protects everything the minimum level of a file depends on
+level_type min_logging_level = level_off;  // off until there is a sink
+std::vector<module_level> module_levels;
+
+// matches `str` against `pattern`, where * matches any sequence of characters and ? any one character
+bool wildcard_match(std::string_view pattern, std::string_view str) {
+  std::size_t p = 0, s = 0;
+  std::size_t star = std::string_view::npos, star_s = 0;  // where to resume after a mismatch
+
+  while (s < str.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+      ++p;
+      ++s;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      star_s = s;
+    } else if (star != std::string_view::npos) {
+      p = star + 1;
+      s = ++star_s;
+    } else {
+      return false;
+    }
+  }
+
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+bool module_matches(const module_level& module, std::string_view path) {
+  if (!module.match_path) {
+    return wildcard_match(module.pattern, path.substr(path.find_last_of('/') + 1));
+  }
+
+  // try every suffix of the path which starts at a directory
+  for (std::size_t pos = 0;; ++pos) {
+    if (wildcard_match(module.pattern, path.substr(pos))) {
+      return true;
+    }
+
+    pos = path.find('/', pos);
+    if (pos == std::string_view::npos) {
+      return false;
+    }
+  }
+}
+
+level_type min_level_for(const char* file) {
+  std::scoped_lock hold(levels_lock);
+
+  if (module_levels.empty() || min_logging_level == level_off) {
+    return min_logging_level;
+  }
+
+  // normalize the path and drop the extension
+  std::string path = file;
+  std::replace(path.begin(), path.end(), '\\', '/');
+  std::size_t ext = path.find_last_of('.');
+  if (ext != std::string::npos && ext > path.find_last_of('/') + 1) {
+    path.resize(ext);
+  }
+
+  for (const auto& module : module_levels) {
+    if (module_matches(module, path)) {
+      return module.min_level;
+    }
+  }
+  return min_logging_level;
+}
+
+
+// minimal event loop for the logging thread, which has nothing to wait on but its own tasks
+class drain_loop : public base::event_loop {
+public:
+  void sleep(const base::task::delay_type* delay) override;
+  void wake_up() override;
+
+private:
+  std::mutex lock_;
+  std::condition_variable cv_;
+  bool woken_ = false;
+};
+
+void drain_loop::sleep(const base::task::delay_type* delay) {
+  std::unique_lock hold(lock_);
+  if (delay) {
+    cv_.wait_for(hold, *delay, [this] { return woken_; });
+  } else {
+    cv_.wait(hold, [this] { return woken_; });
+  }
+  woken_ = false;
+}
+
+void drain_loop::wake_up() {
+  {
+    std::scoped_lock hold(lock_);
+    woken_ = true;
+  }
+  cv_.notify_one();
+}
+
+
+// a thread's buffer, along with what the draining side knows about the thread
+struct thread_log {
+  thread_log(std::size_t capacity, std::uint32_t id) : buffer(capacity), id(id) {}
+
+  logging::impl::log_buffer buffer;
+  const std::uint32_t id;
+
+  // consumer side
+  std::string name;
+  bool name_written = false;  // whether the binary sink has been told the current name
+};
+
+using thread_log_ptr = std::shared_ptr<thread_log>;
+
+std::mutex logs_lock;  // protects thread_logs, only taken when threads start logging and when draining
+std::vector<thread_log_ptr> thread_logs;
+std::uint32_t next_thread_log_id = 0;  // protected by logs_lock
+
+std::mutex drain_lock;  // held while draining, as each buffer only supports a single consumer
+thread_local bool holds_drain_lock = false;
+std::string drain_batch;  // protected by drain_lock, as is everything below
+logging::binary_sink* binary_logging_sink = nullptr;  // logging_sink, if it wants the binary log stream
+std::unordered_set<const logging::impl::call_site*> written_sites;  // already sent to binary_logging_sink
+
+std::atomic<bool> drain_pending = false;
+std::unique_ptr<base::thread> drain_thread;
+base::loop_task_runner::ptr drain_runner;  // read from any thread, only through std::atomic_load
+
+
+void drain_text(std::string_view text) {
+  if (binary_logging_sink) {
+    logging::impl::write_text_entry(drain_batch, text);
+  } else {
+    drain_batch += text;
+  }
+}
+
+void drain_binary(thread_log& log, std::string_view record) {
+  using namespace logging::impl;
+
+  const call_site* site;
+  std::memcpy(&site, record.data(), sizeof(site));
+  record.remove_prefix(sizeof(site));
+
+  if (binary_logging_sink) {
+    if (!log.name_written) {
+      write_thread_entry(drain_batch, log.id, log.name);
+      log.name_written = true;
+    }
+    if (written_sites.insert(site).second) {
+      write_site_entry(drain_batch, *site);
+    }
+    write_message_entry(drain_batch, *site, log.id, record);
+  } else {
+    byte_reader args(record);
+    format_message(drain_batch, level_to_string(site->log_level), log.name, site->file, site->line, site->format,
+      site->arg_types, site->arg_count, args);
+  }
+}
+
+void drain_record(thread_log& log, std::string_view record) {
+  using logging::impl::record_kind;
+
+  auto kind = static_cast<record_kind>(record[0]);
+  record.remove_prefix(1);
+
+  switch (kind) {
+  case record_kind::text:
+    drain_text(record);
+    break;
+  case record_kind::binary:
+    drain_binary(log, record);
+    break;
+  case record_kind::thread_name:
+    log.name = record;
+    log.name_written = false;
+    break;
+  default:
+    NOTREACHED();
+  }
+}
+
+// writes out everything logged so far; the sink is flushed if `force` is set, and otherwise only
+// given a periodic flush after a batch
+void drain_all(bool force) {
+  std::scoped_lock hold(drain_lock);
+  base::auto_restore<bool> mark_held(holds_drain_lock, true);
+
+  {
+    std::scoped_lock hold_logs(logs_lock);
+
+    for (auto& log : thread_logs) {
+      log->buffer.drain([&log](std::string_view record) { drain_record(*log, record); });
+
+      if (auto dropped = log->buffer.dropped.exchange(0, std::memory_order_relaxed)) {
+        drain_text(std::string("[") + level_to_string(logging::level::warn) + "][logging] "
+          + std::to_string(dropped) + " messages dropped\n");
+      }
+    }
+
+    auto it = std::remove_if(thread_logs.begin(), thread_logs.end(), [](const thread_log_ptr& log) {
+      return log->buffer.retired.load(std::memory_order_acquire) && log->buffer.empty();
+    });
+    thread_logs.erase(it, thread_logs.end());
+  }
+
+  if (!drain_batch.empty() && logging_sink) {
+    if (binary_logging_sink) {
+      binary_logging_sink->write_binary(drain_batch);
+    } else {
+      logging_sink->write(drain_batch.c_str());
+    }
+    if (!force) {
+      logging_sink->periodic_flush();
+    }
+  }
+  drain_batch.clear();
+
+  // even if there was nothing new, as earlier periodic flushes may have left something out
+  if (force && logging_sink) {
+    logging_sink->flush();
+  }
+}
+
+// runs on the logging thread for as long as it lives
+void flush_periodically() {
+  std::chrono::milliseconds interval;
+  {
+    std::scoped_lock hold(drain_lock);
+    base::auto_restore<bool> mark_held(holds_drain_lock, true);
+    if (logging_sink) {
+      logging_sink->periodic_flush();
+    }
+    interval = logging_options.flush_interval;
+  }
+
+  base::loop_task_runner::current()->post_task(flush_periodically, interval);
+}
+
+void schedule_drain() {
+  // avoid the read-modify-write (and the cache line ping-pong) when a drain is already pending
+  if (drain_pending.load(std::memory_order_relaxed) || drain_pending.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+
+  auto runner = std::atomic_load(&drain_runner);
+  if (!runner) {
+    // nothing to drain on (logging is stopped); don't leave the flag set, or no drain would ever be scheduled
+    drain_pending.store(false, std::memory_order_release);
+    return;
+  }
+
+  runner->post_task([] {
+    drain_pending.store(false, std::memory_order_release);  // anything logged from now on needs another drain
+    drain_all(false);
+  });
+}
+
+
+struct thread_log_holder {
+  ~thread_log_holder();
+
+  thread_log_ptr log;
+  std::string published_name;  // the name in the last thread_name record pushed
+};
+
+thread_log_holder::~thread_log_holder() {
+  if (log) {
+    log->buffer.retired.store(true, std::memory_order_release);  // freed by the next drain
+    schedule_drain();
+  }
+}
+
+thread_local thread_log_holder current_log;
+
+logging::impl::log_buffer& get_current_buffer() {
+  if (!current_log.log) {
+    std::scoped_lock hold(logs_lock);
+    current_log.log = std::make_shared<thread_log>(logging_options.buffer_size, next_thread_log_id++);
+    thread_logs.push_back(current_log.log);
+  }
+  return current_log.log->buffer;
+}
+
+
+void push_record(std::string_view record) {
+  auto& buffer = get_current_buffer();
+
+  if (!buffer.try_push(record)) {
+    auto runner = std::atomic_load(&drain_runner);
+    bool can_block = logging_options.overflow == logging::overflow_policy::block
+      && buffer.fits(record.size())
+      && !(runner && runner->runs_tasks_on_current_thread());  // would never be drained
+
+    if (can_block) {
+      do {
+        schedule_drain();
+        std::this_thread::yield();
+      } while (!buffer.try_push(record));
+    } else if (logging_options.overflow != logging::overflow_policy::drop) {
+      buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  schedule_drain();
+}
+
+
+// stops the logging thread on exit, once everything has been written out
+struct drain_thread_stopper {
+  ~drain_thread_stopper();
+};
+
+drain_thread_stopper::~drain_thread_stopper() {
+  if (drain_thread) {
+    logging::flush();
+    std::atomic_store(&drain_runner, base::loop_task_runner::ptr());
+    drain_thread.reset();
+  }
+}
+
+drain_thread_stopper stopper;
+
 }  // namespace
 
 namespace logging {
 namespace impl {
 
-bool filter_out(level log_level) {
-  using level_type = std::underlying_type_t<level>;
+std::atomic<std::uint32_t> filter_generation = 1;
 
-  return !logging_sink || static_cast<level_type>(log_level) < static_cast<level_type>(min_logging_level);
+bool filter_out(level log_level, const char* file) {
+  return static_cast<level_type>(log_level) < min_level_for(file);
+}
+
+std::uint32_t site_filter::update(const char* file) {
+  // read the generation first, so that a concurrent change makes the next call look again
+  std::uint32_t generation = filter_generation.load(std::memory_order_acquire);
+  std::uint32_t state = (generation << 8) | min_level_for(file);
+
+  state_.store(state, std::memory_order_relaxed);
+  return state;
 }
 
 
 message::message(level log_level, const char* file, int line) {
-  stream_ << "[" << level_to_string(log_level) << "][thread " << base::get_current_thread_name() << "]["
-    << file << ":" << line << "] ";
+  stream_ << static_cast<char>(record_kind::text);
+  write_prefix(stream_, log_level, file, line);
 }
 
 message::~message() {
   stream_ << '\n';
-  {
-    std::scoped_lock hold(logging_lock);
-    logging_sink->write(stream_.str().c_str());
+  push_record(stream_.str());
+}
+
+
+void push_binary_record(std::string_view record) {
+  // binary records are formatted on the logging thread, which needs to know the thread's name;
+  // it's published again whenever the thread is renamed
+  const std::string& name = base::get_current_thread_name();
+  if (name != current_log.published_name) {
+    auto& buffer = get_current_buffer();
+
+    std::string name_record(1, static_cast<char>(record_kind::thread_name));
+    name_record += name;
+    if (buffer.try_push(name_record)) {  // retried with the next message if full
+      current_log.published_name = name;
+    }
   }
+
+  push_record(record);
+}
+
+
+void log_fatal(const char* file, int line, std::string_view text) {
+  if (!holds_drain_lock) {
+    LOG_FULL(error, file, line) << text;
+    flush();
+    return;
+  }
+
+  // this thread is draining (the failure happened in a sink, say), so pushing the message would
+  // never get it drained, and flushing would deadlock; write it to the sink directly instead, once
+  static thread_local bool written = false;
+  if (written || !logging_sink || filter_out(level::error, file)) {
+    return;
+  }
+  written = true;
+
+  std::ostringstream line_stream;
+  write_prefix(line_stream, level::error, file, line);
+  line_stream << text << '\n';
+
+  if (binary_logging_sink) {
+    std::string entry;
+    write_text_entry(entry, line_stream.str());
+    binary_logging_sink->write_binary(entry);
+  } else {
+    logging_sink->write(line_stream.str().c_str());
+  }
+  logging_sink->flush();
 }
 
 }  // namespace impl
 
-void init(std::unique_ptr<sink> sink, level min_level, bool colorize) {
-  logging_sink = std::move(sink);
-  min_logging_level = min_level;
-  colorize_logging = colorize;
+void init(std::unique_ptr<sink> sink, level min_level, bool colorize, async_options options) {
+  flush();  // anything already logged belongs to the old sink
+
+  // start the logging thread before enabling any level, so that every message logged gets drained
+  if (!drain_thread) {
+    drain_thread = std::make_unique<base::thread>([] { return std::make_unique<drain_loop>(); }, "Logging");
+    std::atomic_store(&drain_runner, drain_thread->task_runner());
+    drain_thread->task_runner()->post_task(flush_periodically, options.flush_interval);
+  }
+
+  {
+    std::scoped_lock hold(drain_lock);
+    logging_sink = std::move(sink);
+    colorize_logging = colorize;
+    logging_options = options;
+
+    binary_logging_sink = dynamic_cast<binary_sink*>(logging_sink.get());
+    written_sites.clear();
+
+    std::scoped_lock hold_logs(logs_lock);
+    for (auto& log : thread_logs) {
+      log->name_written = false;
+    }
+  }
+
+  {
+    std::scoped_lock hold(levels_lock);
+    min_logging_level = logging_sink ? static_cast<level_type>(min_level) : level_off;
+  }
+  impl::filter_generation.fetch_add(1, std::memory_order_release);
+}
+
+void flush() {
+  drain_all(true);
+}
+
+
+std::optional<level> parse_level(std::string_view str) {
+  static constexpr std::string_view names[] = {"trace", "info", "warn", "error"};
+
+  for (std::size_t i = 0; i < std::size(names); ++i) {
+    if (str == names[i] || (str.size() == 1 && static_cast<std::size_t>(str[0] - '0') == i)) {
+      return static_cast<level>(i);
+    }
+  }
+  return std::nullopt;
+}
+
+void set_module_levels(std::string_view spec) {
+  std::vector<module_level> levels;
+
+  while (!spec.empty()) {
+    std::string_view entry = spec.substr(0, spec.find(','));
+    spec.remove_prefix(std::min(entry.size() + 1, spec.size()));
+
+    std::size_t equals = entry.rfind('=');
+    std::string_view pattern = entry.substr(0, equals);
+    std::string_view level_str = equals != std::string_view::npos ? entry.substr(equals + 1) : "";
+
+    auto min_level = parse_level(level_str);
+    if (pattern.empty() || (!min_level && level_str != "off")) {
+      LOG(warn) << "Ignoring bad module level \"" << entry << "\"";
+      continue;
+    }
+
+    module_level& module = levels.emplace_back();
+    module.pattern = pattern;
+    std::replace(module.pattern.begin(), module.pattern.end(), '\\', '/');
+    module.match_path = module.pattern.find('/') != std::string::npos;
+    module.min_level = min_level ? static_cast<level_type>(*min_level) : level_off;
+  }
+
+  {
+    std::scoped_lock hold(levels_lock);
+    module_levels = std::move(levels);
+  }
+  impl::filter_generation.fetch_add(1, std::memory_order_release);
 }
 
 }  // namespace logging
\ No newline at end of file
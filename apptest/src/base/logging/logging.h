@@ -1,12 +1,32 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <sstream>
+#include <string_view>
 
-#define LOG_FULL(LEVEL, FILE, LINE) ::logging::impl::filter_out(logging::level::LEVEL) ? (void) 0 : \
-  ::logging::impl::msg_voidify() | ::logging::impl::message(logging::level::LEVEL, FILE, LINE)
+// LOG statements below this level (see logging::level for the values) are compiled out
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
 
-#define LOG(LEVEL) LOG_FULL(LEVEL, __FILE__, __LINE__)
+#define LOG_IS_COMPILED_IN(LEVEL) (static_cast<int>(::logging::level::LEVEL) >= LOG_MIN_LEVEL)
+
+#define LOG_FULL(LEVEL, FILE, LINE) \
+  !LOG_IS_COMPILED_IN(LEVEL) || ::logging::impl::filter_out(::logging::level::LEVEL, FILE) ? (void) 0 : \
+  ::logging::impl::msg_voidify() | ::logging::impl::message(::logging::level::LEVEL, FILE, LINE)
+
+// unlike LOG_FULL, the level which applies to the file is only looked up once per call site
+#define LOG(LEVEL) \
+  !LOG_IS_COMPILED_IN(LEVEL) || LOG_SITE_FILTER().filter_out(::logging::level::LEVEL, __FILE__) ? (void) 0 : \
+  ::logging::impl::msg_voidify() | ::logging::impl::message(::logging::level::LEVEL, __FILE__, __LINE__)
+
+#define LOG_SITE_FILTER() \
+  []() -> ::logging::impl::site_filter& { static ::logging::impl::site_filter filter; return filter; }()
 
 
 namespace logging {
@@ -21,7 +41,27 @@ enum class level {
 
 namespace impl {
 
-bool filter_out(level level);
+bool filter_out(level level, const char* file);
+
+// bumped whenever the levels change, which makes every site_filter look up its level again
+extern std::atomic<std::uint32_t> filter_generation;
+
+// caches the minimum level for a single call site
+class site_filter {
+public:
+  bool filter_out(level log_level, const char* file) {
+    std::uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state >> 8) != filter_generation.load(std::memory_order_relaxed)) {
+      state = update(file);
+    }
+    return static_cast<std::uint32_t>(log_level) < (state & 0xff);
+  }
+
+private:
+  std::uint32_t update(const char* file);
+
+  std::atomic<std::uint32_t> state_ = 0;  // generation << 8 | minimum level
+};
 
 
 class message {
@@ -44,14 +84,55 @@ struct msg_voidify {
   void operator|(const message&) {}
 };
 
+// For failed assertions: logs `text` as an error and writes out everything logged so far. Unlike
+// flush(), also works when called while draining (from a sink, say), where it would deadlock.
+void log_fatal(const char* file, int line, std::string_view text);
+
 }  // namespace impl
 
 struct sink {
   virtual ~sink() = default;
 
+  // called on the logging thread with a batch of one or more complete lines
   virtual void write(const char* str) = 0;
+
+  // writes out everything written so far; called by logging::flush() and when logging stops
+  virtual void flush() {}
+
+  // called on the logging thread after each batch, and every async_options::flush_interval even
+  // when nothing is logged; sinks which are expensive to flush may rate limit it here
+  virtual void periodic_flush() { flush(); }
+};
+
+
+// what to do when a thread logs faster than its buffer is drained
+enum class overflow_policy {
+  drop,  // discard the message
+  block,  // wait for the buffer to be drained
+  count  // discard the message, and report the number of discarded messages once there is room
 };
 
-void init(std::unique_ptr<sink> sink, level min_level, bool colorize);
+struct async_options {
+  std::size_t buffer_size = 64 * 1024;  // per thread
+  overflow_policy overflow = overflow_policy::count;
+  std::chrono::milliseconds flush_interval = std::chrono::seconds(1);  // of the periodic flush
+};
+
+// Messages are formatted by the thread logging them and appended to its own buffer without
+// locking; the buffers are drained by a background thread which writes to `sink` in batches.
+void init(std::unique_ptr<sink> sink, level min_level, bool colorize, async_options options = {});
+
+// writes out all messages logged so far and flushes the sink
+void flush();
+
+// accepts the level names in lower case, or their values
+std::optional<level> parse_level(std::string_view str);
+
+// Overrides the minimum level for the files matching a pattern, from a comma separated list of
+// `pattern=level` entries (where level can also be "off"), e.g. "gfx/*=warn,timer=trace". Patterns
+// containing a slash are matched against the end of the file's path, and other patterns against its
+// name; both without the extension. `*` and `?` are wildcards, and the first matching entry wins.
+// Replaces any previous overrides.
+void set_module_levels(std::string_view spec);
 
 }  // namespace logging
\ No newline at end of file
@@ -1,7 +1,13 @@
 #include "logging_sinks.h"
 
 #include "base/unicode.h"
+#include "base/win/last_error.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
 #include <Windows.h>
 
 namespace logging {
@@ -15,9 +21,202 @@ void file_sink::write(const char* str) {
   file_ << str;
 }
 
+void file_sink::flush() {
+  file_.flush();
+}
+
+
+mapped_file_sink::mapped_file_sink(std::filesystem::path name, const mapped_file_options& options)
+  : name_(std::move(name)), options_(options) {
+  std::vector<std::uint64_t> segments = find_segments();
+  index_ = segments.empty() ? 0 : segments.back();
+
+  // keep the newest max_segments - 1, making room for the one about to be opened; rotating only
+  // removes the oldest segment, which would leave behind those of runs with a larger max_segments
+  std::error_code ec;
+  for (std::uint64_t index : segments) {
+    if (index_ + 1 - index >= options_.max_segments) {
+      std::filesystem::remove(segment_path(index), ec);
+    }
+  }
+
+  open_segment();
+}
+
+mapped_file_sink::~mapped_file_sink() {
+  close_segment();
+}
+
+void mapped_file_sink::write(const char* str) {
+  std::string_view data(str);
+
+  while (view_ && data.size() > options_.segment_size - pos_) {
+    // split at the last line which still fits, unless not even one line fits in an empty segment
+    std::size_t split = data.substr(0, options_.segment_size - pos_).find_last_of('\n');
+    if (split != std::string_view::npos) {
+      split += 1;
+    } else if (pos_ == 0) {
+      split = options_.segment_size;
+    } else {
+      split = 0;
+    }
+
+    append(data.substr(0, split));
+    data.remove_prefix(split);
+    rotate();
+  }
+
+  if (view_) {
+    append(data);
+  }
+}
+
+void mapped_file_sink::flush() {
+  if (view_ && pos_ != flushed_pos_) {
+    ::FlushViewOfFile(view_ + flushed_pos_, pos_ - flushed_pos_);
+    flushed_pos_ = pos_;
+  }
+  last_flush_ = std::chrono::steady_clock::now();
+}
+
+void mapped_file_sink::periodic_flush() {
+  // the data is safe from crashes of the process as soon as it's in the mapping, so only flushing
+  // to disk needs to be rate limited
+  if (std::chrono::steady_clock::now() - last_flush_ >= options_.flush_interval) {
+    flush();
+  }
+}
+
+
+// PRIVATE
+
+std::filesystem::path mapped_file_sink::segment_path(std::uint64_t index) const {
+  std::filesystem::path ret = name_;
+  ret.replace_filename(name_.stem().native() + L"." + std::to_wstring(index) + name_.extension().native());
+  return ret;
+}
+
+std::vector<std::uint64_t> mapped_file_sink::find_segments() const {
+  std::wstring prefix = name_.stem().native() + L".";
+  std::wstring suffix = name_.extension().native();
+
+  std::filesystem::path dir = name_.parent_path();
+  std::error_code ec;
+  std::vector<std::uint64_t> indices;
+
+  for (const auto& entry : std::filesystem::directory_iterator(dir.empty() ? std::filesystem::path(".") : dir, ec)) {
+    std::wstring file_name = entry.path().filename().native();
+    if (file_name.size() <= prefix.size() + suffix.size()
+        || file_name.compare(0, prefix.size(), prefix) != 0
+        || file_name.compare(file_name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+      continue;
+    }
+
+    std::wstring index = file_name.substr(prefix.size(), file_name.size() - prefix.size() - suffix.size());
+    if (std::all_of(index.begin(), index.end(), [](wchar_t c) { return c >= L'0' && c <= L'9'; })) {
+      indices.push_back(std::stoull(index));
+    }
+  }
+
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
+
+void mapped_file_sink::append(std::string_view data) {
+  std::memcpy(view_ + pos_, data.data(), data.size());
+  pos_ += data.size();
+}
+
+void mapped_file_sink::rotate() {
+  close_segment();
+
+  try {
+    open_segment();
+  } catch (const std::system_error&) {
+    // there is nowhere to report this, as this is the sink; drop messages until the next run
+  }
+}
+
+void mapped_file_sink::open_segment() {
+  ++index_;
+
+  std::error_code ec;
+  std::filesystem::remove(segment_path(index_ - std::min<std::uint64_t>(index_, options_.max_segments)), ec);
+
+  file_.set(::CreateFileW(
+    segment_path(index_).c_str(),
+    GENERIC_READ | GENERIC_WRITE,
+    FILE_SHARE_READ | FILE_SHARE_DELETE,
+    nullptr,
+    CREATE_ALWAYS,
+    FILE_ATTRIBUTE_NORMAL,
+    nullptr
+  ));
+  if (!file_) {
+    base::win::throw_last_error("Failed to create log segment");
+  }
+
+  // mapping the file past its end pre-allocates it, zero-filled
+  ULARGE_INTEGER size;
+  size.QuadPart = options_.segment_size;
+  mapping_.set(::CreateFileMappingW(file_.get(), nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr));
+  if (!mapping_) {
+    base::win::throw_last_error("Failed to map log segment");
+  }
+
+  view_ = static_cast<char*>(::MapViewOfFile(mapping_.get(), FILE_MAP_WRITE, 0, 0, options_.segment_size));
+  if (!view_) {
+    base::win::throw_last_error("Failed to map log segment");
+  }
+
+  last_flush_ = std::chrono::steady_clock::now();
+}
+
+void mapped_file_sink::close_segment() {
+  if (view_) {
+    ::FlushViewOfFile(view_, pos_);
+    ::UnmapViewOfFile(view_);
+    view_ = nullptr;
+  }
+  mapping_.release();
+
+  if (file_) {
+    // trim the pre-allocated space which was never used
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(pos_);
+    ::SetFilePointerEx(file_.get(), size, nullptr, FILE_BEGIN);
+    ::SetEndOfFile(file_.get());
+    file_.release();
+  }
+
+  pos_ = 0;
+  flushed_pos_ = 0;
+}
+
+
+binary_file_sink::binary_file_sink(const std::filesystem::path& name)
+  : file_(name, std::ios::binary) {
+  std::string header;
+  impl::write_file_header(header);
+  write_binary(header);
+}
+
+void binary_file_sink::write_binary(std::string_view data) {
+  file_.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+void binary_file_sink::flush() {
+  file_.flush();
+}
+
 
 void stdout_sink::write(const char* str) {
-  std::cout << str << std::flush;
+  std::cout << str;
+}
+
+void stdout_sink::flush() {
+  std::cout.flush();
 }
 
 
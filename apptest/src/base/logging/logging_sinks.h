@@ -1,9 +1,14 @@
 #pragma once
 
+#include "base/logging/binary_log.h"
 #include "base/logging/logging.h"
+#include "base/win/scoped_handle.h"
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <string_view>
+#include <vector>
 
 namespace logging {
 
@@ -12,6 +17,63 @@ public:
   explicit file_sink(const std::filesystem::path& name);
 
   void write(const char* str) override;
+  void flush() override;
+
+private:
+  std::ofstream file_;
+};
+
+
+struct mapped_file_options {
+  std::size_t segment_size = 16 * 1024 * 1024;
+  std::size_t max_segments = 8;  // the oldest segments are deleted beyond this
+  std::chrono::milliseconds flush_interval = std::chrono::seconds(1);  // how often periodic flushes go to disk
+};
+
+// Appends to pre-allocated, memory mapped segment files named like `name` with an increasing index
+// before the extension (log.txt -> log.1.txt, log.2.txt...), moving on to a new segment once the
+// current one is full. Numbering continues after the segments left by previous runs.
+// Everything written before a crash of the process is still in the mapping, and ends up in the file;
+// such a segment is still full size, with the unused remainder zero-filled. Segments are truncated
+// to their contents when closed normally.
+class mapped_file_sink : public sink {
+public:
+  explicit mapped_file_sink(std::filesystem::path name, const mapped_file_options& options = {});
+  ~mapped_file_sink();
+
+  void write(const char* str) override;
+  void flush() override;
+  void periodic_flush() override;
+
+private:
+  std::filesystem::path segment_path(std::uint64_t index) const;
+  std::vector<std::uint64_t> find_segments() const;  // the indices of the existing segments, in order
+
+  void append(std::string_view data);
+  void rotate();
+  void open_segment();
+  void close_segment();
+
+  std::filesystem::path name_;
+  mapped_file_options options_;
+  std::uint64_t index_ = 0;  // of the current segment
+
+  base::win::scoped_handle file_;
+  base::win::scoped_handle mapping_;
+  char* view_ = nullptr;  // null if the segment couldn't be opened, in which case writes are dropped
+  std::size_t pos_ = 0;
+  std::size_t flushed_pos_ = 0;
+  std::chrono::steady_clock::time_point last_flush_;
+};
+
+
+// writes the binary log stream of LOG_BINARY messages, which logdecode turns back into text
+class binary_file_sink : public binary_sink {
+public:
+  explicit binary_file_sink(const std::filesystem::path& name);
+
+  void write_binary(std::string_view data) override;
+  void flush() override;
 
 private:
   std::ofstream file_;
@@ -21,6 +83,7 @@ private:
 class stdout_sink : public sink {
 public:
   void write(const char* str) override;
+  void flush() override;
 };
 
 
@@ -0,0 +1,120 @@
+#include "epoll_event_loop.h"
+
+#include "base/assert.h"
+#include "base/posix/last_error.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <utility>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace base::posix {
+namespace {
+
+constexpr int max_events = 32;
+
+}  // namespace
+
+
+epoll_event_loop::epoll_event_loop()
+  : epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)) {
+  if (!epoll_fd_) {
+    throw_last_error("Failed to create epoll instance");
+  }
+
+  wake_up_fd_.set(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+  if (!wake_up_fd_) {
+    throw_last_error("Failed to create eventfd");
+  }
+
+  epoll_event evt{};
+  evt.events = EPOLLIN;
+  evt.data.fd = wake_up_fd_.get();
+  if (::epoll_ctl(epoll_fd_.get(), EPOLL_CTL_ADD, wake_up_fd_.get(), &evt) < 0) {
+    throw_last_error("Failed to watch eventfd");
+  }
+}
+
+
+void epoll_event_loop::sleep(const task::delay_type* delay) {
+  int timeout = -1;
+  if (delay) {
+    auto millis = std::chrono::ceil<std::chrono::milliseconds>(*delay);
+    timeout = static_cast<int>(std::min<std::chrono::milliseconds::rep>(millis.count(), INT_MAX));
+  }
+
+  epoll_event events[max_events];
+  int count = ::epoll_wait(epoll_fd_.get(), events, max_events, timeout);
+  if (count < 0) {
+    ASSERT(errno == EINTR) << "epoll_wait failed";
+    return;  // interrupted by a signal, the loop will simply come back here if there's nothing to do
+  }
+
+  for (int i = 0; i < count; i++) {
+    int fd = events[i].data.fd;
+    if (fd == wake_up_fd_.get()) {
+      clear_wake_up();
+      continue;
+    }
+
+    auto it = watches_.find(fd);
+    if (it == watches_.end()) {
+      continue;  // removed by an earlier callback
+    }
+
+    auto callback = it->second;  // keep the callback alive even if it removes itself
+    (*callback)(events[i].events);
+  }
+}
+
+void epoll_event_loop::wake_up() {
+  std::uint64_t val = 1;
+  while (::write(wake_up_fd_.get(), &val, sizeof(val)) < 0) {
+    if (errno != EINTR) {
+      // EAGAIN means the counter is saturated, so the loop is already due to wake up
+      ASSERT(errno == EAGAIN) << "Failed to signal eventfd";
+      return;
+    }
+  }
+}
+
+
+void epoll_event_loop::add_watch(int fd, std::uint32_t events, watch_callback callback) {
+  epoll_event evt{};
+  evt.events = events;
+  evt.data.fd = fd;
+  if (::epoll_ctl(epoll_fd_.get(), EPOLL_CTL_ADD, fd, &evt) < 0) {
+    throw_last_error("Failed to watch descriptor");
+  }
+
+  watches_[fd] = std::make_shared<watch_callback>(std::move(callback));
+}
+
+void epoll_event_loop::remove_watch(int fd) {
+  auto it = watches_.find(fd);
+  if (it == watches_.end()) {
+    return;
+  }
+
+  ::epoll_ctl(epoll_fd_.get(), EPOLL_CTL_DEL, fd, nullptr);
+  watches_.erase(it);
+}
+
+
+// PRIVATE
+
+void epoll_event_loop::clear_wake_up() {
+  std::uint64_t val;
+  while (::read(wake_up_fd_.get(), &val, sizeof(val)) < 0) {
+    if (errno != EINTR) {
+      // EAGAIN means another wake up already cleared the counter
+      ASSERT(errno == EAGAIN) << "Failed to clear eventfd";
+      return;
+    }
+  }
+}
+
+}  // namespace base::posix
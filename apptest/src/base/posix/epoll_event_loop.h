@@ -0,0 +1,37 @@
+#pragma once
+
+#include "base/event_loop/event_loop.h"
+#include "base/function.h"
+#include "base/posix/scoped_fd.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace base::posix {
+
+// Linux counterpart of io_event_loop: wake-ups are signalled through an eventfd and sleeping is
+// done in epoll_wait, so that readiness callbacks for other descriptors can be dispatched from
+// sleep() in the same way that io_event_loop dispatches completion routines.
+class epoll_event_loop : public event_loop {
+public:
+  using watch_callback = function<void(std::uint32_t)>;  // receives the ready epoll events
+
+  epoll_event_loop();
+
+  void sleep(const task::delay_type* delay) override;
+  void wake_up() override;
+
+  // note: watches are only dispatched on the loop's thread, and may be added or removed from
+  // within a watch callback
+  void add_watch(int fd, std::uint32_t events, watch_callback callback);
+  void remove_watch(int fd);
+
+private:
+  void clear_wake_up();
+
+  scoped_fd epoll_fd_;
+  scoped_fd wake_up_fd_;
+  std::unordered_map<int, std::shared_ptr<watch_callback>> watches_;
+};
+
+}  // namespace base::posix
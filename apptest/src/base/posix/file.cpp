@@ -0,0 +1,188 @@
+#include "file.h"
+
+#include "base/assert.h"
+#include "base/posix/io_ring.h"
+#include "base/posix/last_error.h"
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace base::posix {
+namespace {
+
+int get_posix_flags(int desired_access, file::create_disp disp) {
+  int ret = O_CLOEXEC;
+
+  bool read = desired_access & file::in;
+  bool write = desired_access & file::out;
+  if (read && write) {
+    ret |= O_RDWR;
+  } else if (write) {
+    ret |= O_WRONLY;
+  } else {
+    ret |= O_RDONLY;
+  }
+
+  switch (disp) {
+  case file::create_disp::open_only:
+    break;
+  case file::create_disp::create_only:
+    ret |= O_CREAT | O_EXCL;
+    break;
+  case file::create_disp::open_always:
+    ret |= O_CREAT;
+    break;
+  case file::create_disp::create_always:
+    ret |= O_CREAT | O_TRUNC;
+    break;
+  default:
+    NOTREACHED() << "Invalid file creation disposition";
+  }
+
+  return ret;
+}
+
+
+io_ring* get_ring() {
+  io_ring* ring = io_ring::current();
+  ASSERT(ring) << "File operations require a uring_event_loop on this thread";
+  return ring;
+}
+
+// completes an operation's promise, keeping its iovecs (if any) alive until then, as the kernel
+// only reads them when the batch is actually submitted
+struct io_completion {
+  void operator()(int res) {
+    if (res < 0) {
+      prom.set_exception(std::system_error(-res, std::system_category()));
+    } else {
+      prom.set(static_cast<unsigned long>(res));
+    }
+  }
+
+  promise<unsigned long> prom;
+  std::unique_ptr<iovec[]> iovecs;
+};
+
+// sqe lengths are 32-bit; longer requests fail instead of being silently truncated, which would
+// look like a successful short transfer
+bool reject_oversized(std::uint64_t len, promise<unsigned long>& prom) {
+  if (len <= std::numeric_limits<std::uint32_t>::max()) {
+    return false;
+  }
+
+  prom.set_exception(std::system_error(std::make_error_code(std::errc::invalid_argument), "I/O request too large"));
+  return true;
+}
+
+file::complete_type submit_io(int opcode, int fd, file::offset_type offset, const void* buf, unsigned long count, int buf_index = 0) {
+  io_completion completion;
+  auto fut = completion.prom.get_future();
+  if (reject_oversized(count, completion.prom)) {
+    return fut;
+  }
+
+  io_uring_sqe* sqe = get_ring()->prepare(std::move(completion));
+  sqe->opcode = static_cast<std::uint8_t>(opcode);
+  sqe->fd = fd;
+  sqe->off = offset;
+  sqe->addr = reinterpret_cast<std::uintptr_t>(buf);
+  sqe->len = static_cast<std::uint32_t>(count);
+  sqe->buf_index = static_cast<std::uint16_t>(buf_index);
+
+  return fut;
+}
+
+file::complete_type submit_vectored_io(int opcode, int fd, file::offset_type offset, span<const iovec> bufs) {
+  io_completion completion;
+  auto fut = completion.prom.get_future();
+  if (reject_oversized(bufs.size(), completion.prom)) {
+    return fut;
+  }
+
+  completion.iovecs = std::make_unique<iovec[]>(bufs.size());
+  std::copy(bufs.begin(), bufs.end(), completion.iovecs.get());
+  const iovec* iovecs = completion.iovecs.get();
+
+  io_uring_sqe* sqe = get_ring()->prepare(std::move(completion));
+  sqe->opcode = static_cast<std::uint8_t>(opcode);
+  sqe->fd = fd;
+  sqe->off = offset;
+  sqe->addr = reinterpret_cast<std::uintptr_t>(iovecs);
+  sqe->len = static_cast<std::uint32_t>(bufs.size());
+
+  return fut;
+}
+
+}  // namespace
+
+
+file::file(const std::filesystem::path& name, int desired_access, create_disp disp, int share) {
+  open(name, desired_access, disp, share);
+}
+
+
+void file::open(const std::filesystem::path& name, int desired_access, create_disp disp, int) {
+  fd_.set(::open(name.c_str(), get_posix_flags(desired_access, disp), 0666));
+
+  if (!fd_) {
+    throw_last_error("Failed to open file");
+  }
+}
+
+void file::close() {
+  fd_.release();
+}
+
+
+file::complete_type file::read(offset_type offset, void* buf, unsigned long count) {
+  return submit_io(IORING_OP_READ, fd_.get(), offset, buf, count);
+}
+
+file::complete_type file::write(offset_type offset, const void* buf, unsigned long count) {
+  return submit_io(IORING_OP_WRITE, fd_.get(), offset, buf, count);
+}
+
+
+file::complete_type file::readv(offset_type offset, span<const iovec> bufs) {
+  return submit_vectored_io(IORING_OP_READV, fd_.get(), offset, bufs);
+}
+
+file::complete_type file::writev(offset_type offset, span<const iovec> bufs) {
+  return submit_vectored_io(IORING_OP_WRITEV, fd_.get(), offset, bufs);
+}
+
+
+file::complete_type file::read_fixed(offset_type offset, void* buf, unsigned long count, int buf_index) {
+  return submit_io(IORING_OP_READ_FIXED, fd_.get(), offset, buf, count, buf_index);
+}
+
+file::complete_type file::write_fixed(offset_type offset, const void* buf, unsigned long count, int buf_index) {
+  return submit_io(IORING_OP_WRITE_FIXED, fd_.get(), offset, buf, count, buf_index);
+}
+
+
+// static
+void file::register_buffers(span<const iovec> bufs) {
+  get_ring()->register_buffers(bufs);
+}
+
+// static
+void file::unregister_buffers() {
+  get_ring()->unregister_buffers();
+}
+
+
+file::offset_type file::length() {
+  struct stat info;
+  if (::fstat(fd_.get(), &info) < 0) {
+    throw_last_error("Failed to query file size");
+  }
+  return info.st_size;
+}
+
+}  // namespace base::posix
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "base/future/future.h"
+#include "base/posix/scoped_fd.h"
+#include "base/span.h"
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <sys/uio.h>
+
+namespace base::posix {
+
+// io_uring-backed counterpart of base::file. Operations must be started on a thread running a
+// uring_event_loop; they are submitted in batches by the loop, which also completes the returned
+// futures.
+class file {
+public:
+  enum access {
+    in = 1 << 0,  // read
+    out = 1 << 1  // write
+  };
+
+  enum class create_disp {
+    open_only,  // open only if exists
+    create_only,  // create only if doesn't exist
+
+    open_always,  // open or create
+    create_always,  // open or create + truncate
+  };
+
+  enum share_mode {  // note: ignored, present for compatibility with base::file
+    share_none = 0,
+    share_read = 1 << 0,
+    share_write = 1 << 1,
+    share_del = 1 << 2
+  };
+
+
+  using offset_type = std::int64_t;
+  using complete_type = future<unsigned long>;
+
+  file() = default;
+  file(const std::filesystem::path& name, int desired_access, create_disp disp, int share = share_read | share_write);
+
+  void open(const std::filesystem::path& name, int desired_access, create_disp disp, int share = share_read | share_write);
+  void close();
+
+
+  template<typename Buffer>
+  complete_type read(offset_type offset, Buffer& buf);
+
+
+  template<typename Buffer>
+  complete_type write(offset_type offset, const Buffer& buf);
+
+  template<typename Buffer>
+  void write(offset_type, const Buffer&&) = delete;  // temp object
+
+
+  complete_type read(offset_type offset, void* buf, unsigned long count);
+  complete_type write(offset_type offset, const void* buf, unsigned long count);
+
+  // scatter/gather; the iovec array itself may be discarded once these return
+  complete_type readv(offset_type offset, span<const iovec> bufs);
+  complete_type writev(offset_type offset, span<const iovec> bufs);
+
+  // `buf` must lie within the registered buffer at `buf_index`
+  complete_type read_fixed(offset_type offset, void* buf, unsigned long count, int buf_index);
+  complete_type write_fixed(offset_type offset, const void* buf, unsigned long count, int buf_index);
+
+  // registers buffers for use with read_fixed/write_fixed on the current thread
+  static void register_buffers(span<const iovec> bufs);
+  static void unregister_buffers();
+
+  offset_type length();
+
+private:
+  scoped_fd fd_;
+};
+
+
+template<typename Buffer>
+file::complete_type file::read(offset_type offset, Buffer& buf) {
+  return read(offset, std::data(buf), static_cast<unsigned long>(std::size(buf)));
+}
+
+template<typename Buffer>
+file::complete_type file::write(offset_type offset, const Buffer& buf) {
+  return write(offset, std::data(buf), static_cast<unsigned long>(std::size(buf)));
+}
+
+}  // namespace base::posix
@@ -0,0 +1,266 @@
+#include "io_ring.h"
+
+#include "base/assert.h"
+#include "base/posix/last_error.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace base::posix {
+namespace {
+
+thread_local std::weak_ptr<io_ring> thread_ring;
+thread_local io_ring* current_ring = nullptr;
+
+
+int io_uring_setup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+  return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+
+void* map_ring(int fd, std::size_t size, off_t offset) {
+  void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+  if (ptr == MAP_FAILED) {
+    throw_last_error("Failed to map io_uring");
+  }
+  return ptr;
+}
+
+template<typename T>
+T* ring_field(void* base, std::uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}  // namespace
+
+
+io_ring::io_ring(unsigned entries) {
+  io_uring_params params{};
+  ring_fd_.set(io_uring_setup(entries, &params));
+  if (!ring_fd_) {
+    throw_last_error("Failed to create io_uring");
+  }
+
+  try {
+    map_rings(params);
+  } catch (...) {
+    unmap_rings();
+    throw;
+  }
+
+  event_fd_.set(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+  if (!event_fd_) {
+    throw_last_error("Failed to create eventfd");
+  }
+
+  int fd = event_fd_.get();
+  if (io_uring_register(ring_fd_.get(), IORING_REGISTER_EVENTFD, &fd, 1) < 0) {
+    throw_last_error("Failed to register eventfd with io_uring");
+  }
+}
+
+io_ring::~io_ring() {
+  if (current_ring == this) {
+    current_ring = nullptr;
+  }
+
+  // closing the ring cancels anything still in flight; the remaining callbacks (and any promises
+  // they hold) are simply destroyed
+  ring_fd_.release();
+  unmap_rings();
+}
+
+
+io_uring_sqe* io_ring::prepare(completion_callback callback) {
+  if (outstanding_ == cq_entries_) {
+    // make sure the completion queue can never overflow
+    flush();
+    while (!reap()) {
+      enter(0, 1);
+    }
+  }
+
+  if (pending_count() == sq_entries_) {
+    flush();
+  }
+
+  std::uint32_t slot;
+  if (free_slots_.empty()) {
+    slot = static_cast<std::uint32_t>(callbacks_.size());
+    callbacks_.push_back(std::move(callback));
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+    callbacks_[slot] = std::move(callback);
+  }
+  ++outstanding_;
+
+  unsigned index = sq_local_tail_ & sq_mask_;
+  io_uring_sqe* sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->user_data = slot;
+  sq_array_[index] = index;
+  ++sq_local_tail_;
+
+  return sqe;
+}
+
+
+void io_ring::flush() {
+  unsigned to_submit = sq_local_tail_ - *sq_tail_;
+  if (!to_submit) {
+    return;
+  }
+
+  __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+  enter(to_submit, 0);
+}
+
+bool io_ring::reap() {
+  bool reaped = false;
+
+  while (true) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+
+    const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+    auto slot = static_cast<std::uint32_t>(cqe.user_data);
+    int res = cqe.res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+    // release the slot before running the callback, as it may queue more operations
+    completion_callback callback = std::move(callbacks_[slot]);
+    callbacks_[slot] = nullptr;
+    free_slots_.push_back(slot);
+    --outstanding_;
+
+    callback(res);
+    reaped = true;
+  }
+
+  return reaped;
+}
+
+
+void io_ring::clear_event() {
+  std::uint64_t val;
+  if (::read(event_fd_.get(), &val, sizeof(val)) < 0) {
+    return;  // nothing to clear
+  }
+}
+
+
+void io_ring::register_buffers(span<const iovec> buffers) {
+  if (io_uring_register(ring_fd_.get(), IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size())) < 0) {
+    throw_last_error("Failed to register buffers");
+  }
+}
+
+void io_ring::unregister_buffers() {
+  io_uring_register(ring_fd_.get(), IORING_UNREGISTER_BUFFERS, nullptr, 0);
+}
+
+
+// static
+std::shared_ptr<io_ring> io_ring::for_current_thread() {
+  auto ring = thread_ring.lock();
+  if (!ring) {
+    ring = std::make_shared<io_ring>();
+    thread_ring = ring;
+    current_ring = ring.get();
+  }
+  return ring;
+}
+
+// static
+io_ring* io_ring::current() {
+  return current_ring;
+}
+
+
+// PRIVATE
+
+void io_ring::map_rings(const io_uring_params& params) {
+  sq_map_.size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_map_.size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    // both rings share a single mapping
+    sq_map_.size = std::max(sq_map_.size, cq_map_.size);
+    sq_map_.ptr = map_ring(ring_fd_.get(), sq_map_.size, IORING_OFF_SQ_RING);
+    cq_map_.size = 0;
+  } else {
+    sq_map_.ptr = map_ring(ring_fd_.get(), sq_map_.size, IORING_OFF_SQ_RING);
+    cq_map_.ptr = map_ring(ring_fd_.get(), cq_map_.size, IORING_OFF_CQ_RING);
+  }
+  void* cq_ptr = cq_map_.ptr ? cq_map_.ptr : sq_map_.ptr;
+
+  sqes_map_.size = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_map_.ptr = map_ring(ring_fd_.get(), sqes_map_.size, IORING_OFF_SQES);
+
+  sq_head_ = ring_field<unsigned>(sq_map_.ptr, params.sq_off.head);
+  sq_tail_ = ring_field<unsigned>(sq_map_.ptr, params.sq_off.tail);
+  sq_mask_ = *ring_field<unsigned>(sq_map_.ptr, params.sq_off.ring_mask);
+  sq_entries_ = *ring_field<unsigned>(sq_map_.ptr, params.sq_off.ring_entries);
+  sq_array_ = ring_field<unsigned>(sq_map_.ptr, params.sq_off.array);
+  sqes_ = static_cast<io_uring_sqe*>(sqes_map_.ptr);
+  sq_local_tail_ = *sq_tail_;
+
+  cq_head_ = ring_field<unsigned>(cq_ptr, params.cq_off.head);
+  cq_tail_ = ring_field<unsigned>(cq_ptr, params.cq_off.tail);
+  cq_mask_ = *ring_field<unsigned>(cq_ptr, params.cq_off.ring_mask);
+  cq_entries_ = *ring_field<unsigned>(cq_ptr, params.cq_off.ring_entries);
+  cqes_ = ring_field<io_uring_cqe>(cq_ptr, params.cq_off.cqes);
+}
+
+void io_ring::unmap_rings() {
+  for (mapping* map : { &sqes_map_, &cq_map_, &sq_map_ }) {
+    if (map->ptr) {
+      ::munmap(map->ptr, map->size);
+      *map = mapping();
+    }
+  }
+}
+
+
+void io_ring::enter(unsigned to_submit, unsigned min_complete) {
+  unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+
+  while (true) {
+    int ret = io_uring_enter(ring_fd_.get(), to_submit, min_complete, flags);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EBUSY) {
+        reap();  // the completion queue is backed up
+        continue;
+      }
+      throw_last_error("Failed to submit io_uring operations");
+    }
+
+    to_submit -= std::min(to_submit, static_cast<unsigned>(ret));
+    if (!to_submit) {
+      break;
+    }
+    min_complete = 0;  // already waited
+    flags = 0;
+  }
+}
+
+}  // namespace base::posix
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "base/function.h"
+#include "base/non_copyable.h"
+#include "base/posix/scoped_fd.h"
+#include "base/span.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+namespace base::posix {
+
+// Thin wrapper around an io_uring instance. Operations are only queued by prepare(), and all
+// queued operations are handed to the kernel with a single syscall by flush(). Completions are
+// dispatched to their callbacks by reap(), on the thread owning the ring.
+class io_ring : public non_copy_movable {
+public:
+  using completion_callback = function<void(int)>;  // receives the operation's result (`-errno` on failure)
+
+  static constexpr unsigned default_entries = 256;
+
+  explicit io_ring(unsigned entries = default_entries);
+  ~io_ring();
+
+  // returns a zeroed sqe whose completion will be reported to `callback`
+  io_uring_sqe* prepare(completion_callback callback);
+
+  void flush();
+  bool reap();
+
+  int event_fd() const { return event_fd_.get(); }
+  void clear_event();
+
+  void register_buffers(span<const iovec> buffers);
+  void unregister_buffers();
+
+  // the ring shared by all uring_event_loops on this thread
+  static std::shared_ptr<io_ring> for_current_thread();
+  static io_ring* current();
+
+private:
+  struct mapping {
+    void* ptr = nullptr;
+    std::size_t size = 0;
+  };
+
+  void map_rings(const io_uring_params& params);
+  void unmap_rings();
+
+  void enter(unsigned to_submit, unsigned min_complete);
+  unsigned pending_count() const { return sq_local_tail_ - *sq_head_; }
+
+  scoped_fd ring_fd_;
+  scoped_fd event_fd_;
+
+  mapping sq_map_;
+  mapping cq_map_;
+  mapping sqes_map_;
+
+  // submission queue
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned sq_entries_;
+  unsigned* sq_array_;
+  io_uring_sqe* sqes_;
+  unsigned sq_local_tail_ = 0;  // includes sqes that haven't been published to the kernel yet
+
+  // completion queue
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  unsigned cq_entries_;
+  io_uring_cqe* cqes_;
+
+  // callbacks of queued and in-flight operations, indexed by `user_data`
+  std::vector<completion_callback> callbacks_;
+  std::vector<std::uint32_t> free_slots_;
+  std::size_t outstanding_ = 0;
+};
+
+}  // namespace base::posix
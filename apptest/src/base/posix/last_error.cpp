@@ -0,0 +1,21 @@
+#include "last_error.h"
+
+#include <cerrno>
+#include <new>
+
+namespace base::posix {
+
+std::error_code last_error() {
+  return std::error_code(errno, std::system_category());
+}
+
+[[noreturn]] void throw_last_error(const char* what) {
+  auto code = last_error();
+  if (code.value() == ENOMEM) {
+    throw std::bad_alloc();
+  }
+
+  throw std::system_error(code, what);
+}
+
+}  // namespace base::posix
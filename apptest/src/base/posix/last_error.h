@@ -0,0 +1,11 @@
+#pragma once
+
+#include <system_error>
+
+namespace base::posix {
+
+std::error_code last_error();
+
+[[noreturn]] void throw_last_error(const char* what = "");
+
+}  // namespace base::posix
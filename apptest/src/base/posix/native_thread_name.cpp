@@ -0,0 +1,14 @@
+#include "base/thread/thread_name.h"
+
+#include <pthread.h>
+
+namespace base::impl {
+
+void set_native_thread_name(const std::string& name) {
+  // linux limits names to 15 bytes, and fails on anything longer
+  std::string truncated = name;
+  truncate_thread_name(truncated, 15);
+  ::pthread_setname_np(::pthread_self(), truncated.c_str());
+}
+
+}  // namespace base::impl
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "scoped_fd.h"
+
+#include <utility>
+#include <unistd.h>
+
+namespace base::posix {
+
+scoped_fd::scoped_fd()
+  : fd_(-1) {}
+
+scoped_fd::scoped_fd(int fd)
+  : fd_(fd) {}
+
+scoped_fd::scoped_fd(scoped_fd&& rhs) noexcept
+  : fd_(rhs.fd_) {
+  rhs.fd_ = -1;
+}
+
+
+scoped_fd::~scoped_fd() {
+  release();
+}
+
+
+scoped_fd& scoped_fd::operator=(scoped_fd rhs) noexcept {
+  rhs.swap(*this);
+
+  return *this;
+}
+
+
+void scoped_fd::set(int fd) {
+  *this = scoped_fd(fd);
+}
+
+
+void scoped_fd::release() {
+  if (*this) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+int scoped_fd::detatch() {
+  return std::exchange(fd_, -1);
+}
+
+
+void scoped_fd::swap(scoped_fd& other) noexcept {
+  std::swap(fd_, other.fd_);
+}
+
+
+scoped_fd::operator bool() const {
+  return fd_ >= 0;
+}
+
+}  // namespace base::posix
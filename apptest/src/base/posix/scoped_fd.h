@@ -0,0 +1,37 @@
+#pragma once
+
+#include "base/non_copyable.h"
+
+namespace base::posix {
+
+class scoped_fd : public non_copyable {
+public:
+  scoped_fd();
+
+  explicit scoped_fd(int fd);
+  scoped_fd(scoped_fd&& rhs) noexcept;
+
+  ~scoped_fd();
+
+  scoped_fd& operator=(scoped_fd rhs) noexcept;
+
+  void set(int fd);
+  int get() const { return fd_; }
+
+  void release();
+  int detatch();
+
+  void swap(scoped_fd& other) noexcept;
+
+  explicit operator bool() const;
+
+private:
+  int fd_;
+};
+
+
+inline void swap(scoped_fd& lhs, scoped_fd& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace base::posix
@@ -0,0 +1,34 @@
+#include "uring_event_loop.h"
+
+#include <sys/epoll.h>
+
+namespace base::posix {
+
+uring_event_loop::uring_event_loop()
+  : ring_(io_ring::for_current_thread()) {
+  add_watch(ring_->event_fd(), EPOLLIN, [ring = ring_.get()](std::uint32_t) {
+    ring->clear_event();  // completions themselves are reaped in do_work()
+  });
+}
+
+uring_event_loop::~uring_event_loop() {
+  remove_watch(ring_->event_fd());
+}
+
+
+bool uring_event_loop::do_work() {
+  ring_->flush();
+  return ring_->reap();
+}
+
+void uring_event_loop::sleep(const task::delay_type* delay) {
+  // tasks run since the last iteration may have queued more operations
+  ring_->flush();
+  if (ring_->reap()) {
+    return;
+  }
+
+  epoll_event_loop::sleep(delay);
+}
+
+}  // namespace base::posix
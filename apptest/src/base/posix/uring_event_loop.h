@@ -0,0 +1,23 @@
+#pragma once
+
+#include "base/posix/epoll_event_loop.h"
+#include "base/posix/io_ring.h"
+#include <memory>
+
+namespace base::posix {
+
+// epoll_event_loop that also drives the thread's io_ring: operations queued while running tasks
+// are submitted together once per loop iteration, and their completions are reaped in do_work().
+class uring_event_loop : public epoll_event_loop {
+public:
+  uring_event_loop();
+  ~uring_event_loop();
+
+  bool do_work() override;
+  void sleep(const task::delay_type* delay) override;
+
+private:
+  std::shared_ptr<io_ring> ring_;
+};
+
+}  // namespace base::posix
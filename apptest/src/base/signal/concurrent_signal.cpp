@@ -0,0 +1,68 @@
+#include "concurrent_signal.h"
+
+namespace base::impl {
+namespace {
+
+std::atomic<hazard_record*> all_records = nullptr;
+
+// the records owned by this thread, indexed by nesting depth
+struct thread_hazards {
+  ~thread_hazards();
+
+  std::vector<hazard_record*> records;
+  std::size_t depth = 0;
+};
+
+thread_hazards::~thread_hazards() {
+  for (hazard_record* record : records) {
+    record->in_use.store(false, std::memory_order_release);  // up for grabs by other threads
+  }
+}
+
+thread_local thread_hazards current_hazards;
+
+hazard_record* claim_record() {
+  // reuse a record given up by a thread which has exited, if any
+  for (hazard_record* record = all_records.load(std::memory_order_acquire); record; record = record->next) {
+    if (!record->in_use.load(std::memory_order_relaxed) && !record->in_use.exchange(true, std::memory_order_acquire)) {
+      return record;
+    }
+  }
+
+  auto* record = new hazard_record;
+  record->in_use.store(true, std::memory_order_relaxed);
+  record->next = all_records.load(std::memory_order_relaxed);
+  while (!all_records.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) {
+  }
+  return record;
+}
+
+}  // namespace
+
+
+hazard_record* acquire_hazard() {
+  thread_hazards& hazards = current_hazards;
+  if (hazards.depth == hazards.records.size()) {
+    hazards.records.push_back(claim_record());
+  }
+  return hazards.records[hazards.depth++];
+}
+
+void release_hazard() {
+  thread_hazards& hazards = current_hazards;
+  hazards.records[--hazards.depth]->ptr.store(nullptr, std::memory_order_release);
+}
+
+std::vector<const void*> protected_pointers() {
+  std::vector<const void*> ret;
+  for (hazard_record* record = all_records.load(std::memory_order_acquire); record; record = record->next) {
+    if (const void* ptr = record->ptr.load()) {  // seq_cst, see hazard_scope::protect
+      ret.push_back(ptr);
+    }
+  }
+
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+}  // namespace base::impl
\ No newline at end of file
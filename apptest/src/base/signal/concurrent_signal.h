@@ -0,0 +1,274 @@
+#pragma once
+
+#include "base/function.h"
+#include "base/future/impl/core_alloc.h"
+#include "base/non_copyable.h"
+#include "base/signal/queued_slot.h"
+#include "base/signal/signal.h"
+#include "base/signal/slot_handle.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace base {
+
+namespace impl {
+
+// Hazard pointers: an emission publishes the snapshot it walks in a record owned by its thread, and
+// a retired snapshot is freed as soon as no record refers to it. Emissions never write to memory
+// shared with other threads, and snapshots don't pile up while signals are emitted continuously.
+struct alignas(64) hazard_record {
+  std::atomic<const void*> ptr = nullptr;
+  std::atomic<bool> in_use = false;  // owned by a thread
+  hazard_record* next = nullptr;  // in the list of all records, which are never freed
+};
+
+// each thread uses its records as a stack, so that emissions may nest
+hazard_record* acquire_hazard();
+void release_hazard();  // the record last acquired by this thread
+
+// the pointers currently protected by any thread, sorted
+std::vector<const void*> protected_pointers();
+
+class hazard_scope : public non_copy_movable {
+public:
+  hazard_scope() : record_(acquire_hazard()) {}
+  ~hazard_scope() { release_hazard(); }
+
+  // loads `src`, which is safe to use until the scope ends unless it's null
+  template<typename T>
+  T* protect(const std::atomic<T*>& src);
+
+private:
+  hazard_record* record_;
+};
+
+
+template<typename T>
+T* hazard_scope::protect(const std::atomic<T*>& src) {
+  // once published, the pointer can only be freed if it was retired before being published, in
+  // which case it's no longer in `src`; this pairs with the seq_cst operations of the retiring side
+  T* ptr = src.load(std::memory_order_relaxed);
+  while (ptr) {
+    record_->ptr.store(ptr);
+    T* latest = src.load();
+    if (latest == ptr) {
+      break;
+    }
+    ptr = latest;
+  }
+  return ptr;
+}
+
+}  // namespace impl
+
+
+// A signal which may be emitted, connected to and disconnected from on any number of threads at once.
+// Emission walks an immutable snapshot of the slot list without locking; connecting or disconnecting
+// publishes a new snapshot (copy-on-write), and old snapshots are freed once no emission is using
+// them (see impl::hazard_record). A slot disconnected on another thread may still be running (or just about to run) when
+// disconnect() returns, but it isn't called by emissions started afterwards.
+template<typename... Args>
+class concurrent_signal : public non_copy_movable {
+public:
+  using slot_type = function<void(Args...)>;
+
+  concurrent_signal() = default;
+  ~concurrent_signal();
+
+  slot_handle connect(slot_type slot);
+  // calls `slot` by posting tasks to `runner` instead; emissions queued before disconnecting are dropped
+  slot_handle connect(slot_type slot, std::weak_ptr<task_runner> runner,
+    queued_delivery delivery = queued_delivery::all);
+
+  void operator()(Args... args);
+
+private:
+  struct slot_rep : impl::slot_rep_base {
+    slot_rep(concurrent_signal* signal, slot_type slot)
+      : signal_(signal)
+      , slot_(std::move(slot)) {
+    }
+
+    void disconnect() override { signal_->disconnect(this); }
+    void block(bool block) override { blocked_.store(block, std::memory_order_relaxed); }
+    bool blocked() const override { return blocked_.load(std::memory_order_relaxed); }
+
+    void call(Args&... args) {
+      if (connected_.load(std::memory_order_acquire) && !blocked_.load(std::memory_order_relaxed)) {
+        slot_(args...);
+      }
+    }
+
+    concurrent_signal* signal_;
+    slot_type slot_;
+    std::atomic<bool> connected_ = true;
+    std::atomic<bool> blocked_ = false;
+  };
+
+  using slot_ptr = std::shared_ptr<slot_rep>;
+
+  // an immutable snapshot of the slots, allocated in one block together with its elements
+  struct slot_list {
+    static slot_list* create(const std::vector<slot_ptr>& slots);
+    static void destroy(slot_list* list) noexcept;
+
+    slot_ptr* begin() { return reinterpret_cast<slot_ptr*>(this + 1); }
+    slot_ptr* end() { return begin() + size; }
+
+    std::size_t size;
+    slot_list* next_retired = nullptr;
+  };
+
+  void disconnect(slot_rep* rep);
+  void publish();  // requires lock_
+  void reclaim();  // requires lock_; frees the retired snapshots which no emission is using
+
+  std::atomic<slot_list*> current_ = nullptr;
+  std::atomic<bool> has_retired_ = false;
+
+  std::mutex lock_;  // serializes changes to the slots
+  std::vector<slot_ptr> slots_;
+  slot_list* retired_ = nullptr;
+};
+
+
+template<typename... Args>
+concurrent_signal<Args...>::~concurrent_signal() {
+  std::scoped_lock hold(lock_);
+
+  for (auto& slot : slots_) {
+    slot->connected_.store(false, std::memory_order_relaxed);
+  }
+  slots_.clear();
+
+  if (slot_list* list = current_.exchange(nullptr)) {
+    list->next_retired = retired_;
+    retired_ = list;
+  }
+  reclaim();
+  ASSERT(!retired_) << "Signal destroyed during emission";
+}
+
+
+template<typename... Args>
+slot_handle concurrent_signal<Args...>::connect(slot_type slot) {
+  auto rep = std::allocate_shared<slot_rep>(impl::core_allocator<slot_rep>(), this, std::move(slot));
+
+  std::scoped_lock hold(lock_);
+  slots_.push_back(rep);
+  publish();
+  return slot_handle(std::move(rep));
+}
+
+template<typename... Args>
+slot_handle concurrent_signal<Args...>::connect(slot_type slot, std::weak_ptr<task_runner> runner, queued_delivery delivery) {
+  return connect(impl::make_queued_slot(std::move(slot), std::move(runner), delivery));
+}
+
+
+template<typename... Args>
+void concurrent_signal<Args...>::operator()(Args... args) {
+  {
+    impl::hazard_scope hazard;
+    if (slot_list* list = hazard.protect(current_)) {
+      for (auto& slot : *list) {
+        slot->call(args...);
+      }
+    }
+  }
+
+  // a snapshot retired during the emission may have been kept for it; if the signal is busy, the
+  // snapshot is freed by whoever holds the lock, or by a later emission
+  if (has_retired_.load(std::memory_order_relaxed)) {
+    std::unique_lock hold(lock_, std::try_to_lock);
+    if (hold) {
+      reclaim();
+    }
+  }
+}
+
+
+// PRIVATE
+
+template<typename... Args>
+auto concurrent_signal<Args...>::slot_list::create(const std::vector<slot_ptr>& slots) -> slot_list* {
+  static_assert(alignof(slot_ptr) <= alignof(slot_list));
+
+  std::size_t bytes = sizeof(slot_list) + slots.size() * sizeof(slot_ptr);
+  auto* list = new (impl::allocate_core(bytes, alignof(slot_list))) slot_list{slots.size()};
+  std::uninitialized_copy(slots.begin(), slots.end(), list->begin());
+  return list;
+}
+
+template<typename... Args>
+void concurrent_signal<Args...>::slot_list::destroy(slot_list* list) noexcept {
+  std::size_t bytes = sizeof(slot_list) + list->size * sizeof(slot_ptr);
+
+  std::destroy(list->begin(), list->end());
+  list->~slot_list();
+  impl::free_core(list, bytes, alignof(slot_list));
+}
+
+
+template<typename... Args>
+void concurrent_signal<Args...>::disconnect(slot_rep* rep) {
+  std::scoped_lock hold(lock_);
+
+  // a disconnected slot stays alive until the snapshots referring to it are freed
+  if (!rep->connected_.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  auto it = std::find_if(slots_.begin(), slots_.end(),
+    [&](const auto& cur) {
+      return cur.get() == rep;
+    }
+  );
+  ASSERT(it != slots_.end()) << "Corrupt signal state";
+
+  rep->connected_.store(false, std::memory_order_release);
+  slots_.erase(it);
+  publish();
+}
+
+template<typename... Args>
+void concurrent_signal<Args...>::publish() {
+  slot_list* old = current_.exchange(slots_.empty() ? nullptr : slot_list::create(slots_));
+  if (old) {
+    old->next_retired = retired_;
+    retired_ = old;
+    has_retired_.store(true);
+  }
+  reclaim();
+}
+
+template<typename... Args>
+void concurrent_signal<Args...>::reclaim() {
+  if (!retired_) {
+    return;
+  }
+
+  // emissions starting from now on can only see current_, which is never retired
+  std::vector<const void*> hazards = impl::protected_pointers();
+
+  slot_list* list = std::exchange(retired_, nullptr);
+  while (list) {
+    slot_list* next = std::exchange(list->next_retired, nullptr);
+    if (std::binary_search(hazards.begin(), hazards.end(), list)) {
+      list->next_retired = retired_;
+      retired_ = list;
+    } else {
+      slot_list::destroy(list);
+    }
+    list = next;
+  }
+
+  has_retired_.store(retired_ != nullptr, std::memory_order_relaxed);
+}
+
+}  // namespace base
\ No newline at end of file
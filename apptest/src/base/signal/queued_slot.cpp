@@ -0,0 +1,106 @@
+#include "queued_slot.h"
+
+#include <iterator>
+#include <map>
+
+namespace base::impl {
+namespace {
+
+std::mutex registry_lock;
+std::map<std::weak_ptr<task_runner>, std::weak_ptr<queued_runner>, std::owner_less<>> registry;
+
+}  // namespace
+
+
+// Runs the batch, or drops it if the runner destroys the task without running it (e.g. because its
+// loop quit), so that the next emission posts a task again instead of waiting for this one forever.
+class queued_runner::batch_task {
+public:
+  explicit batch_task(std::shared_ptr<queued_runner> target) : target_(std::move(target)) {}
+  batch_task(batch_task&&) noexcept = default;
+
+  ~batch_task() {
+    if (target_) {
+      target_->drop();
+    }
+  }
+
+  void operator()() {
+    std::exchange(target_, nullptr)->run();
+  }
+
+private:
+  std::shared_ptr<queued_runner> target_;
+};
+
+
+// static
+std::shared_ptr<queued_runner> queued_runner::get(const std::weak_ptr<task_runner>& runner) {
+  std::scoped_lock hold(registry_lock);
+
+  // forget the runners without any connected slot left
+  for (auto it = registry.begin(); it != registry.end();) {
+    it = it->second.expired() ? registry.erase(it) : std::next(it);
+  }
+
+  auto& entry = registry[runner];
+  auto ret = entry.lock();
+  if (!ret) {
+    ret = std::make_shared<queued_runner>(runner);
+    entry = ret;
+  }
+  return ret;
+}
+
+void queued_runner::schedule(std::shared_ptr<queued_slot_state_base> slot) {
+  {
+    std::scoped_lock hold(lock_);
+    ready_.push_back(std::move(slot));
+
+    if (std::exchange(posted_, true)) {
+      return;  // the task already queued or running picks it up
+    }
+  }
+
+  if (auto runner = runner_.lock()) {
+    runner->post_task(batch_task(shared_from_this()));
+  } else {
+    drop();  // emissions are dropped once the runner is gone
+  }
+}
+
+
+// PRIVATE
+
+void queued_runner::run() {
+  for (;;) {
+    {
+      std::scoped_lock hold(lock_);
+      if (ready_.empty()) {
+        posted_ = false;
+        return;
+      }
+      std::swap(ready_, running_);
+    }
+
+    for (auto& slot : running_) {
+      slot->run();
+    }
+    running_.clear();
+  }
+}
+
+void queued_runner::drop() {
+  std::vector<std::shared_ptr<queued_slot_state_base>> dropped;
+  {
+    std::scoped_lock hold(lock_);
+    dropped.swap(ready_);
+    posted_ = false;
+  }
+
+  for (auto& slot : dropped) {
+    slot->drop();
+  }
+}
+
+}  // namespace base::impl
\ No newline at end of file
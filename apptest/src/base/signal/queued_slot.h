@@ -0,0 +1,161 @@
+#pragma once
+
+#include "base/function.h"
+#include "base/non_copyable.h"
+#include "base/task_runner/task_runner.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace base {
+
+// how emissions are delivered to a slot connected together with a task_runner
+enum class queued_delivery {
+  all,  // every emission, in order
+  latest  // only the latest emission since the slot last ran, e.g. for progress updates
+};
+
+namespace impl {
+
+// a queued slot, as seen by the batch delivering its emissions
+class queued_slot_state_base : public non_copy_movable {
+public:
+  virtual ~queued_slot_state_base() = default;
+
+  virtual void run() = 0;  // delivers the pending emissions
+  virtual void drop() = 0;  // discards them, as they will never be delivered
+};
+
+// The queued slots of one task_runner which have pending emissions. They are all delivered by a
+// single task, so a burst of emissions to any number of slots on the runner costs one task. There
+// is never more than one task queued or running, which also keeps delivery ordered on thread pools.
+class queued_runner : public non_copy_movable, public std::enable_shared_from_this<queued_runner> {
+public:
+  explicit queued_runner(std::weak_ptr<task_runner> runner) : runner_(std::move(runner)) {}
+
+  // the instance shared by all queued slots connected to `runner`
+  static std::shared_ptr<queued_runner> get(const std::weak_ptr<task_runner>& runner);
+
+  // adds `slot` to the batch, posting a task for it if there is none
+  void schedule(std::shared_ptr<queued_slot_state_base> slot);
+
+private:
+  class batch_task;
+
+  void run();
+  void drop();
+
+  std::weak_ptr<task_runner> runner_;
+
+  std::mutex lock_;
+  std::vector<std::shared_ptr<queued_slot_state_base>> ready_;
+  bool posted_ = false;  // whether a task is queued or running
+
+  std::vector<std::shared_ptr<queued_slot_state_base>> running_;  // only used by the task, kept to reuse its capacity
+};
+
+
+template<typename... Args>
+class queued_slot_state : public queued_slot_state_base {
+public:
+  queued_slot_state(function<void(Args...)> slot, std::shared_ptr<queued_runner> runner, queued_delivery delivery)
+    : slot_(std::move(slot))
+    , runner_(std::move(runner))
+    , delivery_(delivery) {
+  }
+
+  static void push(const std::shared_ptr<queued_slot_state>& state, Args&... args);
+  void disconnect() { disconnected_.store(true, std::memory_order_release); }
+
+  void run() override;
+  void drop() override;
+
+private:
+  using args_tuple = std::tuple<std::decay_t<Args>...>;
+
+  function<void(Args...)> slot_;
+  std::shared_ptr<queued_runner> runner_;
+  queued_delivery delivery_;
+  std::atomic<bool> disconnected_ = false;
+
+  std::mutex lock_;
+  std::vector<args_tuple> pending_;
+  bool scheduled_ = false;  // whether the slot is in its runner's batch
+
+  std::vector<args_tuple> running_;  // only used by the batch, kept to reuse its capacity
+};
+
+template<typename... Args>
+void queued_slot_state<Args...>::push(const std::shared_ptr<queued_slot_state>& state, Args&... args) {
+  {
+    std::scoped_lock hold(state->lock_);
+    if (state->delivery_ == queued_delivery::latest) {
+      state->pending_.clear();
+    }
+    state->pending_.emplace_back(args...);
+
+    // emissions arriving while the slot is in the batch are delivered along with the others
+    if (std::exchange(state->scheduled_, true)) {
+      return;
+    }
+  }
+
+  state->runner_->schedule(state);
+}
+
+template<typename... Args>
+void queued_slot_state<Args...>::run() {
+  {
+    std::scoped_lock hold(lock_);
+    std::swap(pending_, running_);
+    scheduled_ = false;  // anything emitted from now on needs scheduling again
+  }
+
+  for (auto& args : running_) {
+    if (disconnected_.load(std::memory_order_acquire)) {
+      break;
+    }
+    std::apply(slot_, args);
+  }
+  running_.clear();
+}
+
+template<typename... Args>
+void queued_slot_state<Args...>::drop() {
+  std::scoped_lock hold(lock_);
+  pending_.clear();
+  scheduled_ = false;
+}
+
+
+// the slot stored in the signal, which forwards emissions to the state
+template<typename... Args>
+class queued_slot : public non_copyable {
+public:
+  explicit queued_slot(std::shared_ptr<queued_slot_state<Args...>> state) : state_(std::move(state)) {}
+  queued_slot(queued_slot&&) noexcept = default;
+  ~queued_slot() {
+    if (state_) {
+      state_->disconnect();  // drops the emissions which are still queued
+    }
+  }
+
+  void operator()(Args... args) { queued_slot_state<Args...>::push(state_, args...); }
+
+private:
+  std::shared_ptr<queued_slot_state<Args...>> state_;
+};
+
+template<typename... Args>
+function<void(Args...)> make_queued_slot(function<void(Args...)> slot, std::weak_ptr<task_runner> runner,
+    queued_delivery delivery) {
+  return queued_slot<Args...>(
+    std::make_shared<queued_slot_state<Args...>>(std::move(slot), queued_runner::get(runner), delivery));
+}
+
+}  // namespace impl
+}  // namespace base
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "base/finally.h"
 #include "base/function.h"
 #include "base/non_copyable.h"
+#include "base/signal/queued_slot.h"
 #include "base/signal/slot_handle.h"
 #include <algorithm>
 #include <utility>
@@ -27,6 +28,10 @@ public:
   using slot_type = function<void(Args...)>;
 
   slot_handle connect(slot_type slot);
+  // calls `slot` by posting tasks to `runner` instead; emissions queued before disconnecting are dropped
+  slot_handle connect(slot_type slot, std::weak_ptr<task_runner> runner,
+    queued_delivery delivery = queued_delivery::all);
+
   void operator()(Args... args);
 
 private:
@@ -42,7 +47,7 @@ private:
     void block(bool block) override { blocked_ = block; }
     bool blocked() const override { return blocked_; }
 
-    void call(Args&... args) const { if (!blocked_) slot_(args...); }
+    void call(Args&... args) { if (!blocked_) slot_(args...); }
 
     signal* signal_;
     slot_type slot_;
@@ -68,6 +73,11 @@ slot_handle signal<Args...>::connect(slot_type slot) {
   return slot_handle(rep);
 }
 
+template<typename... Args>
+slot_handle signal<Args...>::connect(slot_type slot, std::weak_ptr<task_runner> runner, queued_delivery delivery) {
+  return connect(impl::make_queued_slot(std::move(slot), std::move(runner), delivery));
+}
+
 
 template<typename... Args>
 void signal<Args...>::operator()(Args... args) {
@@ -20,6 +20,8 @@ public:
 private:
   template<typename... Args>
   friend class signal;
+  template<typename... Args>
+  friend class concurrent_signal;
 
   explicit slot_handle(std::weak_ptr<impl::slot_rep_base> slot)
     : slot_(std::move(slot)) {
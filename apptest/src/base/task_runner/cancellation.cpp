@@ -3,7 +3,7 @@
 namespace base {
 
 bool cancellation_token::is_canceled() const {
-  return canceled_->load(std::memory_order_acquire);
+  return canceled_ && canceled_->load(std::memory_order_acquire);
 }
 
 cancellation_token::cancellation_token(std::shared_ptr<const std::atomic<bool>> canceled)
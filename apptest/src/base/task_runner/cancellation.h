@@ -10,6 +10,8 @@ class cancellation_tracker;
 
 class cancellation_token {
 public:
+  cancellation_token() = default;  // never canceled
+
   bool is_canceled() const;
 
 private:
@@ -2,7 +2,11 @@
 
 #include "base/future/future.h"
 #include "base/task_runner/task_runner.h"
+#include <iterator>
 #include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace base {
 
@@ -22,4 +26,28 @@ auto run_task(task_runner& runner, Cb&& callback) {
   return fut;
 }
 
+// Runs each callback of [first, last), which are moved from, on `runner`, posting them as a single batch.
+// Returns the futures of their results in the same order.
+template<typename It>
+auto run_tasks(task_runner& runner, It first, It last) {
+  using cb_type = typename std::iterator_traits<It>::value_type;
+  using ret_type = std::decay_t<std::invoke_result_t<cb_type>>;
+
+  std::vector<future<unwrap_future_t<ret_type>>> futs;
+  std::vector<task::callback_type> callbacks;
+  for (; first != last; ++first) {
+    promise<unwrap_future_t<ret_type>> prom;
+    futs.push_back(prom.get_future());
+
+    callbacks.push_back([callback = std::move(*first), prom = std::move(prom)]() mutable {
+      prom.set_from([&callback] {
+        return std::move(callback)();
+      });
+    });
+  }
+
+  runner.post_tasks(std::move(callbacks));
+  return futs;
+}
+
 }  // namespace base
\ No newline at end of file
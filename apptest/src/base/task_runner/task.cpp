@@ -2,9 +2,12 @@
 
 namespace base {
 
-task::task(callback_type callback, const run_time_type& run_time)
+task::task(callback_type callback, const run_time_type& run_time, cancellation_token token,
+    task_priority priority)
   : callback(std::move(callback))
-  , run_time(run_time) {}
+  , run_time(run_time)
+  , token(std::move(token))
+  , priority(priority) {}
 
 bool task::operator<(const task& rhs) const {
   return run_time > rhs.run_time;
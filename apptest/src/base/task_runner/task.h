@@ -1,20 +1,35 @@
 #pragma once
 
 #include "base/function.h"
+#include "base/task_runner/cancellation.h"
 #include <chrono>
 
 namespace base {
 
+// How urgently a task should run relative to the other tasks of its runner. Only loop_task_runner
+// distinguishes between priorities; other runners treat every task as `normal`.
+enum class task_priority {
+  high,  // e.g. responding to input; runs before normal tasks, which still get a regular share
+  normal,
+  idle  // runs only when there is nothing else to do
+};
+
+constexpr int task_priority_count = 3;
+
 struct task {
-  using callback_type = function<void()>;
+  // large enough for the continuations posted by future::then, which carry the promise and value along
+  using callback_type = basic_function<void(), 12 * sizeof(void*)>;
 
   using clock_type = std::chrono::steady_clock;
   using run_time_type = clock_type::time_point;
   using delay_type = run_time_type::duration;
 
-  task(callback_type callback, const run_time_type& run_time);
+  task(callback_type callback, const run_time_type& run_time, cancellation_token token = {},
+    task_priority priority = task_priority::normal);
   bool operator<(const task& rhs) const;
 
+  bool is_canceled() const { return token.is_canceled(); }
+
   // ensure that std::terminate is called if the callback throws
   void run() noexcept {
     callback();
@@ -22,6 +37,8 @@ struct task {
 
   callback_type callback;
   run_time_type run_time;
+  cancellation_token token;
+  task_priority priority;
 };
 
 }  // namespace base
@@ -3,18 +3,78 @@
 namespace base {
 
 void task_runner::post_task(task::callback_type callback) {
-  do_post_task(task(std::move(callback), task::run_time_type()));
+  post_task(std::move(callback), cancellation_token());
 }
 
 void task_runner::post_task(task::callback_type callback, task::delay_type delay) {
+  post_task(std::move(callback), delay, cancellation_token());
+}
+
+void task_runner::post_task(task::callback_type callback, task::run_time_type run_time) {
+  post_task(std::move(callback), run_time, cancellation_token());
+}
+
+
+void task_runner::post_task(task::callback_type callback, task_priority priority) {
+  post_task(std::move(callback), cancellation_token(), priority);
+}
+
+
+void task_runner::post_task(task::callback_type callback, cancellation_token token, task_priority priority) {
+  do_post_task(task(std::move(callback), task::run_time_type(), std::move(token), priority));
+}
+
+void task_runner::post_task(task::callback_type callback, task::delay_type delay, cancellation_token token,
+    task_priority priority) {
   auto run_time = delay > task::delay_type::zero() ?
     task::clock_type::now() + delay : task::run_time_type();
-  do_post_task(task(std::move(callback), run_time));
+  do_post_task(task(std::move(callback), run_time, std::move(token), priority));
 }
 
-void task_runner::post_task(task::callback_type callback, task::run_time_type run_time) {
+void task_runner::post_task(task::callback_type callback, task::run_time_type run_time, cancellation_token token,
+    task_priority priority) {
   auto computed_run_time = run_time <= task::clock_type::now() ? task::run_time_type() : run_time;
-  do_post_task(task(std::move(callback), computed_run_time));
+  do_post_task(task(std::move(callback), computed_run_time, std::move(token), priority));
+}
+
+
+void task_runner::post_tasks(std::vector<task::callback_type> callbacks) {
+  post_tasks(std::move(callbacks), cancellation_token());
+}
+
+void task_runner::post_tasks(std::vector<task::callback_type> callbacks, task::delay_type delay) {
+  post_tasks(std::move(callbacks), delay, cancellation_token());
+}
+
+void task_runner::post_tasks(std::vector<task::callback_type> callbacks, task_priority priority) {
+  post_tasks(std::move(callbacks), cancellation_token(), priority);
+}
+
+void task_runner::post_tasks(std::vector<task::callback_type> callbacks, cancellation_token token,
+    task_priority priority) {
+  post_tasks(std::move(callbacks), task::delay_type::zero(), std::move(token), priority);
+}
+
+void task_runner::post_tasks(std::vector<task::callback_type> callbacks, task::delay_type delay, cancellation_token token,
+    task_priority priority) {
+  auto run_time = delay > task::delay_type::zero() ?
+    task::clock_type::now() + delay : task::run_time_type();
+
+  std::vector<task> tasks;
+  tasks.reserve(callbacks.size());
+  for (auto& callback : callbacks) {
+    tasks.emplace_back(std::move(callback), run_time, token, priority);
+  }
+  do_post_tasks(std::move(tasks));
+}
+
+
+// PROTECTED
+
+void task_runner::do_post_tasks(std::vector<task>&& tasks) {
+  for (auto& tsk : tasks) {
+    do_post_task(std::move(tsk));
+  }
 }
 
 }  // namespace base
\ No newline at end of file
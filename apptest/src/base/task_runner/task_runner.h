@@ -1,7 +1,9 @@
 #pragma once
 
 #include "base/non_copyable.h"
+#include "base/task_runner/cancellation.h"
 #include "base/task_runner/task.h"
+#include <vector>
 
 namespace base {
 
@@ -12,9 +14,32 @@ public:
   void post_task(task::callback_type callback);
   void post_task(task::callback_type callback, task::delay_type delay);
   void post_task(task::callback_type callback, task::run_time_type run_time);
+  void post_task(task::callback_type callback, task_priority priority);
+
+  // the task is dropped without running if `token` is canceled first
+  void post_task(task::callback_type callback, cancellation_token token,
+    task_priority priority = task_priority::normal);
+  void post_task(task::callback_type callback, task::delay_type delay, cancellation_token token,
+    task_priority priority = task_priority::normal);
+  void post_task(task::callback_type callback, task::run_time_type run_time, cancellation_token token,
+    task_priority priority = task_priority::normal);
+
+  // Posts all of `callbacks` in order, as if by post_task; the runner is locked and woken up only
+  // once for the whole batch.
+  void post_tasks(std::vector<task::callback_type> callbacks);
+  void post_tasks(std::vector<task::callback_type> callbacks, task::delay_type delay);
+  void post_tasks(std::vector<task::callback_type> callbacks, task_priority priority);
+  void post_tasks(std::vector<task::callback_type> callbacks, cancellation_token token,
+    task_priority priority = task_priority::normal);
+  void post_tasks(std::vector<task::callback_type> callbacks, task::delay_type delay, cancellation_token token,
+    task_priority priority = task_priority::normal);
+
+  // whether the calling thread is one that runs this runner's tasks
+  virtual bool runs_tasks_on_current_thread() const = 0;
 
 protected:
   virtual void do_post_task(task&& tsk) = 0;
+  virtual void do_post_tasks(std::vector<task>&& tasks);  // posts the tasks one at a time by default
 };
 
 }  // namespace base
@@ -1,103 +1,161 @@
 #include "thread_name.h"
 
-#include "base/unicode.h"
-#include "base/win/last_error.h"
-#include <map>
-#include <mutex>
-#include <utility>
-#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
 
 namespace base {
 namespace {
 
-// Adapted from https://msdn.microsoft.com/en-us/library/xcb2z8hs.aspx
-
-constexpr DWORD thread_name_exception = 0x406D1388;
-
-#pragma pack(push, 8)
-typedef struct tagTHREADNAME_INFO {
-  DWORD dwType; // Must be 0x1000.  
-  LPCSTR szName; // Pointer to name (in user addr space).  
-  DWORD dwThreadID; // Thread ID (-1=caller thread).  
-  DWORD dwFlags; // Reserved for future use, must be zero.  
-} THREADNAME_INFO;
-#pragma pack(pop)  
-
-void set_debugger_thread_name(std::string_view name) {
-  THREADNAME_INFO info;
-  info.dwType = 0x1000;
-  info.szName = name.data();
-  info.dwThreadID = static_cast<DWORD>(-1);
-  info.dwFlags = 0;
-
-#pragma warning(push)
-#pragma warning(disable: 6320 6322) // constant EXCEPTION_EXECUTE_HANDLER, empty __except block
-  __try {
-    ::RaiseException(thread_name_exception, 0, sizeof(info) / sizeof(ULONG_PTR), reinterpret_cast<ULONG_PTR*>(&info));
-  } __except (EXCEPTION_EXECUTE_HANDLER) {}
-#pragma warning(pop)
-}
+constexpr std::size_t max_named_threads = 256;  // the rest are only named for the os
+constexpr std::size_t name_words = 8;
+constexpr std::size_t max_name_size = name_words * sizeof(std::uint64_t) - 1;  // leaving room for the nul
+
+// A registry slot, which only the thread owning it writes to. Readers use `seq` to detect that
+// they raced with a write (it's odd while the slot is being written), and retry.
+struct registry_slot {
+  std::atomic<std::uint32_t> seq = 0;
+  std::atomic<std::thread::id> owner = std::thread::id();
+  std::atomic<std::uint64_t> name[name_words] = {};  // nul-terminated
+};
+
+registry_slot registry[max_named_threads];
+std::atomic<std::size_t> registry_size = 0;  // no slot at or beyond this has ever been used
 
 
-using set_thread_desc_func = HRESULT(*)(HANDLE, PCWSTR);
+void write_slot(registry_slot& slot, std::thread::id owner, std::string_view name) {
+  std::uint64_t words[name_words] = {};
+  std::memcpy(words, name.data(), std::min(name.size(), max_name_size));
 
-void set_windows_thread_name(std::string_view name) {
-  static auto* set_thread_desc =
-    reinterpret_cast<set_thread_desc_func>(::GetProcAddress(::GetModuleHandleW(L"Kernel32.dll"), "SetThreadDescription"));
+  std::uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+  slot.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
 
-  // SetThreadDescription is new in win 10 v1703 (Creators Update)
-  if (set_thread_desc) {
-    win::throw_if_failed(
-      set_thread_desc(::GetCurrentThread(), widen(name).c_str()),
-      "Failed to set thread name"
-    );
-  } else if (::IsDebuggerPresent()) {  // fall back to older method (exception)
-    set_debugger_thread_name(name);
+  slot.owner.store(owner, std::memory_order_relaxed);
+  for (std::size_t i = 0; i < name_words; ++i) {
+    slot.name[i].store(words[i], std::memory_order_relaxed);
   }
+
+  slot.seq.store(seq + 2, std::memory_order_release);
 }
 
+bool read_slot(const registry_slot& slot, std::thread::id owner, std::string& name) {
+  for (;;) {
+    std::uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::thread::id slot_owner = slot.owner.load(std::memory_order_relaxed);
+    std::uint64_t words[name_words];
+    for (std::size_t i = 0; i < name_words; ++i) {
+      words[i] = slot.name[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) == seq) {
+      if (slot_owner != owner) {
+        return false;
+      }
+
+      name = reinterpret_cast<const char*>(words);
+      return true;
+    }
+  }
+}
 
-std::map<std::thread::id, std::string> thread_name_map;
-std::mutex thread_name_lock;
 
+// the current thread's slot, which is claimed the first time it is named
+class registry_entry {
+public:
+  ~registry_entry();
 
-struct thread_name_cleaner {
-  ~thread_name_cleaner();
+  void publish(std::string_view name);
+
+private:
+  registry_slot* claim();
+
+  registry_slot* slot_ = nullptr;
 };
 
-thread_name_cleaner::~thread_name_cleaner() {
-  std::scoped_lock hold(thread_name_lock);
+registry_entry::~registry_entry() {
+  if (slot_) {
+    write_slot(*slot_, std::thread::id(), "");
+  }
+}
 
-  auto it = thread_name_map.find(std::this_thread::get_id());
-  if (it != thread_name_map.end()) {
-    thread_name_map.erase(it);
+void registry_entry::publish(std::string_view name) {
+  if (slot_ || (slot_ = claim())) {
+    write_slot(*slot_, std::this_thread::get_id(), name);
   }
 }
 
-thread_local thread_name_cleaner cleaner;
+registry_slot* registry_entry::claim() {
+  for (std::size_t i = 0; i < max_named_threads; ++i) {
+    std::thread::id unowned;
+    if (registry[i].owner.load(std::memory_order_relaxed) == unowned
+        && registry[i].owner.compare_exchange_strong(unowned, std::this_thread::get_id())) {
+      std::size_t size = registry_size.load(std::memory_order_relaxed);
+      while (size <= i && !registry_size.compare_exchange_weak(size, i + 1)) {}
+      return &registry[i];
+    }
+  }
+  return nullptr;
+}
+
+
+thread_local std::string current_thread_name;
+thread_local registry_entry current_entry;
 
 }  // namespace
 
 void set_current_thread_name(std::string name) {
-  set_windows_thread_name(name.c_str());
+  // truncated here, so that the thread itself sees the same name as everyone else
+  impl::truncate_thread_name(name, max_name_size);
+
+  impl::set_native_thread_name(name);
 
-  std::scoped_lock hold(thread_name_lock);
-  thread_name_map[std::this_thread::get_id()] = std::move(name);
+  current_thread_name = std::move(name);
+  current_entry.publish(current_thread_name);
 }
 
 
 std::string get_thread_name(std::thread::id id) {
-  std::scoped_lock hold(thread_name_lock);
-  
-  auto it = thread_name_map.find(id);
-  if (it != thread_name_map.end()) {
-    return it->second;
+  if (id == std::this_thread::get_id()) {
+    return current_thread_name;
+  }
+
+  std::string name;
+  std::size_t size = registry_size.load(std::memory_order_acquire);
+  for (std::size_t i = 0; i < size; ++i) {
+    if (read_slot(registry[i], id, name)) {
+      return name;
+    }
   }
   return "";
 }
 
-std::string get_current_thread_name() {
-  return get_thread_name(std::this_thread::get_id());
+const std::string& get_current_thread_name() {
+  return current_thread_name;
+}
+
+
+namespace impl {
+
+void truncate_thread_name(std::string& name, std::size_t max_size) {
+  if (name.size() <= max_size) {
+    return;
+  }
+
+  std::size_t size = max_size;
+  while (size > 0 && (static_cast<unsigned char>(name[size]) & 0xc0) == 0x80) {
+    --size;  // don't split a utf-8 sequence
+  }
+  name.resize(size);
 }
 
+}  // namespace impl
 }  // namespace base
\ No newline at end of file
@@ -1,13 +1,25 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <thread>
 
 namespace base {
 
+// names are truncated to 63 bytes (without splitting utf-8 sequences)
 void set_current_thread_name(std::string name);
 
+// looking up other threads doesn't lock
 std::string get_thread_name(std::thread::id id);
-std::string get_current_thread_name();
+const std::string& get_current_thread_name();  // cached by the thread
 
+namespace impl {
+
+// names the thread for the os and debuggers; implemented per platform
+void set_native_thread_name(const std::string& name);
+
+// shortens `name` to at most `max_size` bytes, backing up so as not to split a utf-8 sequence
+void truncate_thread_name(std::string& name, std::size_t max_size);
+
+}  // namespace impl
 }  // namespace base
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "thread_pool.h"
+
+#include "base/assert.h"
+#include "base/thread/thread_name.h"
+#include <algorithm>
+#include <utility>
+
+namespace base {
+
+thread_pool::thread_pool(int worker_count)
+  : runner_(new thread_pool_task_runner(worker_count)) {
+  start("");
+}
+
+thread_pool::thread_pool(int worker_count, std::string name)
+  : runner_(new thread_pool_task_runner(worker_count)) {
+  start(name);
+}
+
+thread_pool::~thread_pool() {
+  stop();
+}
+
+
+void thread_pool::stop(bool wait) {
+  ASSERT(thread_pool_task_runner::current() != runner_) << "Attempting to stop thread pool from one of its workers";
+
+  runner_->quit();
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      wait ? thread.join() : thread.detach();
+    }
+  }
+}
+
+
+// static
+int thread_pool::default_worker_count() {
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+
+// PRIVATE
+
+void thread_pool::start(const std::string& name) {
+  int count = runner_->worker_count();
+  threads_.reserve(count);
+
+  for (int i = 0; i < count; i++) {
+    std::string worker_name = name.empty() ? std::string() : name + " " + std::to_string(i);
+
+    threads_.emplace_back([runner = runner_, i, worker_name = std::move(worker_name)]() mutable {
+      if (!worker_name.empty()) {
+        set_current_thread_name(std::move(worker_name));
+      }
+      thread_pool_task_runner::run_worker(std::move(runner), i);
+    });
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "base/non_copyable.h"
+#include "base/thread/thread_pool_task_runner.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+class thread_pool : public non_copy_movable {
+public:
+  explicit thread_pool(int worker_count = default_worker_count());
+  thread_pool(int worker_count, std::string name);
+  ~thread_pool();
+
+  // Tasks already queued are still run, but delayed tasks that are not yet due are discarded.
+  void stop(bool wait = true);
+
+  thread_pool_task_runner::ptr task_runner() const { return runner_; }
+  int worker_count() const { return runner_->worker_count(); }
+
+  static int default_worker_count();
+
+private:
+  void start(const std::string& name);  // workers are left unnamed if `name` is empty
+
+  thread_pool_task_runner::ptr runner_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace base
@@ -0,0 +1,261 @@
+#include "thread_pool_task_runner.h"
+
+#include "base/assert.h"
+#include <algorithm>
+#include <utility>
+
+namespace base {
+namespace {
+
+thread_local thread_pool_task_runner::ptr current_pool;
+thread_local int current_worker = -1;
+
+}  // namespace
+
+thread_pool_task_runner::thread_pool_task_runner(int worker_count) {
+  ASSERT(worker_count > 0) << "Thread pool must have at least one worker";
+
+  workers_.reserve(worker_count);
+  for (int i = 0; i < worker_count; i++) {
+    workers_.push_back(std::make_unique<worker_queue>());
+  }
+}
+
+
+bool thread_pool_task_runner::runs_tasks_on_current_thread() const {
+  return current_pool.get() == this;
+}
+
+
+// static
+thread_pool_task_runner::ptr thread_pool_task_runner::current() {
+  return current_pool;
+}
+
+
+// PRIVATE
+
+void thread_pool_task_runner::do_post_task(task&& tsk) {
+  if (tsk.run_time != task::run_time_type()) {
+    std::scoped_lock hold(sleep_lock_);
+    push_delayed_task(std::move(tsk));
+    return;
+  }
+
+  push_task(push_index(), std::move(tsk));
+}
+
+void thread_pool_task_runner::do_post_tasks(std::vector<task>&& tasks) {
+  auto is_delayed = [](const task& tsk) {
+    return tsk.run_time != task::run_time_type();
+  };
+
+  auto delayed_count = std::count_if(tasks.begin(), tasks.end(), is_delayed);
+  if (delayed_count) {
+    std::scoped_lock hold(sleep_lock_);
+    for (auto& tsk : tasks) {
+      if (is_delayed(tsk)) {
+        push_delayed_task(std::move(tsk));
+      }
+    }
+  }
+
+  auto count = static_cast<int>(tasks.size() - delayed_count);
+  if (!count) {
+    return;
+  }
+
+  // the whole batch goes to one worker, and idle workers steal from there
+  {
+    worker_queue& queue = *workers_[push_index()];
+    std::scoped_lock hold(queue.lock);
+    for (auto& tsk : tasks) {
+      if (!is_delayed(tsk)) {
+        queue.tasks.push_back(std::move(tsk));
+      }
+    }
+  }
+
+  queued_tasks_ += count;
+  if (sleeping_workers_.load()) {
+    wake_workers(count);
+  }
+}
+
+
+// static
+void thread_pool_task_runner::run_worker(ptr self, int index) {
+  current_pool = self;
+  current_worker = index;
+
+  while (auto tsk = self->next_task(index)) {
+    if (!tsk->is_canceled()) {
+      tsk->run();
+    }
+  }
+
+  current_worker = -1;
+  current_pool = nullptr;
+}
+
+void thread_pool_task_runner::quit() {
+  std::scoped_lock hold(sleep_lock_);
+  should_quit_ = true;
+  sleep_cv_.notify_all();
+}
+
+
+std::optional<task> thread_pool_task_runner::next_task(int index) {
+  while (true) {
+    // due delayed tasks go first, or a steady stream of immediate tasks would starve them
+    if (is_delayed_task_due()) {
+      std::scoped_lock hold(sleep_lock_);
+      if (auto tsk = pop_delayed_task()) {
+        return tsk;
+      }
+    }
+
+    if (auto tsk = pop_task(index)) {
+      return tsk;
+    }
+
+    std::unique_lock hold(sleep_lock_);
+    if (should_quit_) {
+      return std::nullopt;
+    }
+
+    if (auto tsk = pop_delayed_task()) {
+      return tsk;
+    }
+
+    // Announce that we are about to sleep *before* re-checking the queues - posters increment
+    // queued_tasks_ before checking sleeping_workers_, so one of us is guaranteed to notice.
+    ++sleeping_workers_;
+    if (!queued_tasks_.load()) {
+      if (delayed_tasks_.empty()) {
+        sleep_cv_.wait(hold);
+      } else {
+        auto run_time = delayed_tasks_.top().run_time;  // the queue may be reallocated while waiting
+        sleep_cv_.wait_until(hold, run_time);
+      }
+    }
+    --sleeping_workers_;
+  }
+}
+
+std::optional<task> thread_pool_task_runner::pop_task(int index) {
+  if (!queued_tasks_.load()) {
+    return std::nullopt;  // avoid touching every queue when the pool is idle
+  }
+
+  // own queue first (LIFO, as recently-spawned tasks are likely to be hot in cache)...
+  if (auto tsk = try_pop(*workers_[index], true)) {
+    return tsk;
+  }
+
+  // ...then steal the oldest tasks from the other workers
+  int count = worker_count();
+  for (int i = 1; i < count; i++) {
+    if (auto tsk = try_pop(*workers_[(index + i) % count], false)) {
+      return tsk;
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::optional<task> thread_pool_task_runner::try_pop(worker_queue& queue, bool back) {
+  std::scoped_lock hold(queue.lock);
+  if (queue.tasks.empty()) {
+    return std::nullopt;
+  }
+
+  std::optional<task> ret;
+  if (back) {
+    ret.emplace(std::move(queue.tasks.back()));
+    queue.tasks.pop_back();
+  } else {
+    ret.emplace(std::move(queue.tasks.front()));
+    queue.tasks.pop_front();
+  }
+  --queued_tasks_;
+
+  return ret;
+}
+
+std::optional<task> thread_pool_task_runner::pop_delayed_task() {
+  while (!delayed_tasks_.empty() && delayed_tasks_.top().is_canceled()) {
+    delayed_tasks_.pop();
+  }
+
+  if (delayed_tasks_.empty() || delayed_tasks_.top().run_time > task::clock_type::now()) {
+    update_next_delayed_run_time();
+    return std::nullopt;
+  }
+
+  std::optional<task> ret;
+  ret.emplace(std::move(const_cast<task&>(delayed_tasks_.top())));  // will still be at the top
+  delayed_tasks_.pop();
+  update_next_delayed_run_time();
+
+  // this task may not be the only one due, so let another worker check as well
+  if (!delayed_tasks_.empty()) {
+    sleep_cv_.notify_one();
+  }
+  return ret;
+}
+
+bool thread_pool_task_runner::is_delayed_task_due() const {
+  auto run_time = next_delayed_run_time_.load(std::memory_order_relaxed);
+  return run_time != no_delayed_task && run_time <= task::clock_type::now().time_since_epoch().count();
+}
+
+void thread_pool_task_runner::update_next_delayed_run_time() {
+  next_delayed_run_time_.store(
+    delayed_tasks_.empty() ? no_delayed_task : delayed_tasks_.top().run_time.time_since_epoch().count(),
+    std::memory_order_relaxed);
+}
+
+
+int thread_pool_task_runner::push_index() {
+  if (current_pool.get() == this) {
+    return current_worker;  // keep locally-spawned work on this worker
+  }
+  return static_cast<int>(next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size());
+}
+
+void thread_pool_task_runner::push_task(int index, task&& tsk) {
+  {
+    worker_queue& queue = *workers_[index];
+    std::scoped_lock hold(queue.lock);
+    queue.tasks.push_back(std::move(tsk));
+  }
+
+  ++queued_tasks_;
+  if (sleeping_workers_.load()) {
+    wake_workers(1);
+  }
+}
+
+void thread_pool_task_runner::push_delayed_task(task&& tsk) {
+  bool new_top = delayed_tasks_.empty() || tsk.run_time < delayed_tasks_.top().run_time;
+  delayed_tasks_.push(std::move(tsk));
+  if (new_top) {
+    update_next_delayed_run_time();
+    sleep_cv_.notify_one();  // a sleeping worker may have to wake up earlier
+  }
+}
+
+void thread_pool_task_runner::wake_workers(int count) {
+  // taking the lock ensures that the workers have actually started waiting
+  std::scoped_lock hold(sleep_lock_);
+  if (count >= sleeping_workers_.load()) {
+    sleep_cv_.notify_all();
+  } else {
+    for (int i = 0; i < count; i++) {
+      sleep_cv_.notify_one();
+    }
+  }
+}
+
+}  // namespace base
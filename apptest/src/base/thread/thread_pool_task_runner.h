@@ -0,0 +1,77 @@
+#pragma once
+
+#include "base/non_copyable.h"
+#include "base/task_runner/task_runner.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <vector>
+
+namespace base {
+
+class thread_pool;
+
+// Task runner distributing tasks across the workers of a thread_pool. Each worker owns a deque:
+// tasks posted from a worker go to the back of its own deque and are popped from there, while
+// idle workers steal from the front of other workers' deques. No ordering is guaranteed between
+// tasks.
+class thread_pool_task_runner : public task_runner {
+  friend thread_pool;
+
+  explicit thread_pool_task_runner(int worker_count);
+
+public:
+  using ptr = std::shared_ptr<thread_pool_task_runner>;
+
+  int worker_count() const { return static_cast<int>(workers_.size()); }
+
+  bool runs_tasks_on_current_thread() const override;
+
+  // returns the runner of the pool the calling thread belongs to, if any
+  static ptr current();
+
+private:
+  struct worker_queue {
+    std::deque<task> tasks;
+    std::mutex lock;  // protects tasks
+  };
+
+  using delayed_task_queue = std::priority_queue<task>;
+
+  void do_post_task(task&& tsk) override;
+  void do_post_tasks(std::vector<task>&& tasks) override;
+
+  static void run_worker(ptr self, int index);
+  void quit();
+
+  std::optional<task> next_task(int index);
+  std::optional<task> pop_task(int index);
+  std::optional<task> try_pop(worker_queue& queue, bool back);
+  std::optional<task> pop_delayed_task();  // requires sleep_lock_
+  bool is_delayed_task_due() const;
+  void update_next_delayed_run_time();  // requires sleep_lock_
+
+  int push_index();
+  void push_task(int index, task&& tsk);
+  void push_delayed_task(task&& tsk);  // requires sleep_lock_
+  void wake_workers(int count);
+
+  std::vector<std::unique_ptr<worker_queue>> workers_;
+  std::atomic<unsigned> next_worker_ = 0;  // round-robin target for posts from outside the pool
+  std::atomic<int> queued_tasks_ = 0;  // total number of tasks in all worker queues
+  std::atomic<int> sleeping_workers_ = 0;
+  // run time of the top delayed task, so that workers can check for due tasks without locking
+  std::atomic<task::delay_type::rep> next_delayed_run_time_ = no_delayed_task;
+  static constexpr task::delay_type::rep no_delayed_task = task::delay_type::max().count();
+
+  std::mutex sleep_lock_;  // protects delayed_tasks_, should_quit_
+  std::condition_variable sleep_cv_;
+  delayed_task_queue delayed_tasks_;
+  bool should_quit_ = false;
+};
+
+}  // namespace base
@@ -1,27 +1,10 @@
 #include "timer.h"
 
-#include "base/event_loop/next_tick.h"
+#include "base/event_loop/loop_task_runner.h"
 #include <utility>
 
 namespace base {
 
-struct timer::posted_task {
-  posted_task(timer* timer)
-    : timer_(timer) {}
-
-  void cancel() { timer_ = nullptr; }
-  void run();
-
-  timer* timer_;
-};
-
-void timer::posted_task::run() {
-  if (timer_) {
-    timer_->fire();
-  }
-}
-
-
 timer::timer(callback_type callback)
   : callback_(std::move(callback)) {
 }
@@ -32,14 +15,11 @@ timer::~timer() {
 
 
 void timer::cancel() {
-  if (is_running()) {
-    current_task_->cancel();
-    current_task_ = nullptr;
-  }
+  current_task_.cancel();
 }
 
 bool timer::is_running() const {
-  return current_task_ != nullptr;
+  return current_task_.is_pending();
 }
 
 
@@ -55,7 +35,6 @@ void timer::do_set(const task::delay_type& interval, bool repeat) {
 
   repeating_ = repeat;
   interval_ = interval;
-  current_task_ = std::make_shared<posted_task>(this);
 
   repost_task();
 }
@@ -67,15 +46,12 @@ void timer::fire() {
   }
 
   callback_();
-
-  if (!repeating_) {
-    current_task_ = nullptr;  // no need to cancel() here, as the task will never run again
-  }
 }
 
 
 void timer::repost_task() {
-  set_timeout([task = current_task_] { task->run(); }, interval_);
+  // the task is canceled (and removed from the runner's queues) if the timer dies first
+  loop_task_runner::current()->post_cancelable_task([this] { fire(); }, interval_, current_task_);
 }
 
-}  // namespace base
\ No newline at end of file
+}  // namespace base
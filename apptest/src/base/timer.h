@@ -1,10 +1,10 @@
 #pragma once
 
+#include "base/event_loop/delayed_task_handle.h"
 #include "base/function.h"
 #include "base/task_runner/task.h"
 #include "base/non_copyable.h"
 #include <chrono>
-#include <memory>
 
 namespace base {
 
@@ -24,8 +24,6 @@ public:
   void set_callback(callback_type callback);
 
 private:
-  struct posted_task;
-
   void do_set(const task::delay_type& delay, bool repeat);
   void fire();
   void repost_task();
@@ -33,7 +31,7 @@ private:
   bool repeating_;
   task::delay_type interval_;
 
-  std::shared_ptr<posted_task> current_task_;
+  delayed_task_handle current_task_;  // canceled automatically when the timer is destroyed
   callback_type callback_;
 };
 
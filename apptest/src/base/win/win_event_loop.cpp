@@ -98,13 +98,19 @@ LRESULT win_event_loop::handle_message(UINT msg) {
 
 
   switch (msg) {
-  case wake_msg:
-    if (run_pending_task()) {
+  case wake_msg: {
+    bool ran_task = run_pending_task();
+    ran_task |= run_delayed_task();
+    if (!ran_task) {
+      ran_task = run_idle_task();
+    }
+
+    if (ran_task) {
       // there may be more pending tasks, so make sure to check
       wake_up();
     }
-    run_delayed_task();
     break;
+  }
     
   case WM_TIMER:
     run_delayed_task();
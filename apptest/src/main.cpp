@@ -26,7 +26,10 @@ int wmain(int argc, const wchar_t** argv) {
 
   base::win::scoped_co_init init_com;
 
-  logging::init(std::make_unique<logging::stdout_sink>(), logging::level::trace, cmd_line.has_flag("logging-colorize"));
+  auto log_level = logging::parse_level(cmd_line.get_switch("log-level").value_or("trace"));
+  logging::init(std::make_unique<logging::stdout_sink>(), log_level.value_or(logging::level::trace),
+    cmd_line.has_flag("logging-colorize"));
+  logging::set_module_levels(cmd_line.get_switch("vmodule").value_or(""));
   
   base::loop_task_runner::init_for_this_thread();
   base::set_current_thread_name("Main");
@@ -0,0 +1,203 @@
+#include "fill_bands.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gfx::impl {
+namespace {
+
+// bands thinner than this aren't split any further, which bounds the work done for nearly
+// coincident edges
+constexpr double min_band_height = 1e-6;
+
+// the number of hit-testing bands grows with the number of edges up to this
+constexpr std::size_t max_band_count = 4096;
+
+// Each edge is listed in every band it overlaps, so tall edges would make the index grow with the
+// number of edges times the number of bands; there are only as many bands as keep it within about
+// this many entries per edge. A point is crossed by the tall edges anyway, whatever the banding.
+constexpr double max_band_entries_per_edge = 8;
+
+bool is_filled(int winding, fill_mode mode) {
+  return mode == fill_mode::winding ? winding != 0 : (winding & 1) != 0;
+}
+
+}  // namespace
+
+
+fill_bands::fill_bands(const flat_path& flat) {
+  for (const auto& contour : flat.contours) {
+    for (std::size_t i = contour.begin; i < contour.end; i++) {
+      const pointf& from = flat.points[i];
+      const pointf& to = flat.points[i + 1 < contour.end ? i + 1 : contour.begin];
+
+      if (from.y() == to.y()) {
+        continue;  // horizontal edges don't affect the winding number
+      }
+
+      double dxdy = (static_cast<double>(to.x()) - from.x()) / (static_cast<double>(to.y()) - from.y());
+      if (from.y() < to.y()) {
+        edges_.push_back({ from.x(), from.y(), to.y(), dxdy, 1 });
+      } else {
+        edges_.push_back({ to.x(), to.y(), from.y(), dxdy, -1 });
+      }
+      ys_.push_back(from.y());
+      ys_.push_back(to.y());
+    }
+  }
+
+  std::sort(edges_.begin(), edges_.end(), [](const edge& lhs, const edge& rhs) {
+    return lhs.y0 < rhs.y0;
+  });
+  std::sort(ys_.begin(), ys_.end());
+  ys_.erase(std::unique(ys_.begin(), ys_.end()), ys_.end());
+
+  if (edges_.empty()) {
+    return;
+  }
+
+  // an edge overlaps at most 2 + its height * band_scale_ bands
+  double height = ys_.back() - ys_.front();
+  double edge_heights = 0;
+  for (const auto& e : edges_) {
+    edge_heights += e.y1 - e.y0;
+  }
+
+  double max_bands = (max_band_entries_per_edge - 2) * edges_.size() * height / edge_heights;
+  std::size_t band_count = std::min(edges_.size(), max_band_count);
+  band_count = std::max<std::size_t>(1, std::min(band_count, static_cast<std::size_t>(max_bands)));
+  band_scale_ = band_count / height;
+
+  // count the edges in each band, then fill them in at the resulting offsets
+  band_begin_.assign(band_count + 1, 0);
+  for (const auto& e : edges_) {
+    for (std::size_t b = band_of(e.y0), last = band_of(e.y1); b <= last; b++) {
+      band_begin_[b + 1]++;
+    }
+  }
+  for (std::size_t b = 0; b < band_count; b++) {
+    band_begin_[b + 1] += band_begin_[b];
+  }
+
+  band_edges_.resize(band_begin_.back());
+  std::vector<std::uint32_t> fill(band_begin_.begin(), band_begin_.end() - 1);
+  for (std::size_t i = 0; i < edges_.size(); i++) {
+    for (std::size_t b = band_of(edges_[i].y0), last = band_of(edges_[i].y1); b <= last; b++) {
+      band_edges_[fill[b]++] = static_cast<std::uint32_t>(i);
+    }
+  }
+}
+
+
+double fill_bands::area(fill_mode mode) const {
+  struct active_edge {
+    const edge* e;
+    double x_top;
+    double x_bottom;
+  };
+
+  // ordered by x at the top of the band, then by x at its bottom; as the band only moves down,
+  // the order changes little between bands and insertion sort keeps it cheap
+  std::vector<active_edge> active;
+  auto sort_active = [&] {
+    for (std::size_t i = 1; i < active.size(); i++) {
+      active_edge cur = active[i];
+      std::size_t j = i;
+      for (; j > 0 && (cur.x_top < active[j - 1].x_top
+        || (cur.x_top == active[j - 1].x_top && cur.x_bottom < active[j - 1].x_bottom)); j--) {
+        active[j] = active[j - 1];
+      }
+      active[j] = cur;
+    }
+  };
+
+  double ret = 0;
+  std::size_t next_edge = 0;
+
+  for (std::size_t i = 0; i + 1 < ys_.size(); i++) {
+    double top = ys_[i];
+    double bottom = ys_[i + 1];
+
+    auto ended = std::remove_if(active.begin(), active.end(), [&](const active_edge& a) { return a.e->y1 <= top; });
+    active.erase(ended, active.end());
+    for (; next_edge < edges_.size() && edges_[next_edge].y0 <= top; next_edge++) {
+      active.push_back({ &edges_[next_edge], 0, 0 });  // x is computed below
+    }
+
+    // all edges span the whole band, as bands end at every end point; it is split further
+    // wherever two edges cross
+    while (top < bottom && !active.empty()) {
+      double height = bottom - top;
+      for (auto& a : active) {
+        a.x_top = a.e->x_at(top);
+        a.x_bottom = a.x_top + height * a.e->dxdy;
+      }
+      sort_active();
+
+      // the first crossing below the top is between edges adjacent there
+      double split = bottom;
+      for (std::size_t j = 0; j + 1 < active.size(); j++) {
+        double gap_top = active[j + 1].x_top - active[j].x_top;
+        double gap_bottom = active[j + 1].x_bottom - active[j].x_bottom;
+        if (gap_bottom < 0) {
+          double cross = top + height * gap_top / (gap_top - gap_bottom);
+          split = std::min(split, std::max(cross, top + min_band_height));
+        }
+      }
+
+      // each filled span is a trapezoid, with its width at the middle of the band as its mean
+      double width = 0;
+      int winding = 0;
+      for (const auto& a : active) {
+        double mid = a.x_top + (split - top) / 2 * a.e->dxdy;
+
+        bool was_filled = is_filled(winding, mode);
+        winding += a.e->winding;
+        bool filled = is_filled(winding, mode);
+
+        if (filled && !was_filled) {
+          width -= mid;
+        } else if (!filled && was_filled) {
+          width += mid;
+        }
+      }
+
+      ret += width * (split - top);
+      top = split;
+    }
+  }
+
+  return ret;
+}
+
+
+bool fill_bands::contains(const pointf& pt, fill_mode mode) const {
+  double x = pt.x();
+  double y = pt.y();
+  if (edges_.empty() || !(y >= ys_.front() && y < ys_.back())) {
+    return false;
+  }
+
+  // count the edges crossing the ray from `pt` to the right
+  int winding = 0;
+  std::size_t band = band_of(y);
+  for (std::uint32_t i = band_begin_[band]; i < band_begin_[band + 1]; i++) {
+    const edge& e = edges_[band_edges_[i]];
+    if (y >= e.y0 && y < e.y1 && e.x_at(y) > x) {
+      winding += e.winding;
+    }
+  }
+
+  return is_filled(winding, mode);
+}
+
+
+// PRIVATE
+
+std::size_t fill_bands::band_of(double y) const {
+  std::size_t band_count = band_begin_.size() - 1;
+  auto band = static_cast<std::size_t>(std::max(0.0, (y - ys_.front()) * band_scale_));
+  return std::min(band, band_count - 1);
+}
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/geom/path_verbs.h"
+#include "ui/gfx/geom/point.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx::impl {
+
+// The edges of a flattened path, prepared for computing what its fill covers. Every contour
+// is treated as closed, as when filling.
+//
+// For hit-testing, the vertical extent of the path is divided into equal bands, each listing
+// the edges overlapping it, so a query only looks at the edges near its scanline.
+class fill_bands {
+public:
+  explicit fill_bands(const flat_path& flat);
+
+  // sweeps the edges top to bottom, cutting the fill into bands in which no two edges cross
+  double area(fill_mode mode) const;
+
+  // whether `pt` is in the fill; edges include their left side and top, but not their right
+  // side and bottom, so that points on an edge shared by adjacent shapes hit only one of them
+  bool contains(const pointf& pt, fill_mode mode) const;
+
+private:
+  struct edge {
+    double x_at(double y) const { return x0 + (y - y0) * dxdy; }
+
+    double x0, y0;
+    double y1;  // > y0
+    double dxdy;
+    int winding;  // +1 for edges going down, -1 for edges going up
+  };
+
+  std::vector<edge> edges_;  // sorted by y0
+  std::vector<double> ys_;  // the distinct end point y values, sorted
+
+  std::size_t band_of(double y) const;
+
+  double band_scale_ = 0;  // bands per unit of y
+  std::vector<std::uint32_t> band_begin_;  // band i lists band_edges_[band_begin_[i], band_begin_[i + 1])
+  std::vector<std::uint32_t> band_edges_;  // indices into edges_
+};
+
+}  // namespace gfx::impl
\ No newline at end of file
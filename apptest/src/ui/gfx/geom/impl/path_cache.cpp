@@ -0,0 +1,52 @@
+#include "path_cache.h"
+
+#include <algorithm>
+
+namespace gfx::impl {
+
+bool stroked_path::contains(const pointf& pt) const {
+  return hit_grid_.get([&] {
+    return stroke_hit_grid(pieces_);
+  }).contains(pt);
+}
+
+
+const segment_list& path_cache::segments(path_view verbs) const {
+  return segments_.get([&] {
+    return make_segments(verbs);
+  });
+}
+
+const path_measure& path_cache::measure(path_view verbs) const {
+  return measure_.get([&] {
+    return path_measure(segments(verbs), precise_flattening_tolerance);
+  });
+}
+
+const fill_bands& path_cache::bands(path_view verbs) const {
+  return bands_.get([&] {
+    return fill_bands(flatten(segments(verbs), precise_flattening_tolerance));
+  });
+}
+
+std::shared_ptr<const stroked_path> path_cache::stroke(path_view verbs,
+  const stroke_params& params) const {
+  std::scoped_lock hold(strokes_lock_);
+
+  auto it = std::find_if(strokes_.begin(), strokes_.end(), [&](const auto& entry) {
+    return entry.first == params;
+  });
+  if (it != strokes_.end()) {
+    std::rotate(it, it + 1, strokes_.end());
+    return strokes_.back().second;
+  }
+
+  if (strokes_.size() == max_cached_strokes) {
+    strokes_.erase(strokes_.begin());
+  }
+  strokes_.emplace_back(params, std::make_shared<stroked_path>(
+    stroke_segments(segments(verbs), params, default_flattening_tolerance)));
+  return strokes_.back().second;
+}
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ui/gfx/geom/impl/fill_bands.h"
+#include "ui/gfx/geom/impl/path_measure.h"
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/geom/impl/path_stroker.h"
+#include "ui/gfx/geom/path_view.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace gfx::impl {
+
+// A value computed on first use; concurrent first uses compute it only once.
+template<typename T>
+class lazy_value {
+public:
+  template<typename F>
+  const T& get(F&& make) const {
+    std::call_once(once_, [&] { value_.emplace(make()); });
+    return *value_;
+  }
+
+private:
+  mutable std::once_flag once_;
+  mutable std::optional<T> value_;
+};
+
+
+// The stroke of a path, as produced by stroke_segments, and what is derived from it on demand.
+class stroked_path {
+public:
+  explicit stroked_path(flat_path pieces)
+    : pieces_(std::move(pieces)) {
+  }
+
+  // the overlapping polygons, to be filled with fill_mode::winding
+  const flat_path& pieces() const { return pieces_; }
+
+  bool contains(const pointf& pt) const;
+
+private:
+  flat_path pieces_;
+  lazy_value<stroke_hit_grid> hit_grid_;
+};
+
+
+// Data derived from the verbs of a path, shared by copies of the path until one of them is
+// modified. All members may be used concurrently.
+class path_cache {
+public:
+  const segment_list& segments(path_view verbs) const;
+  const path_measure& measure(path_view verbs) const;
+  const fill_bands& bands(path_view verbs) const;
+
+  // the last few strokes are kept, so that widening or hit-testing the stroke of an unchanged
+  // path again is free
+  std::shared_ptr<const stroked_path> stroke(path_view verbs,
+    const stroke_params& params) const;
+
+private:
+  static constexpr std::size_t max_cached_strokes = 4;
+
+  lazy_value<segment_list> segments_;
+  lazy_value<path_measure> measure_;
+  lazy_value<fill_bands> bands_;
+
+  mutable std::mutex strokes_lock_;
+  mutable std::vector<std::pair<stroke_params, std::shared_ptr<const stroked_path>>> strokes_;  // most recent last
+};
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,621 @@
+#include "path_clipper.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace gfx::impl {
+namespace {
+
+// intersections this close to an end point, or to each other, are moved onto one vertex, so that
+// edges meeting there share it exactly
+constexpr double vertex_snap_distance = 1e-7;
+
+// the sine of the angle below which edges are treated as parallel
+constexpr double parallel_sine = 1e-12;
+
+
+struct vertex {
+  double x, y;
+};
+
+bool operator==(const vertex& lhs, const vertex& rhs) {
+  return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+bool operator!=(const vertex& lhs, const vertex& rhs) {
+  return !(lhs == rhs);
+}
+
+bool operator<(const vertex& lhs, const vertex& rhs) {
+  return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.x < rhs.x);
+}
+
+vertex operator-(const vertex& lhs, const vertex& rhs) {
+  return { lhs.x - rhs.x, lhs.y - rhs.y };
+}
+
+double cross(const vertex& lhs, const vertex& rhs) {
+  return lhs.x * rhs.y - lhs.y * rhs.x;
+}
+
+double dot(const vertex& lhs, const vertex& rhs) {
+  return lhs.x * rhs.x + lhs.y * rhs.y;
+}
+
+double dist_squared(const vertex& lhs, const vertex& rhs) {
+  vertex d = lhs - rhs;
+  return dot(d, d);
+}
+
+
+struct clip_edge {
+  const vertex& top() const { return a < b ? a : b; }
+  const vertex& bottom() const { return a < b ? b : a; }
+
+  vertex a, b;
+  int operand;  // 0 or 1
+};
+
+struct split_point {
+  double t;  // along the edge being split
+  vertex pt;
+};
+
+
+void add_edges(const flat_path& flat, int operand, std::vector<clip_edge>& out) {
+  // every contour is closed, as when filling
+  for (const auto& contour : flat.contours) {
+    for (std::size_t i = contour.begin; i < contour.end; i++) {
+      const pointf& from = flat.points[i];
+      const pointf& to = flat.points[i + 1 < contour.end ? i + 1 : contour.begin];
+      if (from != to) {
+        out.push_back({ { from.x(), from.y() }, { to.x(), to.y() }, operand });
+      }
+    }
+  }
+}
+
+
+// records a split of `e` at `pt` if it lies strictly inside it
+void add_split(const clip_edge& e, const vertex& pt, std::vector<split_point>& splits) {
+  if (pt == e.a || pt == e.b) {
+    return;
+  }
+
+  vertex d = e.b - e.a;
+  double t = dot(pt - e.a, d) / dot(d, d);
+  if (t > 0 && t < 1) {
+    splits.push_back({ t, pt });
+  }
+}
+
+void intersect(const clip_edge& e1, const clip_edge& e2, std::vector<split_point>& splits1,
+  std::vector<split_point>& splits2) {
+  vertex d1 = e1.b - e1.a;
+  vertex d2 = e2.b - e2.a;
+  vertex r = e2.a - e1.a;
+
+  double len1 = std::sqrt(dot(d1, d1));
+  double len2 = std::sqrt(dot(d2, d2));
+  double den = cross(d1, d2);
+
+  if (std::abs(den) <= parallel_sine * len1 * len2) {
+    // only collinear edges can overlap; each is split at the end points of the other
+    if (std::abs(cross(d1, r)) <= vertex_snap_distance * len1) {
+      add_split(e1, e2.a, splits1);
+      add_split(e1, e2.b, splits1);
+      add_split(e2, e1.a, splits2);
+      add_split(e2, e1.b, splits2);
+    }
+    return;
+  }
+
+  double t = cross(r, d2) / den;
+  double u = cross(r, d1) / den;
+  double t_slack = vertex_snap_distance / len1;
+  double u_slack = vertex_snap_distance / len2;
+  if (t < -t_slack || t > 1 + t_slack || u < -u_slack || u > 1 + u_slack) {
+    return;
+  }
+
+  vertex pt = { e1.a.x + t * d1.x, e1.a.y + t * d1.y };
+  double snap = vertex_snap_distance * vertex_snap_distance;
+  for (const vertex& end : { e1.a, e1.b, e2.a, e2.b }) {
+    if (dist_squared(pt, end) <= snap) {
+      pt = end;
+      break;
+    }
+  }
+
+  add_split(e1, pt, splits1);
+  add_split(e2, pt, splits2);
+}
+
+// The same crossing is computed once per pair of edges through it, and the results can differ
+// in the last bit. Merges all split points within the snap distance of each other or of an end
+// point into one vertex, preferring end points, so that the pieces of edges lying on top of each
+// other end at exactly the same vertices.
+void merge_split_points(const std::vector<clip_edge>& edges, std::vector<std::vector<split_point>>& splits) {
+  struct candidate {
+    vertex pt;
+    bool is_end;
+  };
+  // contours are closed, so every end point starts an edge
+  std::vector<candidate> candidates;
+  for (const auto& e : edges) {
+    candidates.push_back({ e.a, true });
+  }
+  for (const auto& edge_splits : splits) {
+    for (const auto& split : edge_splits) {
+      candidates.push_back({ split.pt, false });
+    }
+  }
+
+  // by x, then y, with end points first among equal ones, which unique() keeps
+  auto x_less = [](const vertex& lhs, const vertex& rhs) {
+    return lhs.x < rhs.x || (lhs.x == rhs.x && lhs.y < rhs.y);
+  };
+  std::sort(candidates.begin(), candidates.end(), [&](const candidate& lhs, const candidate& rhs) {
+    return x_less(lhs.pt, rhs.pt) || (lhs.pt == rhs.pt && lhs.is_end > rhs.is_end);
+  });
+  candidates.erase(std::unique(candidates.begin(), candidates.end(), [](const candidate& lhs, const candidate& rhs) {
+    return lhs.pt == rhs.pt;
+  }), candidates.end());
+
+  // union-find, each set rooted at an end point if it has one
+  std::vector<std::size_t> parent(candidates.size());
+  for (std::size_t i = 0; i < parent.size(); i++) {
+    parent[i] = i;
+  }
+  auto find = [&](std::size_t i) {
+    while (parent[i] != i) {
+      i = parent[i] = parent[parent[i]];
+    }
+    return i;
+  };
+
+  // only points in a run spaced at most the snap distance apart by x can be merged; within a run
+  // they are compared by y
+  double snap = vertex_snap_distance * vertex_snap_distance;
+  std::vector<std::size_t> run;
+  for (std::size_t begin = 0; begin < candidates.size();) {
+    std::size_t end = begin + 1;
+    while (end < candidates.size() && candidates[end].pt.x - candidates[end - 1].pt.x <= vertex_snap_distance) {
+      end++;
+    }
+
+    run.clear();
+    for (std::size_t i = begin; i < end; i++) {
+      run.push_back(i);
+    }
+    std::sort(run.begin(), run.end(), [&](std::size_t lhs, std::size_t rhs) {
+      return candidates[lhs].pt.y < candidates[rhs].pt.y;
+    });
+
+    for (std::size_t i = 0; i < run.size(); i++) {
+      const vertex& pt = candidates[run[i]].pt;
+      for (std::size_t j = i + 1; j < run.size() && candidates[run[j]].pt.y - pt.y <= vertex_snap_distance; j++) {
+        std::size_t a = find(run[i]);
+        std::size_t b = find(run[j]);
+        if (a != b && dist_squared(pt, candidates[run[j]].pt) <= snap) {
+          if (!candidates[a].is_end && candidates[b].is_end) {
+            std::swap(a, b);
+          }
+          parent[b] = a;
+        }
+      }
+    }
+
+    begin = end;
+  }
+
+  for (std::size_t i = 0; i < edges.size(); i++) {
+    const clip_edge& e = edges[i];
+    vertex d = e.b - e.a;
+    auto& edge_splits = splits[i];
+    for (auto& split : edge_splits) {
+      auto it = std::lower_bound(candidates.begin(), candidates.end(), split.pt, [&](const candidate& c, const vertex& v) {
+        return x_less(c.pt, v);
+      });
+      split.pt = candidates[find(static_cast<std::size_t>(it - candidates.begin()))].pt;
+      split.t = dot(split.pt - e.a, d) / dot(d, d);
+    }
+
+    edge_splits.erase(std::remove_if(edge_splits.begin(), edge_splits.end(), [&](const split_point& split) {
+      return split.pt == e.a || split.pt == e.b;
+    }), edge_splits.end());
+  }
+}
+
+// splits all edges wherever they cross or overlap another one
+std::vector<clip_edge> split_edges(const std::vector<clip_edge>& edges) {
+  std::vector<std::vector<split_point>> splits(edges.size());
+
+  struct box {
+    double left, top, right, bottom;
+  };
+  std::vector<box> boxes(edges.size());
+  box all = { 0, 0, 0, 0 };
+  for (std::size_t i = 0; i < edges.size(); i++) {
+    const clip_edge& e = edges[i];
+    boxes[i] = { std::min(e.a.x, e.b.x), std::min(e.a.y, e.b.y), std::max(e.a.x, e.b.x), std::max(e.a.y, e.b.y) };
+    all = i == 0 ? boxes[i] : box{
+      std::min(all.left, boxes[i].left), std::min(all.top, boxes[i].top),
+      std::max(all.right, boxes[i].right), std::max(all.bottom, boxes[i].bottom)
+    };
+  }
+
+  // a grid of about one cell per edge; only edges sharing a cell are tested against each other
+  auto side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(edges.size()))));
+  side = std::max<std::size_t>(side, 1);
+  double scale_x = all.right > all.left ? side / (all.right - all.left) : 0;
+  double scale_y = all.bottom > all.top ? side / (all.bottom - all.top) : 0;
+  auto column = [&](double x) {
+    return std::min(static_cast<std::size_t>((x - all.left) * scale_x), side - 1);
+  };
+  auto row = [&](double y) {
+    return std::min(static_cast<std::size_t>((y - all.top) * scale_y), side - 1);
+  };
+
+  std::vector<std::uint32_t> cell_begin(side * side + 1);
+  auto for_each_cell = [&](const box& b, auto&& f) {
+    for (std::size_t r = row(b.top), last_row = row(b.bottom); r <= last_row; r++) {
+      for (std::size_t c = column(b.left), last_column = column(b.right); c <= last_column; c++) {
+        f(r * side + c);
+      }
+    }
+  };
+  for (const auto& b : boxes) {
+    for_each_cell(b, [&](std::size_t cell) { cell_begin[cell + 1]++; });
+  }
+  for (std::size_t cell = 0; cell < side * side; cell++) {
+    cell_begin[cell + 1] += cell_begin[cell];
+  }
+  std::vector<std::uint32_t> cell_edges(cell_begin.back());
+  std::vector<std::uint32_t> fill(cell_begin.begin(), cell_begin.end() - 1);
+  for (std::size_t i = 0; i < boxes.size(); i++) {
+    for_each_cell(boxes[i], [&](std::size_t cell) { cell_edges[fill[cell]++] = static_cast<std::uint32_t>(i); });
+  }
+
+  for (std::size_t cell = 0; cell < side * side; cell++) {
+    for (std::uint32_t i = cell_begin[cell]; i < cell_begin[cell + 1]; i++) {
+      for (std::uint32_t j = i + 1; j < cell_begin[cell + 1]; j++) {
+        std::uint32_t e1 = cell_edges[i];
+        std::uint32_t e2 = cell_edges[j];
+        const box& b1 = boxes[e1];
+        const box& b2 = boxes[e2];
+
+        double left = std::max(b1.left, b2.left);
+        double top = std::max(b1.top, b2.top);
+        if (left > std::min(b1.right, b2.right) || top > std::min(b1.bottom, b2.bottom)) {
+          continue;
+        }
+
+        // pairs sharing several cells are tested in the one holding the corner of their overlap
+        if (row(top) * side + column(left) == cell) {
+          intersect(edges[e1], edges[e2], splits[e1], splits[e2]);
+        }
+      }
+    }
+  }
+
+  merge_split_points(edges, splits);
+
+  std::vector<clip_edge> ret;
+  ret.reserve(edges.size());
+
+  for (std::size_t i = 0; i < edges.size(); i++) {
+    auto& edge_splits = splits[i];
+    std::sort(edge_splits.begin(), edge_splits.end(), [](const split_point& lhs, const split_point& rhs) {
+      return lhs.t < rhs.t;
+    });
+
+    vertex from = edges[i].a;
+    for (const auto& split : edge_splits) {
+      if (split.pt != from) {
+        ret.push_back({ from, split.pt, edges[i].operand });
+        from = split.pt;
+      }
+    }
+    if (from != edges[i].b) {
+      ret.push_back({ from, edges[i].b, edges[i].operand });
+    }
+  }
+
+  return ret;
+}
+
+
+// the winding numbers of both operands on either side of a group of edges lying on top of each
+// other; "inner" is the side the fill is on if the group's first edge runs clockwise
+struct side_windings {
+  int inner[2];
+  int outer[2];
+};
+
+// Sweeps the split edges top to bottom to find the winding numbers on both sides of each group.
+// As no two edges cross, the winding number right of an edge is the same along its length, and
+// the one left of a new edge is the one right of its left neighbor in the sweep.
+std::vector<side_windings> classify_groups(const std::vector<clip_edge>& edges,
+  const std::vector<std::uint32_t>& groups, const std::vector<std::uint32_t>& representatives) {
+  std::size_t group_count = representatives.size();
+
+  // what crossing each group adds to the winding number, right to left
+  std::vector<std::array<int, 2>> contributions(group_count);
+  for (std::size_t i = 0; i < edges.size(); i++) {
+    if (edges[i].a.y != edges[i].b.y) {
+      contributions[groups[i]][edges[i].operand] += edges[i].a.y < edges[i].b.y ? 1 : -1;
+    }
+  }
+
+  auto rep = [&](std::uint32_t group) -> const clip_edge& {
+    return edges[representatives[group]];
+  };
+  auto dxdy = [&](std::uint32_t group) {
+    const clip_edge& e = rep(group);
+    return (e.bottom().x - e.top().x) / (e.bottom().y - e.top().y);
+  };
+
+  std::vector<std::uint32_t> starts;
+  std::vector<std::uint32_t> horizontals;
+  std::vector<double> ys;
+  for (std::uint32_t group = 0; group < group_count; group++) {
+    const clip_edge& e = rep(group);
+    (e.a.y == e.b.y ? horizontals : starts).push_back(group);
+    ys.push_back(e.a.y);
+    ys.push_back(e.b.y);
+  }
+
+  std::sort(ys.begin(), ys.end());
+  ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+  // edges starting at the same y are added left to right, so that each new edge's left neighbor
+  // is already final
+  std::vector<double> slopes(group_count);
+  for (std::uint32_t group : starts) {
+    slopes[group] = dxdy(group);
+  }
+  std::sort(starts.begin(), starts.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+    const vertex& l = rep(lhs).top();
+    const vertex& r = rep(rhs).top();
+    return l < r || (l == r && slopes[lhs] < slopes[rhs]);
+  });
+  std::vector<std::uint32_t> ends = starts;
+  std::sort(ends.begin(), ends.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+    return rep(lhs).bottom().y < rep(rhs).bottom().y;
+  });
+  std::sort(horizontals.begin(), horizontals.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+    return rep(lhs).a.y < rep(rhs).a.y;
+  });
+
+  double sweep_y = 0;
+  auto x_at = [&](std::uint32_t group) {
+    const clip_edge& e = rep(group);
+    const vertex& top = e.top();
+    const vertex& bottom = e.bottom();
+    if (sweep_y == top.y) {
+      return top.x;
+    } else if (sweep_y == bottom.y) {
+      return bottom.x;
+    }
+    return top.x + (sweep_y - top.y) * slopes[group];
+  };
+
+  // the edges crossing the sweep line, left to right just below it
+  struct status_less {
+    using is_transparent = void;
+
+    bool operator()(std::uint32_t lhs, std::uint32_t rhs) const {
+      double l = (*x_on_line)(lhs);
+      double r = (*x_on_line)(rhs);
+      return l < r || (l == r && (*slopes)[lhs] < (*slopes)[rhs]);
+    }
+    bool operator()(double lhs, std::uint32_t rhs) const { return lhs < (*x_on_line)(rhs); }
+    bool operator()(std::uint32_t lhs, double rhs) const { return (*x_on_line)(lhs) < rhs; }
+
+    const decltype(x_at)* x_on_line;
+    const std::vector<double>* slopes;
+  };
+  using status_set = std::multiset<std::uint32_t, status_less>;
+  status_set status(status_less{ &x_at, &slopes });
+  std::vector<status_set::iterator> handles(group_count);
+
+  std::vector<std::array<int, 2>> right_of(group_count);
+  std::vector<side_windings> ret(group_count);
+
+  auto winding_left_of = [&](status_set::iterator it) {
+    return it == status.begin() ? std::array<int, 2>{} : right_of[*std::prev(it)];
+  };
+
+  std::size_t next_start = 0;
+  std::size_t next_end = 0;
+  std::size_t next_horizontal = 0;
+
+  for (double y : ys) {
+    sweep_y = y;
+
+    // horizontal edges are looked up just above the line, then below it once it is updated
+    std::size_t horizontal_begin = next_horizontal;
+    for (; next_horizontal < horizontals.size() && rep(horizontals[next_horizontal]).a.y == y; next_horizontal++) {
+      std::uint32_t group = horizontals[next_horizontal];
+      const clip_edge& e = rep(group);
+      auto above = winding_left_of(status.upper_bound((e.a.x + e.b.x) / 2));
+
+      // running right, the fill of a clockwise edge is below it
+      std::copy(above.begin(), above.end(), e.a.x < e.b.x ? ret[group].outer : ret[group].inner);
+    }
+
+    for (; next_end < ends.size() && rep(ends[next_end]).bottom().y == y; next_end++) {
+      status.erase(handles[ends[next_end]]);
+    }
+
+    for (; next_start < starts.size() && rep(starts[next_start]).top().y == y; next_start++) {
+      std::uint32_t group = starts[next_start];
+      auto it = status.insert(group);
+      handles[group] = it;
+
+      std::array<int, 2> left = winding_left_of(it);
+      for (int op = 0; op < 2; op++) {
+        right_of[group][op] = left[op] - contributions[group][op];
+      }
+
+      // running down, the fill of a clockwise edge is left of it
+      const clip_edge& e = rep(group);
+      bool down = e.a.y < e.b.y;
+      std::copy(left.begin(), left.end(), down ? ret[group].inner : ret[group].outer);
+      std::copy(right_of[group].begin(), right_of[group].end(), down ? ret[group].outer : ret[group].inner);
+    }
+
+    for (std::size_t i = horizontal_begin; i < next_horizontal; i++) {
+      std::uint32_t group = horizontals[i];
+      const clip_edge& e = rep(group);
+      auto below = winding_left_of(status.upper_bound((e.a.x + e.b.x) / 2));
+      std::copy(below.begin(), below.end(), e.a.x < e.b.x ? ret[group].inner : ret[group].outer);
+    }
+  }
+
+  return ret;
+}
+
+
+bool is_filled(int winding, fill_mode mode) {
+  return mode == fill_mode::winding ? winding != 0 : (winding & 1) != 0;
+}
+
+bool apply_op(path_op op, bool lhs, bool rhs) {
+  switch (op) {
+  case path_op::combine:
+    return lhs || rhs;
+  case path_op::intersect:
+    return lhs && rhs;
+  case path_op::diff:
+    return lhs && !rhs;
+  case path_op::symmetric_diff:
+    return lhs != rhs;
+  }
+  return false;
+}
+
+
+// chains directed edges into closed contours, dropping points in the middle of straight runs
+flat_path link_edges(std::vector<clip_edge>& edges) {
+  std::sort(edges.begin(), edges.end(), [](const clip_edge& lhs, const clip_edge& rhs) {
+    return lhs.a < rhs.a;
+  });
+
+  std::vector<bool> used(edges.size());
+  auto next_from = [&](const vertex& pt) -> const clip_edge* {
+    auto it = std::lower_bound(edges.begin(), edges.end(), pt, [](const clip_edge& e, const vertex& v) {
+      return e.a < v;
+    });
+    for (; it != edges.end() && it->a == pt; ++it) {
+      if (!used[it - edges.begin()]) {
+        used[it - edges.begin()] = true;
+        return &*it;
+      }
+    }
+    return nullptr;
+  };
+
+  flat_path ret;
+  std::vector<vertex> contour;
+
+  for (std::size_t i = 0; i < edges.size(); i++) {
+    if (used[i]) {
+      continue;
+    }
+    used[i] = true;
+
+    contour.clear();
+    contour.push_back(edges[i].a);
+    const clip_edge* cur = &edges[i];
+
+    // stops at the start, or early if rounding broke the chain; the contour is closed anyway
+    while (cur && cur->b != contour.front()) {
+      if (contour.size() >= 2) {
+        const vertex& prev = contour[contour.size() - 2];
+        vertex in = contour.back() - prev;
+        vertex out = cur->b - contour.back();
+        if (cross(in, out) == 0 && dot(in, out) > 0) {
+          contour.pop_back();
+        }
+      }
+      contour.push_back(cur->b);
+      cur = next_from(cur->b);
+    }
+
+    if (contour.size() < 3) {
+      continue;
+    }
+
+    std::size_t begin = ret.points.size();
+    for (const auto& v : contour) {
+      ret.points.push_back({ static_cast<float>(v.x), static_cast<float>(v.y) });
+    }
+    ret.points.push_back(ret.points[begin]);
+    ret.contours.push_back({ begin, ret.points.size(), true });
+  }
+
+  return ret;
+}
+
+}  // namespace
+
+
+flat_path clip_paths(const flat_path& lhs, fill_mode lhs_mode, const flat_path& rhs,
+  fill_mode rhs_mode, path_op op) {
+  std::vector<clip_edge> input;
+  add_edges(lhs, 0, input);
+  add_edges(rhs, 1, input);
+
+  std::vector<clip_edge> edges = split_edges(input);
+
+  // edges lying on top of each other form a group, classified once
+  std::vector<std::pair<vertex, vertex>> keys(edges.size());
+  std::vector<std::uint32_t> order(edges.size());
+  for (std::size_t i = 0; i < edges.size(); i++) {
+    keys[i] = { edges[i].top(), edges[i].bottom() };
+    order[i] = static_cast<std::uint32_t>(i);
+  }
+  std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+    const auto& l = keys[a];
+    const auto& r = keys[b];
+    return l.first < r.first || (l.first == r.first && l.second < r.second);
+  });
+
+  std::vector<std::uint32_t> groups(edges.size());
+  std::vector<std::uint32_t> representatives;
+  for (std::size_t i = 0; i < order.size(); i++) {
+    if (i == 0 || keys[order[i]] != keys[order[i - 1]]) {
+      representatives.push_back(order[i]);
+    }
+    groups[order[i]] = static_cast<std::uint32_t>(representatives.size() - 1);
+  }
+
+  std::vector<side_windings> windings = classify_groups(edges, groups, representatives);
+  fill_mode modes[2] = { lhs_mode, rhs_mode };
+
+  auto filled = [&](const int (&winding)[2]) {
+    return apply_op(op, is_filled(winding[0], modes[0]), is_filled(winding[1], modes[1]));
+  };
+
+  std::vector<clip_edge> boundary;
+  for (std::uint32_t group = 0; group < representatives.size(); group++) {
+    const clip_edge& e = edges[representatives[group]];
+    bool inner_filled = filled(windings[group].inner);
+    if (inner_filled != filled(windings[group].outer)) {
+      boundary.push_back(inner_filled ? e : clip_edge{ e.b, e.a, e.operand });
+    }
+  }
+
+  return link_edges(boundary);
+}
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/geom/path_verbs.h"
+
+namespace gfx::impl {
+
+// Applies `op` to the fills of two flattened paths, and returns the outline of the result as
+// closed contours to be filled with fill_mode::winding.
+//
+// All edges are split where they cross or overlap. Each piece is kept if the result is filled
+// on exactly one of its sides, and is oriented to run clockwise around the result (as seen with
+// y pointing down). The pieces are then chained back into contours.
+flat_path clip_paths(const flat_path& lhs, fill_mode lhs_mode, const flat_path& rhs,
+  fill_mode rhs_mode, path_op op);
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "path_measure.h"
+
+#include "ui/gfx/util.h"
+#include <algorithm>
+
+namespace gfx::impl {
+
+path_measure::path_measure(const segment_list& segments, float tolerance)
+  : segments_(segments.segments) {
+  float dist = 0;
+
+  for (std::size_t i = 0; i < segments_.size(); i++) {
+    const path_segment& seg = segments_[i];
+    samples_.push_back({ dist, i, 0.f });
+
+    pointf prev = seg.start();
+    flatten_segment(seg, tolerance, [&](float t, const pointf& pt) {
+      dist += mag(pt - prev);
+      samples_.push_back({ dist, i, t });
+      prev = pt;
+    });
+  }
+}
+
+
+std::pair<pointf, pointf> path_measure::point_tangent_at(float dist) const {
+  if (samples_.empty()) {
+    return {};
+  }
+
+  dist = std::clamp(dist, 0.f, length());
+
+  // first sample past `dist`; the previous one starts the chord containing it
+  auto it = std::upper_bound(samples_.begin(), samples_.end(), dist, [](float d, const sample& s) {
+    return d < s.dist;
+  });
+
+  const sample* from;
+  const sample* to;
+  if (it == samples_.end()) {
+    to = &samples_.back();
+    from = to - 1;
+  } else {
+    from = &*(it - 1);
+    to = &*it;
+  }
+
+  float t = to->t;
+  float chord = to->dist - from->dist;
+  if (chord > 0) {
+    t = lerp(from->t, to->t, (dist - from->dist) / chord);
+  }
+
+  const path_segment& seg = segments_[to->segment];
+  pointf tangent = seg.derivative(t);
+  if (mag_squared(tangent) == 0) {
+    // degenerate control points, e.g. a cubic whose first control point is its start
+    tangent = seg.end() - seg.start();
+  }
+
+  return { seg.eval(t), mag_squared(tangent) > 0 ? to_unit(tangent) : pointf() };
+}
+
+}  // namespace gfx::impl
\ No newline at end of file
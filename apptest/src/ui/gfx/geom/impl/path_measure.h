@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/geom/point.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace gfx::impl {
+
+// Arc-length table over the flattened segments of a path, mapping distances along the path back
+// to curve parameters. Queries are a binary search followed by one curve evaluation.
+class path_measure {
+public:
+  path_measure(const segment_list& segments, float tolerance);
+
+  float length() const { return samples_.empty() ? 0.f : samples_.back().dist; }
+
+  // the point at distance `dist` along the path (clamped to the path), and the unit tangent there
+  std::pair<pointf, pointf> point_tangent_at(float dist) const;
+
+private:
+  struct sample {
+    float dist;  // from the start of the path
+    std::size_t segment;
+    float t;
+  };
+
+  std::vector<path_segment> segments_;
+  std::vector<sample> samples_;
+};
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "path_segments.h"
+
+#include "base/assert.h"
+#include "ui/gfx/util.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace gfx::impl {
+namespace {
+
+// more than enough for anything visible; also bounds the work done for huge or broken coordinates
+constexpr int max_flattening_steps = 1024;
+
+// arcs are approximated by one cubic per quarter turn (at most)
+constexpr double max_arc_piece = half_pi<double>;
+
+
+double vec_angle(double ux, double uy, double vx, double vy) {
+  return std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+}
+
+// calls `add(t)` for each t in (0, 1) at which the derivative of `coords` is zero
+template<typename F>
+void for_each_extremum(const float* coords, int degree, F&& add) {
+  if (degree == 2) {
+    double den = static_cast<double>(coords[0]) - 2.0 * coords[1] + coords[2];
+    if (den != 0) {
+      add((static_cast<double>(coords[0]) - coords[1]) / den);
+    }
+  } else if (degree == 3) {
+    // B'(t)/3 = a t^2 + b t + c
+    double a = -static_cast<double>(coords[0]) + 3.0 * coords[1] - 3.0 * coords[2] + coords[3];
+    double b = 2.0 * (static_cast<double>(coords[0]) - 2.0 * coords[1] + coords[2]);
+    double c = static_cast<double>(coords[1]) - coords[0];
+
+    if (std::abs(a) < 1e-12) {
+      if (b != 0) {
+        add(-c / b);
+      }
+      return;
+    }
+
+    double disc = b * b - 4 * a * c;
+    if (disc < 0) {
+      return;
+    }
+    double root = std::sqrt(disc);
+    add((-b + root) / (2 * a));
+    add((-b - root) / (2 * a));
+  }
+}
+
+}  // namespace
+
+
+void add_arc_segments(std::vector<path_segment>& out, const pointf& start, const pointf& end,
+  const arc_params& arc) {
+  // following the SVG implementation notes for converting the endpoint parameterization to the
+  // center one
+  if (start == end) {
+    return;  // an arc to the same point draws nothing
+  }
+
+  double rx = std::abs(arc.radius.width());
+  double ry = std::abs(arc.radius.height());
+  if (rx == 0 || ry == 0) {
+    out.push_back({ segment_kind::line, { start, end } });
+    return;
+  }
+
+  double cos_phi = std::cos(arc.rotation_angle);
+  double sin_phi = std::sin(arc.rotation_angle);
+
+  // the start point relative to the midpoint of the chord, in the ellipse's frame
+  double dx2 = (static_cast<double>(start.x()) - end.x()) / 2;
+  double dy2 = (static_cast<double>(start.y()) - end.y()) / 2;
+  double x1 = cos_phi * dx2 + sin_phi * dy2;
+  double y1 = -sin_phi * dx2 + cos_phi * dy2;
+
+  // scale up radii which are too small for the ellipse to reach the end point
+  double lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+  if (lambda > 1) {
+    rx *= std::sqrt(lambda);
+    ry *= std::sqrt(lambda);
+  }
+
+  double num = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+  double den = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+  double coef = std::sqrt(std::max(0.0, num / den));
+
+  bool large = arc.size == arc_size::large_arc;
+  bool clockwise = arc.dir == sweep_dir::clockwise;  // increasing angles, as the y axis points down
+  if (large == clockwise) {
+    coef = -coef;
+  }
+
+  double cx1 = coef * rx * y1 / ry;
+  double cy1 = -coef * ry * x1 / rx;
+
+  double cx = cos_phi * cx1 - sin_phi * cy1 + (static_cast<double>(start.x()) + end.x()) / 2;
+  double cy = sin_phi * cx1 + cos_phi * cy1 + (static_cast<double>(start.y()) + end.y()) / 2;
+
+  double ux = (x1 - cx1) / rx;
+  double uy = (y1 - cy1) / ry;
+  double vx = (-x1 - cx1) / rx;
+  double vy = (-y1 - cy1) / ry;
+
+  double theta = vec_angle(1, 0, ux, uy);
+  double sweep = vec_angle(ux, uy, vx, vy);
+  if (clockwise && sweep < 0) {
+    sweep += two_pi<double>;
+  } else if (!clockwise && sweep > 0) {
+    sweep -= two_pi<double>;
+  }
+
+  auto map = [&](double x, double y) {
+    x *= rx;
+    y *= ry;
+    return pointf(
+      static_cast<float>(cos_phi * x - sin_phi * y + cx),
+      static_cast<float>(sin_phi * x + cos_phi * y + cy)
+    );
+  };
+
+  int pieces = std::max(1, static_cast<int>(std::ceil(std::abs(sweep) / max_arc_piece - 1e-9)));
+  double step = sweep / pieces;
+  double k = 4.0 / 3 * std::tan(step / 4);
+
+  pointf from = start;
+  for (int i = 0; i < pieces; i++) {
+    double a = theta + i * step;
+    double b = a + step;
+    double cos_a = std::cos(a), sin_a = std::sin(a);
+    double cos_b = std::cos(b), sin_b = std::sin(b);
+
+    // the exact end points are used at both ends, so that rounding can't open up gaps
+    pointf to = i == pieces - 1 ? end : map(cos_b, sin_b);
+    out.push_back({ segment_kind::cubic, {
+      from,
+      map(cos_a - k * sin_a, sin_a + k * cos_a),
+      map(cos_b + k * sin_b, sin_b - k * cos_b),
+      to
+    } });
+    from = to;
+  }
+}
+
+
+pointf path_segment::eval(float t) const {
+  float mt = 1 - t;
+
+  if (kind == segment_kind::line) {
+    return pts[0] * mt + pts[1] * t;
+  } else if (kind == segment_kind::quad) {
+    return pts[0] * (mt * mt) + pts[1] * (2 * mt * t) + pts[2] * (t * t);
+  } else {
+    return pts[0] * (mt * mt * mt) + pts[1] * (3 * mt * mt * t) + pts[2] * (3 * mt * t * t)
+      + pts[3] * (t * t * t);
+  }
+}
+
+pointf path_segment::derivative(float t) const {
+  float mt = 1 - t;
+
+  if (kind == segment_kind::line) {
+    return pts[1] - pts[0];
+  } else if (kind == segment_kind::quad) {
+    return (pts[1] - pts[0]) * (2 * mt) + (pts[2] - pts[1]) * (2 * t);
+  } else {
+    return (pts[1] - pts[0]) * (3 * mt * mt) + (pts[2] - pts[1]) * (6 * mt * t)
+      + (pts[3] - pts[2]) * (3 * t * t);
+  }
+}
+
+int path_segment::flattening_steps(float tolerance) const {
+  if (kind == segment_kind::line) {
+    return 1;
+  }
+
+  // Wang's formula: the largest second difference of the control points bounds the deviation
+  float dd = mag(pts[0] - 2 * pts[1] + pts[2]);
+  float factor = 2.f / 8;
+  if (kind == segment_kind::cubic) {
+    dd = std::max(dd, mag(pts[1] - 2 * pts[2] + pts[3]));
+    factor = 6.f / 8;
+  }
+
+  float steps = std::ceil(std::sqrt(factor * dd / tolerance));
+  if (!(steps >= 1)) {
+    return 1;  // also catches NaN
+  }
+  return static_cast<int>(std::min(steps, static_cast<float>(max_flattening_steps)));
+}
+
+
+segment_list make_segments(path_view verbs) {
+  segment_list out;
+  bool in_figure = false;
+  std::size_t figure_begin = 0;
+
+  pointf last_move_to;
+  pointf current;
+
+  auto end_figure = [&](bool closed) {
+    if (out.segments.size() > figure_begin) {
+      out.figures.push_back({ figure_begin, out.segments.size(), closed });
+    }
+    in_figure = false;
+  };
+
+  auto begin_figure = [&](const pointf& start) {
+    if (in_figure) {
+      end_figure(false);
+    }
+
+    figure_begin = out.segments.size();
+    last_move_to = current = start;
+    in_figure = true;
+  };
+
+  for (auto it = verbs.begin(); it != verbs.end(); ++it) {
+    const pointf* pts = it.points();
+
+    if (it.kind() == verb_kind::move) {
+      begin_figure(pts[0]);
+      continue;
+    }
+
+    if (it.kind() == verb_kind::close) {
+      if (in_figure) {
+        if (current != last_move_to) {
+          out.segments.push_back({ segment_kind::line, { current, last_move_to } });
+        }
+        end_figure(true);
+        current = last_move_to;
+      }
+      continue;
+    }
+
+    if (!in_figure) {
+      begin_figure(last_move_to);
+    }
+
+    switch (it.kind()) {
+    case verb_kind::line:
+      out.segments.push_back({ segment_kind::line, { current, pts[0] } });
+      break;
+    case verb_kind::quad:
+      out.segments.push_back({ segment_kind::quad, { current, pts[0], pts[1] } });
+      break;
+    case verb_kind::cubic:
+      out.segments.push_back({ segment_kind::cubic, { current, pts[0], pts[1], pts[2] } });
+      break;
+    default:
+      add_arc_segments(out.segments, current, pts[0], it.arc());
+      break;
+    }
+    current = pts[point_count(it.kind()) - 1];
+  }
+
+  if (in_figure) {
+    end_figure(false);
+  }
+
+  return out;
+}
+
+
+rectf segment_bounds(const segment_list& segments) {
+  if (segments.segments.empty()) {
+    return {};
+  }
+
+  float left = segments.segments.front().start().x();
+  float right = left;
+  float top = segments.segments.front().start().y();
+  float bottom = top;
+
+  auto add_point = [&](const pointf& pt) {
+    left = std::min(left, pt.x());
+    right = std::max(right, pt.x());
+    top = std::min(top, pt.y());
+    bottom = std::max(bottom, pt.y());
+  };
+
+  for (const auto& seg : segments.segments) {
+    add_point(seg.start());
+    add_point(seg.end());
+
+    float xs[4], ys[4];
+    for (int i = 0; i <= seg.degree(); i++) {
+      xs[i] = seg.pts[i].x();
+      ys[i] = seg.pts[i].y();
+    }
+
+    auto add_extremum = [&](double t) {
+      if (t > 0 && t < 1) {
+        add_point(seg.eval(static_cast<float>(t)));
+      }
+    };
+    for_each_extremum(xs, seg.degree(), add_extremum);
+    for_each_extremum(ys, seg.degree(), add_extremum);
+  }
+
+  return { rectf::by_xywh, left, top, right - left, bottom - top };
+}
+
+
+flat_path flatten(const segment_list& segments, float tolerance) {
+  ASSERT(tolerance > 0) << "Flattening tolerance must be positive";
+
+  flat_path ret;
+  ret.points.reserve(segments.segments.size() * 2);
+
+  for (const auto& figure : segments.figures) {
+    std::size_t begin = ret.points.size();
+    ret.points.push_back(segments.segments[figure.begin].start());
+
+    for (std::size_t i = figure.begin; i < figure.end; i++) {
+      flatten_segment(segments.segments[i], tolerance, [&](float, const pointf& pt) {
+        ret.points.push_back(pt);
+      });
+    }
+
+    ret.contours.push_back({ begin, ret.points.size(), figure.closed });
+  }
+
+  return ret;
+}
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ui/gfx/geom/path_verbs.h"
+#include "ui/gfx/geom/path_view.h"
+#include "ui/gfx/geom/point.h"
+#include "ui/gfx/geom/rect.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx::impl {
+
+// used where the result is a number rather than something drawn, e.g. lengths and areas
+constexpr float precise_flattening_tolerance = 0.01f;
+
+
+enum class segment_kind : std::uint8_t {
+  line = 1,  // the values are the degrees of the curves
+  quad = 2,
+  cubic = 3
+};
+
+// A line or Bezier curve with an explicit start point; arcs are approximated by cubics.
+struct path_segment {
+  int degree() const { return static_cast<int>(kind); }
+
+  const pointf& start() const { return pts[0]; }
+  const pointf& end() const { return pts[degree()]; }
+
+  pointf eval(float t) const;
+  pointf derivative(float t) const;
+
+  // the number of lines needed for the distance from the curve to stay within `tolerance`
+  int flattening_steps(float tolerance) const;
+
+  segment_kind kind;
+  pointf pts[4];
+};
+
+// segments [begin, end) of a segment_list, forming one connected figure
+struct path_figure {
+  std::size_t begin;
+  std::size_t end;
+  bool closed;  // if so, the last segment ends at the start of the first one
+};
+
+// A path broken down into figures of segments, with the same figure structure Direct2D sees in
+// path::stream_to. Figures without any segments are dropped.
+struct segment_list {
+  std::vector<path_segment> segments;
+  std::vector<path_figure> figures;
+};
+
+segment_list make_segments(path_view verbs);
+
+// Appends the cubics approximating an elliptical arc from `start` to `end` (or a line, if a radius
+// is zero).
+void add_arc_segments(std::vector<path_segment>& out, const pointf& start, const pointf& end,
+  const arc_params& arc);
+
+// the exact bounds of the segments (not of their control points)
+rectf segment_bounds(const segment_list& segments);
+
+
+// calls `emit(t, pt)` with the end points of the lines approximating `seg`, excluding its start point
+template<typename F>
+void flatten_segment(const path_segment& seg, float tolerance, F&& emit) {
+  int steps = seg.flattening_steps(tolerance);
+  for (int i = 1; i < steps; i++) {
+    float t = static_cast<float>(i) / steps;
+    emit(t, seg.eval(t));
+  }
+  emit(1.f, seg.end());
+}
+
+
+// a path reduced to polylines
+struct flat_path {
+  struct contour {
+    std::size_t begin;  // range in `points`
+    std::size_t end;
+    bool closed;  // if so, the last point repeats the first one
+  };
+
+  std::vector<pointf> points;
+  std::vector<contour> contours;
+};
+
+flat_path flatten(const segment_list& segments, float tolerance);
+
+}  // namespace gfx::impl
\ No newline at end of file
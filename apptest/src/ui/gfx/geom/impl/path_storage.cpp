@@ -0,0 +1,149 @@
+#include "path_storage.h"
+
+#include "base/assert.h"
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/transform.h"
+#include <algorithm>
+#include <utility>
+#include <variant>
+
+namespace gfx::impl {
+
+void path_storage::arc_to(const pointf& end, const arc_params& arc) {
+  add(verb_kind::arc, { end });
+  arcs_.push_back(arc);
+}
+
+void path_storage::push_back(const path_verb& verb) {
+  struct append_visitor {
+    void operator()(const path_verbs::move& move) { out->move_to(move.to); }
+    void operator()(const path_verbs::close&) { out->close(); }
+    void operator()(const path_verbs::line& line) { out->line_to(line.to); }
+    void operator()(const path_verbs::quad& quad) { out->quad_to(quad.ctrl, quad.end); }
+    void operator()(const path_verbs::cubic& cubic) { out->cubic_to(cubic.ctrl1, cubic.ctrl2, cubic.end); }
+    void operator()(const path_verbs::arc& arc) {
+      out->arc_to(arc.end, { arc.radius, arc.rotation_angle, arc.size, arc.dir });
+    }
+
+    path_storage* out;
+  };
+
+  std::visit(append_visitor{ this }, verb);
+}
+
+
+path_view::iterator path_storage::insert(path_view::iterator where, path_view verbs) {
+  std::size_t verb = where.verb_ - verbs_.data();
+  std::size_t point = where.point_ - points_.data();
+  std::size_t arc = where.arc_ - arcs_.data();
+  ASSERT(verb <= verbs_.size()) << "Insertion point is not in this path";
+
+  verbs_.insert(verbs_.begin() + verb, verbs.verbs().begin(), verbs.verbs().end());
+  points_.insert(points_.begin() + point, verbs.points().begin(), verbs.points().end());
+  arcs_.insert(arcs_.begin() + arc, verbs.arcs().begin(), verbs.arcs().end());
+  return at(verb, point, arc);
+}
+
+path_view::iterator path_storage::erase(path_view::iterator first, path_view::iterator last) {
+  std::size_t verb = first.verb_ - verbs_.data();
+  std::size_t point = first.point_ - points_.data();
+  std::size_t arc = first.arc_ - arcs_.data();
+  ASSERT(verb <= verbs_.size() && last.verb_ >= first.verb_) << "Erased range is not in this path";
+
+  verbs_.erase(verbs_.begin() + verb, verbs_.begin() + (last.verb_ - verbs_.data()));
+  points_.erase(points_.begin() + point, points_.begin() + (last.point_ - points_.data()));
+  arcs_.erase(arcs_.begin() + arc, arcs_.begin() + (last.arc_ - arcs_.data()));
+  return at(verb, point, arc);
+}
+
+void path_storage::clear() {
+  verbs_.clear();
+  points_.clear();
+  arcs_.clear();
+}
+
+
+void path_storage::swap(path_storage& other) noexcept {
+  verbs_.swap(other.verbs_);
+  points_.swap(other.points_);
+  arcs_.swap(other.arcs_);
+}
+
+
+path_storage path_storage::transformed(const mat33f& tform) const {
+  auto apply = [&](const pointf& pt) {
+    return transform::apply(tform, pt);
+  };
+
+  // drawing before the first move starts at the origin, which has to be made explicit to move too
+  auto first_drawn = std::find_if(verbs_.begin(), verbs_.end(), [](verb_kind kind) {
+    return kind != verb_kind::close;
+  });
+  bool starts_with_move = first_drawn == verbs_.end() || *first_drawn == verb_kind::move;
+
+  path_storage ret;
+  if (arcs_.empty() && starts_with_move) {
+    ret.verbs_ = verbs_;
+    ret.points_.reserve(points_.size());
+    for (const auto& pt : points_) {
+      ret.points_.push_back(apply(pt));
+    }
+    return ret;
+  }
+
+  pointf current;
+  pointf last_move_to;
+  bool moved = starts_with_move;
+  std::vector<path_segment> arc_segments;
+
+  path_view verbs = view();
+  for (auto it = verbs.begin(); it != verbs.end(); ++it) {
+    const pointf* pts = it.points();
+    std::size_t count = point_count(it.kind());
+
+    if (!moved && it.kind() != verb_kind::close) {
+      if (it.kind() != verb_kind::move) {
+        ret.move_to(apply(last_move_to));
+      }
+      moved = true;
+    }
+
+    if (it.kind() == verb_kind::arc) {
+      arc_segments.clear();
+      add_arc_segments(arc_segments, current, pts[0], it.arc());
+      for (const auto& seg : arc_segments) {
+        if (seg.kind == segment_kind::line) {
+          ret.line_to(apply(seg.pts[1]));
+        } else {
+          ret.cubic_to(apply(seg.pts[1]), apply(seg.pts[2]), apply(seg.pts[3]));
+        }
+      }
+    } else {
+      ret.verbs_.push_back(it.kind());
+      for (std::size_t i = 0; i < count; i++) {
+        ret.points_.push_back(apply(pts[i]));
+      }
+    }
+
+    if (it.kind() == verb_kind::move) {
+      last_move_to = pts[0];
+    }
+    current = count > 0 ? pts[count - 1] : last_move_to;
+  }
+
+  return ret;
+}
+
+
+// PRIVATE
+
+void path_storage::add(verb_kind kind, std::initializer_list<pointf> points) {
+  verbs_.push_back(kind);
+  points_.insert(points_.end(), points);
+}
+
+path_view::iterator path_storage::at(std::size_t verb, std::size_t point, std::size_t arc) const {
+  return { verbs_.data() + verb, points_.data() + point, arcs_.data() + arc };
+}
+
+}  // namespace gfx::impl
\ No newline at end of file
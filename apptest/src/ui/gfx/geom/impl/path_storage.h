@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ui/gfx/geom/path_verbs.h"
+#include "ui/gfx/geom/path_view.h"
+#include "ui/gfx/geom/point.h"
+#include "ui/gfx/matrix.h"
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace gfx::impl {
+
+// The verbs of a path in the compact form described by path_view, with the edits path offers.
+// Iterators are invalidated by any edit, as with std::vector.
+class path_storage {
+public:
+  path_view view() const { return { verbs_, points_, arcs_ }; }
+
+  bool empty() const { return verbs_.empty(); }
+  std::size_t size() const { return verbs_.size(); }
+
+  void move_to(const pointf& to) { add(verb_kind::move, { to }); }
+  void close() { add(verb_kind::close, {}); }
+  void line_to(const pointf& to) { add(verb_kind::line, { to }); }
+  void quad_to(const pointf& ctrl, const pointf& end) { add(verb_kind::quad, { ctrl, end }); }
+  void cubic_to(const pointf& ctrl1, const pointf& ctrl2, const pointf& end) {
+    add(verb_kind::cubic, { ctrl1, ctrl2, end });
+  }
+  void arc_to(const pointf& end, const arc_params& arc);
+
+  void push_back(const path_verb& verb);
+
+  // `verbs` must not be a view of this storage
+  path_view::iterator insert(path_view::iterator where, path_view verbs);
+  path_view::iterator erase(path_view::iterator first, path_view::iterator last);
+  void clear();
+
+  void swap(path_storage& other) noexcept;
+
+  // The verbs with all their points transformed by `tform`, in a single pass over the points
+  // unless there are arcs. Those are replaced by the cubics approximating them, as an arc's
+  // radii and rotation don't transform like points.
+  path_storage transformed(const mat33f& tform) const;
+
+private:
+  void add(verb_kind kind, std::initializer_list<pointf> points);
+
+  // the iterator at the given offsets into each array
+  path_view::iterator at(std::size_t verb, std::size_t point, std::size_t arc) const;
+
+  std::vector<verb_kind> verbs_;
+  std::vector<pointf> points_;  // point_count(kind) for each verb
+  std::vector<arc_params> arcs_;  // one for each arc verb
+};
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,541 @@
+#include "path_stroker.h"
+
+#include "ui/gfx/util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+
+namespace gfx::impl {
+namespace {
+
+// bounds the work done for absurdly fine dash patterns; figures needing more are stroked solid
+constexpr double max_dashes_per_figure = 1e5;
+
+// more than enough for anything visible
+constexpr int max_arc_steps = 256;
+
+// the number of hit-testing cells grows with the number of polygons up to this
+constexpr std::size_t max_cell_count = 1 << 16;
+
+
+float cross(const pointf& lhs, const pointf& rhs) {
+  return lhs.x() * rhs.y() - lhs.y() * rhs.x();
+}
+
+// `dir` turned a quarter turn counter-clockwise (as seen with y pointing down)
+pointf normal(const pointf& dir) {
+  return { -dir.y(), dir.x() };
+}
+
+pointf rotate(const pointf& vec, float angle) {
+  float c = std::cos(angle);
+  float s = std::sin(angle);
+  return { vec.x() * c - vec.y() * s, vec.x() * s + vec.y() * c };
+}
+
+// computed in double, so that very short lines still get a direction
+pointf direction(const pointf& from, const pointf& to) {
+  double dx = static_cast<double>(to.x()) - from.x();
+  double dy = static_cast<double>(to.y()) - from.y();
+  double len = std::sqrt(dx * dx + dy * dy);
+  return { static_cast<float>(dx / len), static_cast<float>(dy / len) };
+}
+
+void push_point(std::vector<pointf>& points, const pointf& pt) {
+  if (points.empty() || points.back() != pt) {
+    points.push_back(pt);
+  }
+}
+
+
+// a polyline to be stroked: a whole figure, or one dash of it
+struct stroke_piece {
+  std::vector<pointf> points;  // no two consecutive points are equal
+  bool closed = false;  // if so, the first point is not repeated at the end
+  stroke_cap_style start_cap = stroke_cap_style::flat;
+  stroke_cap_style end_cap = stroke_cap_style::flat;
+  pointf dir;  // the direction at the start, used to cap pieces reduced to a single point
+};
+
+
+class stroker {
+public:
+  stroker(const stroke_params& params, float tolerance);
+
+  // `points` must not contain two consecutive equal points, nor repeat the first one at the end
+  void add_figure(std::vector<pointf> points, bool closed);
+
+  flat_path take() { return std::move(out_); }
+
+private:
+  void add_dashes(const std::vector<pointf>& points, bool closed);
+  void add_piece(const stroke_piece& piece);
+
+  void add_line(const pointf& from, const pointf& to, const pointf& dir);
+  void add_join(const pointf& pt, const pointf& in_dir, const pointf& out_dir);
+  void add_cap(const pointf& pt, const pointf& dir, stroke_cap_style cap);
+
+  // adds the points turning `from` by `sweep` around `center`, except the first and last ones
+  void add_arc(const pointf& center, const pointf& from, float sweep);
+  void end_polygon();
+
+  const stroke_params& params_;
+  float half_width_;
+  float arc_step_;  // the largest angle an arc of radius half_width_ may turn per line
+  std::vector<double> dashes_;  // scaled by the width, with an even count; empty if solid
+  double dash_length_ = 0;
+
+  std::vector<pointf> polygon_;  // being built
+  flat_path out_;
+};
+
+
+stroker::stroker(const stroke_params& params, float tolerance)
+  : params_(params), half_width_(params.width / 2) {
+  arc_step_ = tolerance < half_width_ ? 2 * std::acos(1 - tolerance / half_width_) : half_pi<float>;
+
+  bool valid = true;
+  for (float dash : params.dashes) {
+    valid = valid && dash >= 0;
+    dashes_.push_back(static_cast<double>(dash) * params.width);
+    dash_length_ += dashes_.back();
+  }
+
+  if (!valid || !(dash_length_ > 0)) {
+    dashes_.clear();  // nothing sensible to repeat; stroke solid
+  } else if (dashes_.size() % 2) {
+    // as in SVG, an odd pattern is repeated to alternate between dashes and gaps
+    dashes_.insert(dashes_.end(), dashes_.begin(), dashes_.end());
+    dash_length_ *= 2;
+  }
+}
+
+void stroker::add_figure(std::vector<pointf> points, bool closed) {
+  if (points.size() < 2) {
+    // a lone point has no outline, but still gets caps (e.g. dots for round caps) if open
+    if (!closed) {
+      add_piece({ std::move(points), false, params_.start_cap, params_.end_cap, { 1, 0 } });
+    }
+    return;
+  }
+
+  if (!dashes_.empty()) {
+    add_dashes(points, closed);
+  } else {
+    add_piece({ std::move(points), closed, params_.start_cap, params_.end_cap, {} });
+  }
+}
+
+
+// PRIVATE
+
+void stroker::add_dashes(const std::vector<pointf>& points, bool closed) {
+  std::size_t count = closed ? points.size() + 1 : points.size();
+  auto at = [&](std::size_t i) -> const pointf& {
+    return points[i % points.size()];
+  };
+
+  double length = 0;
+  for (std::size_t i = 1; i < count; i++) {
+    length += mag(at(i) - at(i - 1));
+  }
+  if (length / dash_length_ > max_dashes_per_figure) {
+    add_piece({ points, closed, params_.start_cap, params_.end_cap, {} });
+    return;
+  }
+
+  // find where in the pattern the figure starts; a positive offset shifts the pattern back
+  double phase = std::fmod(static_cast<double>(params_.dash_offset) * params_.width, dash_length_);
+  if (phase < 0) {
+    phase += dash_length_;
+  }
+  std::size_t idx = 0;
+  for (std::size_t i = 0; i < dashes_.size() && phase >= dashes_[idx]; i++) {
+    phase -= dashes_[idx];
+    idx = (idx + 1) % dashes_.size();
+  }
+
+  double remain = std::max(0.0, dashes_[idx] - phase);  // in the current dash or gap
+  bool on = idx % 2 == 0;
+  bool on_at_start = on;
+
+  std::vector<stroke_piece> pieces;
+  stroke_piece current;
+  if (on) {
+    current = { { at(0) }, false, closed ? params_.dash_cap : params_.start_cap,
+      params_.dash_cap, direction(at(0), at(1)) };
+  }
+
+  for (std::size_t i = 1; i < count; i++) {
+    const pointf& from = at(i - 1);
+    const pointf& to = at(i);
+    pointf dir = direction(from, to);
+    double len = mag(to - from);
+
+    double pos = 0;
+    while (remain <= len - pos) {
+      pos += remain;
+      pointf pt = from + dir * static_cast<float>(pos);
+
+      if (on) {
+        push_point(current.points, pt);
+        pieces.push_back(std::move(current));
+        current = {};
+      } else {
+        current = { { pt }, false, params_.dash_cap, params_.dash_cap, dir };
+      }
+
+      idx = (idx + 1) % dashes_.size();
+      remain = dashes_[idx];
+      on = !on;
+    }
+
+    remain -= len - pos;
+    if (on) {
+      push_point(current.points, to);
+    }
+  }
+
+  if (on) {
+    current.end_cap = closed ? params_.dash_cap : params_.end_cap;
+    pieces.push_back(std::move(current));
+
+    if (closed && on_at_start) {
+      if (pieces.size() == 1) {
+        // a single dash covering the whole figure
+        add_piece({ points, true, params_.start_cap, params_.end_cap, {} });
+        return;
+      }
+
+      // the dashes running into the end and out of the start of a closed figure are one dash
+      stroke_piece& last = pieces.back();
+      stroke_piece& first = pieces.front();
+      last.points.insert(last.points.end(), first.points.begin() + 1, first.points.end());
+      last.end_cap = first.end_cap;
+      first = std::move(last);
+      pieces.pop_back();
+    }
+  }
+
+  for (const auto& piece : pieces) {
+    add_piece(piece);
+  }
+}
+
+void stroker::add_piece(const stroke_piece& piece) {
+  const auto& pts = piece.points;
+  if (pts.size() == 1) {
+    add_cap(pts[0], -piece.dir, piece.start_cap);
+    add_cap(pts[0], piece.dir, piece.end_cap);
+    return;
+  }
+
+  std::size_t lines = piece.closed ? pts.size() : pts.size() - 1;
+  pointf first_dir;
+  pointf prev_dir;
+  for (std::size_t i = 0; i < lines; i++) {
+    const pointf& from = pts[i];
+    const pointf& to = pts[(i + 1) % pts.size()];
+    pointf dir = direction(from, to);
+
+    add_line(from, to, dir);
+    if (i > 0) {
+      add_join(from, prev_dir, dir);
+    } else {
+      first_dir = dir;
+    }
+    prev_dir = dir;
+  }
+
+  if (piece.closed) {
+    add_join(pts[0], prev_dir, first_dir);
+  } else {
+    add_cap(pts.front(), -first_dir, piece.start_cap);
+    add_cap(pts.back(), prev_dir, piece.end_cap);
+  }
+}
+
+
+void stroker::add_line(const pointf& from, const pointf& to, const pointf& dir) {
+  pointf offset = normal(dir) * half_width_;
+  polygon_.insert(polygon_.end(), { from + offset, to + offset, to - offset, from - offset });
+  end_polygon();
+}
+
+void stroker::add_join(const pointf& pt, const pointf& in_dir, const pointf& out_dir) {
+  float turn = cross(in_dir, out_dir);
+  if (turn == 0 && dot(in_dir, out_dir) > 0) {
+    return;  // straight on; the lines already meet
+  }
+
+  // the lines leave a gap on the outer side of the turn, between `a` and `b`
+  float side = turn > 0 ? -half_width_ : half_width_;
+  pointf in_offset = normal(in_dir) * side;
+  pointf out_offset = normal(out_dir) * side;
+  pointf a = pt + in_offset;
+  pointf b = pt + out_offset;
+
+  polygon_.insert(polygon_.end(), { pt, a });
+
+  if (params_.line_join == stroke_line_join::round) {
+    // turning back, either way round would do; go around the front, as caps do
+    float sweep = turn == 0 ? -pi<float> : std::atan2(cross(in_offset, out_offset), dot(in_offset, out_offset));
+    add_arc(pt, in_offset, sweep);
+  } else if (params_.line_join != stroke_line_join::bevel) {
+    // the tip where the outer edges meet is half_width_ / cos(turn / 2) from `pt`, along the
+    // bisector of the offsets, whose length is 2 * half_width_ * cos(turn / 2)
+    pointf bisector = in_offset + out_offset;
+    float bisector_len = mag(bisector);
+    float limit = std::max(params_.miter_limit, 1.f);
+
+    if (bisector_len * limit >= 2 * half_width_) {
+      polygon_.push_back(pt + bisector * (2 * half_width_ * half_width_ / (bisector_len * bisector_len)));
+    } else if (params_.line_join == stroke_line_join::miter) {
+      // cut the miter off square to the bisector, `limit` half widths from `pt`
+      pointf axis = bisector_len > 0 ? bisector / bisector_len : in_dir;
+      float clip = limit * half_width_;
+      float in_along = dot(in_dir, axis);
+      float out_along = -dot(out_dir, axis);
+      if (in_along > 0 && out_along > 0) {
+        polygon_.push_back(a + in_dir * ((clip - dot(in_offset, axis)) / in_along));
+        polygon_.push_back(b - out_dir * ((clip - dot(out_offset, axis)) / out_along));
+      }
+    }
+  }
+
+  polygon_.push_back(b);
+  end_polygon();
+}
+
+void stroker::add_cap(const pointf& pt, const pointf& dir, stroke_cap_style cap) {
+  pointf offset = normal(dir) * half_width_;
+  pointf ahead = dir * half_width_;
+
+  switch (cap) {
+  case stroke_cap_style::flat:
+    return;
+  case stroke_cap_style::square:
+    polygon_.insert(polygon_.end(), { pt + offset, pt + offset + ahead, pt - offset + ahead, pt - offset });
+    break;
+  case stroke_cap_style::round:
+    polygon_.push_back(pt + offset);
+    add_arc(pt, offset, -pi<float>);  // through `pt + ahead`
+    polygon_.push_back(pt - offset);
+    break;
+  case stroke_cap_style::tri:
+    polygon_.insert(polygon_.end(), { pt + offset, pt + ahead, pt - offset });
+    break;
+  }
+  end_polygon();
+}
+
+
+void stroker::add_arc(const pointf& center, const pointf& from, float sweep) {
+  float steps = std::ceil(std::abs(sweep) / arc_step_);
+  int count = steps >= 1 ? static_cast<int>(std::min(steps, static_cast<float>(max_arc_steps))) : 1;
+  for (int i = 1; i < count; i++) {
+    polygon_.push_back(center + rotate(from, sweep * i / count));
+  }
+}
+
+void stroker::end_polygon() {
+  double twice_area = 0;
+  for (std::size_t i = 0; i < polygon_.size(); i++) {
+    const pointf& p = polygon_[i];
+    const pointf& q = polygon_[(i + 1) % polygon_.size()];
+    twice_area += static_cast<double>(p.x()) * q.y() - static_cast<double>(q.x()) * p.y();
+  }
+
+  // empty polygons add nothing; the rest are turned to run clockwise
+  if (twice_area != 0) {
+    if (twice_area < 0) {
+      std::reverse(polygon_.begin(), polygon_.end());
+    }
+
+    std::size_t begin = out_.points.size();
+    out_.points.insert(out_.points.end(), polygon_.begin(), polygon_.end());
+    out_.points.push_back(polygon_.front());
+    out_.contours.push_back({ begin, out_.points.size(), true });
+  }
+  polygon_.clear();
+}
+
+}  // namespace
+
+
+bool operator==(const stroke_params& lhs, const stroke_params& rhs) {
+  return lhs.width == rhs.width
+    && lhs.start_cap == rhs.start_cap
+    && lhs.end_cap == rhs.end_cap
+    && lhs.dash_cap == rhs.dash_cap
+    && lhs.line_join == rhs.line_join
+    && lhs.miter_limit == rhs.miter_limit
+    && lhs.dashes == rhs.dashes
+    && lhs.dash_offset == rhs.dash_offset;
+}
+
+bool operator!=(const stroke_params& lhs, const stroke_params& rhs) {
+  return !(lhs == rhs);
+}
+
+
+flat_path stroke_segments(const segment_list& segments, const stroke_params& params, float tolerance) {
+  if (!(params.width > 0)) {
+    return {};
+  }
+
+  stroker s(params, tolerance);
+  flat_path flat = flatten(segments, tolerance);
+  for (const auto& contour : flat.contours) {
+    std::vector<pointf> points;
+    for (std::size_t i = contour.begin; i < contour.end; i++) {
+      push_point(points, flat.points[i]);
+    }
+    if (contour.closed && points.size() > 1 && points.back() == points.front()) {
+      points.pop_back();
+    }
+
+    s.add_figure(std::move(points), contour.closed);
+  }
+  return s.take();
+}
+
+
+
+stroke_hit_grid::stroke_hit_grid(const flat_path& pieces)
+  : pieces_(pieces) {
+  if (pieces.points.empty()) {
+    return;
+  }
+
+  left_ = right_ = pieces.points.front().x();
+  top_ = bottom_ = pieces.points.front().y();
+  for (const auto& pt : pieces.points) {
+    left_ = std::min(left_, static_cast<double>(pt.x()));
+    right_ = std::max(right_, static_cast<double>(pt.x()));
+    top_ = std::min(top_, static_cast<double>(pt.y()));
+    bottom_ = std::max(bottom_, static_cast<double>(pt.y()));
+  }
+
+  // about one cell per polygon, roughly square
+  double cell_count = static_cast<double>(std::min(pieces.contours.size(), max_cell_count));
+  double width = right_ - left_;
+  double height = bottom_ - top_;
+  double cols = width > 0 ? cell_count : 1;
+  if (width > 0 && height > 0) {
+    cols = std::sqrt(cell_count * width / height);
+  }
+  cols_ = static_cast<std::size_t>(std::clamp(cols, 1.0, cell_count));
+  rows_ = std::max<std::size_t>(1, static_cast<std::size_t>(cell_count) / cols_);
+  col_scale_ = width > 0 ? cols_ / width : 0;
+  row_scale_ = height > 0 ? rows_ / height : 0;
+
+  // count the polygons overlapping each cell, then fill them in at the resulting offsets; in each
+  // row, a polygon covers the cells its part within the row spans, so a long diagonal line only
+  // lists the cells along it, rather than all those its bounds cover
+  double row_margin = row_scale_ > 0 ? 1e-6 / row_scale_ : 0;  // against rounding at row boundaries
+  auto for_each_cell = [&](const flat_path::contour& contour, auto&& f) {
+    double t = pieces.points[contour.begin].y(), b = t;
+    for (std::size_t i = contour.begin; i < contour.end; i++) {
+      t = std::min(t, static_cast<double>(pieces.points[i].y()));
+      b = std::max(b, static_cast<double>(pieces.points[i].y()));
+    }
+
+    for (std::size_t row = row_of(t), last_row = row_of(b); row <= last_row; row++) {
+      double row_top = row > 0 ? top_ + row / row_scale_ - row_margin : -HUGE_VAL;
+      double row_bottom = row + 1 < rows_ ? top_ + (row + 1) / row_scale_ + row_margin : HUGE_VAL;
+
+      // the polygon is convex, so its extent within the row is that of its edges clipped to the row
+      double l = HUGE_VAL, r = -HUGE_VAL;
+      for (std::size_t i = contour.begin; i + 1 < contour.end; i++) {
+        const pointf& from = pieces.points[i];
+        const pointf& to = pieces.points[i + 1];
+        double y0 = std::min(from.y(), to.y());
+        double y1 = std::max(from.y(), to.y());
+        if (y1 < row_top || y0 > row_bottom) {
+          continue;
+        }
+
+        if (y0 == y1) {
+          l = std::min({ l, static_cast<double>(from.x()), static_cast<double>(to.x()) });
+          r = std::max({ r, static_cast<double>(from.x()), static_cast<double>(to.x()) });
+          continue;
+        }
+
+        double dxdy = (static_cast<double>(to.x()) - from.x()) / (static_cast<double>(to.y()) - from.y());
+        for (double y : { std::max(y0, row_top), std::min(y1, row_bottom) }) {
+          double x = from.x() + (y - from.y()) * dxdy;
+          l = std::min(l, x);
+          r = std::max(r, x);
+        }
+      }
+
+      if (l <= r) {
+        for (std::size_t col = col_of(l), last_col = col_of(r); col <= last_col; col++) {
+          f(row * cols_ + col);
+        }
+      }
+    }
+  };
+
+  cell_begin_.assign(rows_ * cols_ + 1, 0);
+  for (const auto& contour : pieces.contours) {
+    for_each_cell(contour, [&](std::size_t cell) {
+      cell_begin_[cell + 1]++;
+    });
+  }
+  for (std::size_t i = 0; i + 1 < cell_begin_.size(); i++) {
+    cell_begin_[i + 1] += cell_begin_[i];
+  }
+
+  cell_pieces_.resize(cell_begin_.back());
+  std::vector<std::size_t> fill(cell_begin_.begin(), cell_begin_.end() - 1);
+  for (std::size_t i = 0; i < pieces.contours.size(); i++) {
+    for_each_cell(pieces.contours[i], [&](std::size_t cell) {
+      cell_pieces_[fill[cell]++] = static_cast<std::uint32_t>(i);
+    });
+  }
+}
+
+bool stroke_hit_grid::contains(const pointf& pt) const {
+  double x = pt.x();
+  double y = pt.y();
+  if (cell_begin_.empty() || !(x >= left_ && x <= right_ && y >= top_ && y <= bottom_)) {
+    return false;
+  }
+
+  std::size_t cell = row_of(y) * cols_ + col_of(x);
+  for (std::size_t i = cell_begin_[cell]; i < cell_begin_[cell + 1]; i++) {
+    const auto& contour = pieces_.contours[cell_pieces_[i]];
+
+    // clockwise and convex, so the point is inside if it is to the right of every edge
+    bool inside = true;
+    for (std::size_t j = contour.begin; inside && j + 1 < contour.end; j++) {
+      const pointf& from = pieces_.points[j];
+      const pointf& to = pieces_.points[j + 1];
+      inside = (static_cast<double>(to.x()) - from.x()) * (y - from.y())
+        >= (static_cast<double>(to.y()) - from.y()) * (x - from.x());
+    }
+    if (inside) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// PRIVATE
+
+std::size_t stroke_hit_grid::col_of(double x) const {
+  auto col = static_cast<std::size_t>(std::max(0.0, (x - left_) * col_scale_));
+  return std::min(col, cols_ - 1);
+}
+
+std::size_t stroke_hit_grid::row_of(double y) const {
+  auto row = static_cast<std::size_t>(std::max(0.0, (y - top_) * row_scale_));
+  return std::min(row, rows_ - 1);
+}
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/geom/point.h"
+#include "ui/gfx/stroke_types.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx::impl {
+
+// The parts of a stroke_style (plus the width) that shape a stroke. As in Direct2D, the dash
+// pattern and offset are in units of the stroke width.
+struct stroke_params {
+  float width = 1;
+
+  stroke_cap_style start_cap = stroke_cap_style::flat;
+  stroke_cap_style end_cap = stroke_cap_style::flat;
+  stroke_cap_style dash_cap = stroke_cap_style::flat;
+
+  stroke_line_join line_join = stroke_line_join::miter;
+  float miter_limit = 10;
+
+  std::vector<float> dashes;  // empty for a solid stroke
+  float dash_offset = 0;
+};
+
+bool operator==(const stroke_params& lhs, const stroke_params& rhs);
+bool operator!=(const stroke_params& lhs, const stroke_params& rhs);
+
+
+// Returns the area covered by stroking `segments` as closed polygons which overlap each other,
+// to be filled with fill_mode::winding: one per flattened line, join and cap. All of them run
+// clockwise (as seen with y pointing down), so overlaps add up instead of cancelling out.
+flat_path stroke_segments(const segment_list& segments, const stroke_params& params, float tolerance);
+
+
+// Hit-testing for the polygons made by stroke_segments, which are all convex. A uniform grid
+// over their bounds lists the polygons overlapping each cell, so a query only tests the few
+// polygons in its cell, however long the stroke.
+class stroke_hit_grid {
+public:
+  explicit stroke_hit_grid(const flat_path& pieces);  // must outlive the grid
+
+  // whether `pt` is in any of the polygons, including their edges
+  bool contains(const pointf& pt) const;
+
+private:
+  std::size_t col_of(double x) const;
+  std::size_t row_of(double y) const;
+
+  const flat_path& pieces_;
+
+  double left_ = 0, top_ = 0, right_ = 0, bottom_ = 0;
+  double col_scale_ = 0;  // columns per unit of x
+  double row_scale_ = 0;
+  std::size_t cols_ = 0;
+  std::size_t rows_ = 0;
+
+  std::vector<std::size_t> cell_begin_;  // cell i lists cell_pieces_[cell_begin_[i], cell_begin_[i + 1])
+  std::vector<std::uint32_t> cell_pieces_;  // indices into pieces_.contours
+};
+
+}  // namespace gfx::impl
\ No newline at end of file
@@ -7,13 +7,37 @@
 #include "base/win/last_error.h"
 #include "ui/gfx/d2d/convs.h"
 #include "ui/gfx/d2d/factories.h"
+#include "ui/gfx/geom/impl/path_cache.h"
+#include "ui/gfx/geom/impl/path_clipper.h"
 #include "ui/gfx/transform.h"
 #include "ui/gfx/util.h"
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 namespace gfx {
 namespace {
 
+static_assert(static_cast<int>(fill_mode::winding) == D2D1_FILL_MODE_WINDING);
+static_assert(static_cast<int>(fill_mode::even_odd) == D2D1_FILL_MODE_ALTERNATE);
+
+static_assert(static_cast<int>(path_op::combine) == D2D1_COMBINE_MODE_UNION);
+static_assert(static_cast<int>(path_op::intersect) == D2D1_COMBINE_MODE_INTERSECT);
+static_assert(static_cast<int>(path_op::diff) == D2D1_COMBINE_MODE_EXCLUDE);
+static_assert(static_cast<int>(path_op::symmetric_diff) == D2D1_COMBINE_MODE_XOR);
+
+static_assert(static_cast<int>(path_relation::disjoint) == D2D1_GEOMETRY_RELATION_DISJOINT);
+static_assert(static_cast<int>(path_relation::contained) == D2D1_GEOMETRY_RELATION_IS_CONTAINED);
+static_assert(static_cast<int>(path_relation::contains) == D2D1_GEOMETRY_RELATION_CONTAINS);
+static_assert(static_cast<int>(path_relation::overlap) == D2D1_GEOMETRY_RELATION_OVERLAP);
+
+static_assert(static_cast<int>(arc_size::small_arc) == D2D1_ARC_SIZE_SMALL);
+static_assert(static_cast<int>(arc_size::large_arc) == D2D1_ARC_SIZE_LARGE);
+
+static_assert(static_cast<int>(sweep_dir::counter_clockwise) == D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE);
+static_assert(static_cast<int>(sweep_dir::clockwise) == D2D1_SWEEP_DIRECTION_CLOCKWISE);
+
+
 auto create_path_geom() {
   impl::d2d_path_geom_ptr geom;
 
@@ -168,38 +192,69 @@ path_d2d_sink::path_d2d_sink(path* p)
   : path_(p) {
 }
 
-}  // namespace
-
 
-path_verb& path::operator[](std::size_t idx) {
-  ASSERT(idx < size()) << "Out of bounds access";
-  return verbs()[idx];
+path path_from_flat(const impl::flat_path& flat) {
+  path ret;
+  for (const auto& contour : flat.contours) {
+    ret.move_to(flat.points[contour.begin]);
+    // the last point of a closed contour repeats the first one
+    for (std::size_t i = contour.begin + 1; i + 1 < contour.end; i++) {
+      ret.line_to(flat.points[i]);
+    }
+    ret.close();
+  }
+  return ret;
 }
 
-const path_verb& path::operator[](std::size_t idx) const {
-  ASSERT(idx < size()) << "Out of bounds access";
-  return verbs()[idx];
+impl::stroke_params make_stroke_params(float stroke_width, const stroke_style& stroke) {
+  // the transform type doesn't matter, as paths are widened and hit-tested untransformed
+  impl::stroke_params ret;
+  ret.width = stroke_width;
+  ret.start_cap = stroke.start_cap();
+  ret.end_cap = stroke.end_cap();
+  ret.dash_cap = stroke.dash_cap();
+  ret.line_join = stroke.line_join();
+  ret.miter_limit = stroke.miter_limit();
+  ret.dashes.assign(stroke.dash_pattern().begin(), stroke.dash_pattern().end());
+  ret.dash_offset = stroke.dash_offset();
+  return ret;
 }
 
+}  // namespace
+
 
-path_verb& path::front() {
+path_verb path::front() const {
   ASSERT(!empty()) << "Accessing nonexistent path verb";
-  return verbs().front();
+  return *begin();
 }
 
-const path_verb& path::front() const {
+path_verb path::back() const {
   ASSERT(!empty()) << "Accessing nonexistent path verb";
-  return verbs().front();
+  return *std::prev(end());
 }
 
-path_verb& path::back() {
-  ASSERT(!empty()) << "Accessing nonexistent path verb";
-  return verbs().back();
+
+void path::push_back(const path_verb& verb) {
+  mark_dirty();
+  verbs_.push_back(verb);
 }
 
-const path_verb& path::back() const {
-  ASSERT(!empty()) << "Accessing nonexistent path verb";
-  return verbs().back();
+path::const_iterator path::insert(const_iterator where, const path_verb& verb) {
+  return insert(where, &verb, &verb + 1);
+}
+
+path::const_iterator path::erase(const_iterator where) {
+  return erase(where, std::next(where));
+}
+
+path::const_iterator path::erase(const_iterator first, const_iterator last) {
+  mark_dirty();
+  return verbs_.erase(first, last);
+}
+
+void path::clear() {
+  mark_dirty();
+  verbs_.clear();
 }
 
 
@@ -207,9 +262,10 @@ void path::swap(path& other) noexcept {
   using std::swap;
 
   // no lock - safety is only guaranteed on const operations
-  swap(verbs_, other.verbs_);
+  verbs_.swap(other.verbs_);
   swap(fill_mode_, other.fill_mode_);
   swap(d2d_geom_, other.d2d_geom_);
+  swap(cache_, other.cache_);
 }
 
 
@@ -222,27 +278,33 @@ void path::set_fill_mode(fill_mode mode) {
 
 
 void path::move_to(const pointf& to) {
-  push_back(path_verbs::move{ to });
+  mark_dirty();
+  verbs_.move_to(to);
 }
 
 void path::close() {
-  push_back(path_verbs::close{});
+  mark_dirty();
+  verbs_.close();
 }
 
 void path::line_to(const pointf& to) {
-  push_back(path_verbs::line{ to });
+  mark_dirty();
+  verbs_.line_to(to);
 }
 
 void path::quad_to(const pointf& ctrl, const pointf& end) {
-  push_back(path_verbs::quad{ ctrl, end });
+  mark_dirty();
+  verbs_.quad_to(ctrl, end);
 }
 
 void path::cubic_to(const pointf& ctrl1, const pointf& ctrl2, const pointf& end) {
-  push_back(path_verbs::cubic{ ctrl1, ctrl2, end });
+  mark_dirty();
+  verbs_.cubic_to(ctrl1, ctrl2, end);
 }
 
 void path::arc_to(const pointf& end, const sizef& radius, float rotation_angle, arc_size size, sweep_dir dir) {
-  push_back(path_verbs::arc{ end, radius, rotation_angle, size, dir });
+  mark_dirty();
+  verbs_.arc_to(end, { radius, rotation_angle, size, dir });
 }
 
 void path::arc_to(const pointf& end, float radius, arc_size size, sweep_dir dir) {
@@ -294,12 +356,18 @@ void path::add_path(const path& other) {
     return;
   }
 
+  if (&other == this) {
+    add_path(path(other));  // the verbs can't be inserted from where they are inserted
+    return;
+  }
+
   // make sure that we don't keep extending some other contour
-  if (!std::holds_alternative<path_verbs::move>(other.front())) {
+  if (other.begin().kind() != verb_kind::move) {
     move_to({ 0, 0 });
   }
 
-  insert(end(), other.verbs().begin(), other.verbs().end());
+  mark_dirty();
+  verbs_.insert(end(), other.view());
 }
 
 void path::add_rect(const rectf& rc) {
@@ -362,80 +430,43 @@ path path::outline() const {
 
 path path::transform(const mat33f& tform) const {
   path ret;
-  base::win::throw_if_failed(
-    d2d_geom()->Simplify(
-      D2D1_GEOMETRY_SIMPLIFICATION_OPTION_CUBICS_AND_LINES,
-      impl::mat33_to_d2d_mat32(tform),
-      ret.d2d_sink().get()
-    ),
-    "Failed to transform path"
-  );
+  ret.fill_mode_ = fill_mode_;
+  ret.verbs_ = verbs_.transformed(tform);
   return ret;
 }
 
-path path::combine(const path& other, path_op op) const {
-  path ret;
-  base::win::throw_if_failed(
-    d2d_geom()->CombineWithGeometry(
-      other.d2d_geom().get(),
-      static_cast<D2D1_COMBINE_MODE>(op),
-      nullptr,
-      ret.d2d_sink().get()
-    ),
-    "Failed to combine paths"
+path path::combine(const path& other, path_op op, float tolerance) const {
+  impl::flat_path clipped = impl::clip_paths(
+    impl::flatten(cache().segments(view()), tolerance), fill_mode_,
+    impl::flatten(other.cache().segments(other.view()), tolerance), other.fill_mode_,
+    op
   );
-  return ret;
+  return path_from_flat(clipped);
 }
 
 path path::widen(float stroke_width, const stroke_style& stroke) const {
-  path ret;
-  base::win::throw_if_failed(
-    d2d_geom()->Widen(
-      stroke_width,
-      stroke.d2d_stroke_style().get(),
-      nullptr,
-      ret.d2d_sink().get()
-    ),
-    "Failed to widen path"
-  );
+  // like Direct2D's, the result may overlap itself; outline() merges it into a single outline
+  auto stroked = cache().stroke(view(), make_stroke_params(stroke_width, stroke));
+  path ret = path_from_flat(stroked->pieces());
+  ret.set_fill_mode(fill_mode::winding);
   return ret;
 }
 
 
 float path::length() const {
-  float ret;
-  base::win::throw_if_failed(
-    d2d_geom()->ComputeLength(nullptr, &ret),
-    "Failed to compute path length"
-  );
-  return ret;
+  return cache().measure(view()).length();
 }
 
 float path::area() const {
-  float ret;
-  base::win::throw_if_failed(
-    d2d_geom()->ComputeArea(nullptr, &ret),
-    "Failed to compute path area"
-  );
-  return ret;
+  return static_cast<float>(cache().bands(view()).area(fill_mode_));
 }
 
 rectf path::bounds() const {
-  D2D1_RECT_F ret;
-  base::win::throw_if_failed(
-    d2d_geom()->GetBounds(nullptr, &ret),
-    "Failed to compute path bounds"
-  );
-  return impl::d2d_rect_to_rect(ret);
+  return impl::segment_bounds(cache().segments(view()));
 }
 
 std::pair<pointf, pointf> path::point_tangent_at(float dist) const {
-  D2D1_POINT_2F pt, tangent;
-  base::win::throw_if_failed(
-    d2d_geom()->ComputePointAtLength(dist, nullptr, &pt, &tangent),
-    "Failed to compute point information on path"
-  );
-  return { impl::d2d_point_to_point(pt), impl::d2d_point_to_point(tangent) };
+  return cache().measure(view()).point_tangent_at(dist);
 }
 
 
@@ -449,27 +480,11 @@ path_relation path::compare(const path& other) const {
 }
 
 bool path::contains(const pointf& pt) const {
-  BOOL ret;
-  base::win::throw_if_failed(
-    d2d_geom()->FillContainsPoint(impl::point_to_d2d_point(pt), nullptr, &ret),
-    "Failed to hit-test path"
-  );
-  return ret;
+  return cache().bands(view()).contains(pt, fill_mode_);
 }
 
 bool path::stroke_contains(const pointf& pt, float stroke_width, const stroke_style& stroke) const {
-  BOOL ret;
-  base::win::throw_if_failed(
-    d2d_geom()->StrokeContainsPoint(
-      impl::point_to_d2d_point(pt),
-      stroke_width,
-      stroke.d2d_stroke_style().get(),
-      nullptr,
-      &ret
-    ),
-    "Failed to hit-test path stroke"
-  );
-  return ret;
+  return cache().stroke(view(), make_stroke_params(stroke_width, stroke))->contains(pt);
 }
 
 
@@ -490,121 +505,109 @@ impl::d2d_geom_sink_ptr path::d2d_sink() {
 
 void path::mark_dirty() {
   d2d_geom_ = nullptr;
+  cache_ = nullptr;
 }
 
 void path::make_thread_safe() const {
   d2d_geom();  // force creation of cached Direct2D geometry
+  cache();  // the cache itself synchronizes computation of its contents
 }
 
 
 void path::stream_to(ID2D1GeometrySink* sink) const {
-  struct streaming_visitor {
-    streaming_visitor(ID2D1GeometrySink* sink)
-      : sink(sink) {
-    }
+  sink->SetFillMode(static_cast<D2D1_FILL_MODE>(fill_mode_));
 
-    void ensure_in_figure() {
-      if (!in_figure) {
-        (*this)(path_verbs::move{ last_move_to });
-      }
+  bool in_figure = false;
+  pointf last_move_to;
+
+  auto begin_figure = [&](const pointf& start) {
+    if (in_figure) {
+      sink->EndFigure(D2D1_FIGURE_END_OPEN);
     }
 
-    void operator()(const path_verbs::move& move) {
-      if (in_figure) {
-        sink->EndFigure(D2D1_FIGURE_END_OPEN);
-      }
+    sink->BeginFigure(impl::point_to_d2d_point(start), D2D1_FIGURE_BEGIN_FILLED);
+
+    last_move_to = start;
+    in_figure = true;
+  };
 
-      sink->BeginFigure(impl::point_to_d2d_point(move.to), D2D1_FIGURE_BEGIN_FILLED);
+  for (auto it = begin(); it != end(); ++it) {
+    const pointf* pts = it.points();
 
-      last_move_to = move.to;
-      in_figure = true;
+    if (it.kind() == verb_kind::move) {
+      begin_figure(pts[0]);
+      continue;
     }
 
-    void operator()(const path_verbs::close&) {
-      if (!in_figure) {
-        return;
+    if (it.kind() == verb_kind::close) {
+      if (in_figure) {
+        sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+        in_figure = false;
       }
-
-      sink->EndFigure(D2D1_FIGURE_END_CLOSED);
-
-      in_figure = false;
+      continue;
     }
 
-    void operator()(const path_verbs::line& line) {
-      ensure_in_figure();
-      sink->AddLine(impl::point_to_d2d_point(line.to));
+    if (!in_figure) {
+      begin_figure(last_move_to);
     }
 
-    void operator()(const path_verbs::quad& quad) {
-      ensure_in_figure();
+    switch (it.kind()) {
+    case verb_kind::line:
+      sink->AddLine(impl::point_to_d2d_point(pts[0]));
+      break;
+    case verb_kind::quad:
       sink->AddQuadraticBezier({
-        impl::point_to_d2d_point(quad.ctrl),
-        impl::point_to_d2d_point(quad.end)
+        impl::point_to_d2d_point(pts[0]),
+        impl::point_to_d2d_point(pts[1])
       });
-    }
-
-    void operator()(const path_verbs::cubic& cubic) {
-      ensure_in_figure();
+      break;
+    case verb_kind::cubic:
       sink->AddBezier({
-        impl::point_to_d2d_point(cubic.ctrl1),
-        impl::point_to_d2d_point(cubic.ctrl2),
-        impl::point_to_d2d_point(cubic.end)
+        impl::point_to_d2d_point(pts[0]),
+        impl::point_to_d2d_point(pts[1]),
+        impl::point_to_d2d_point(pts[2])
       });
-    }
-
-    void operator()(const path_verbs::arc& arc) {
-      ensure_in_figure();
+      break;
+    default:
       sink->AddArc({
-        impl::point_to_d2d_point(arc.end),
-        impl::size_to_d2d_size(arc.radius),
-        rad_to_deg(arc.rotation_angle),
-        static_cast<D2D1_SWEEP_DIRECTION>(arc.dir),
-        static_cast<D2D1_ARC_SIZE>(arc.size)
+        impl::point_to_d2d_point(pts[0]),
+        impl::size_to_d2d_size(it.arc().radius),
+        rad_to_deg(it.arc().rotation_angle),
+        static_cast<D2D1_SWEEP_DIRECTION>(it.arc().dir),
+        static_cast<D2D1_ARC_SIZE>(it.arc().size)
       });
+      break;
     }
-
-    void close() {
-      if (in_figure) {
-        sink->EndFigure(D2D1_FIGURE_END_OPEN);
-      }
-      base::win::throw_if_failed(sink->Close(), "Failed to stream path to sink");
-    }
-
-
-    ID2D1GeometrySink* sink;
-    bool in_figure = false;
-
-    pointf last_move_to;
-  };
-
-  sink->SetFillMode(static_cast<D2D1_FILL_MODE>(fill_mode_));
-
-  streaming_visitor visitor(sink);
-  for (const auto& verb : *this) {
-    std::visit(visitor, verb);
   }
 
-  visitor.close();
+  if (in_figure) {
+    sink->EndFigure(D2D1_FIGURE_END_OPEN);
+  }
+  base::win::throw_if_failed(sink->Close(), "Failed to stream path to sink");
 }
 
 
 // PRIVATE
 
-path::verb_list& path::verbs() {
-  // the path may be modified externally, so discard our current geometry
-  mark_dirty();
-  return verbs_;
-}
-
-const path::verb_list& path::verbs() const {
-  return verbs_;
+const impl::path_cache& path::cache() const {
+  if (!cache_) {
+    cache_ = std::make_shared<impl::path_cache>();
+  }
+  return *cache_;
 }
 
 
 // NONMEMBER
 
 bool operator==(const path& lhs, const path& rhs) {
-  return lhs.get_fill_mode() == rhs.get_fill_mode() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  auto equal = [](const auto& lhs, const auto& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  };
+
+  path_view l = lhs.view();
+  path_view r = rhs.view();
+  return lhs.get_fill_mode() == rhs.get_fill_mode() && equal(l.verbs(), r.verbs())
+    && equal(l.points(), r.points()) && equal(l.arcs(), r.arcs());
 }
 
 bool operator!=(const path& lhs, const path& rhs) {
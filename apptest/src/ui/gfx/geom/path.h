@@ -2,16 +2,19 @@
 
 #include "base/win/com_ptr.h"
 #include "ui/gfx/stroke_style.h"
+#include "ui/gfx/geom/impl/path_storage.h"
+#include "ui/gfx/geom/path_verbs.h"
+#include "ui/gfx/geom/path_view.h"
 #include "ui/gfx/geom/point.h"
 #include "ui/gfx/geom/rect.h"
 #include "ui/gfx/geom/round_rect.h"
 #include "ui/gfx/geom/size.h"
 #include "ui/gfx/matrix.h"
 #include <d2d1_1.h>
-#include <initializer_list>
+#include <cstddef>
+#include <iterator>
+#include <memory>
 #include <mutex>
-#include <variant>
-#include <vector>
 
 namespace gfx {
 namespace impl {
@@ -19,183 +22,55 @@ namespace impl {
 using d2d_path_geom_ptr = base::win::com_ptr<ID2D1PathGeometry1>;
 using d2d_geom_sink_ptr = base::win::com_ptr<ID2D1GeometrySink>;
 
-}  // namepsace impl
-
-
-enum class fill_mode {
-  winding = D2D1_FILL_MODE_WINDING,
-  even_odd = D2D1_FILL_MODE_ALTERNATE
-};
-
-
-enum class path_op {
-  combine = D2D1_COMBINE_MODE_UNION,
-  intersect = D2D1_COMBINE_MODE_INTERSECT,
-  diff = D2D1_COMBINE_MODE_EXCLUDE,
-  symmetric_diff = D2D1_COMBINE_MODE_XOR
-};
-
-enum class path_relation {
-  disjoint = D2D1_GEOMETRY_RELATION_DISJOINT,
-  contained = D2D1_GEOMETRY_RELATION_IS_CONTAINED,
-  contains = D2D1_GEOMETRY_RELATION_CONTAINS,
-  overlap = D2D1_GEOMETRY_RELATION_OVERLAP
-};
-
-
-enum class arc_size {
-  large_arc = D2D1_ARC_SIZE_LARGE,
-  small_arc = D2D1_ARC_SIZE_SMALL
-};
-
-enum class sweep_dir {
-  clockwise = D2D1_SWEEP_DIRECTION_CLOCKWISE,
-  counter_clockwise = D2D1_SWEEP_DIRECTION_COUNTER_CLOCKWISE
-};
-
-
-namespace path_verbs {
-
-struct move {
-  pointf to;
-};
-
-constexpr bool operator==(const move& lhs, const move& rhs) {
-  return lhs.to == rhs.to;
-}
-
-constexpr bool operator!=(const move& lhs, const move& rhs) {
-  return !(lhs == rhs);
-}
-
-
-struct close {};
-
-constexpr bool operator==(const close&, const close&) {
-  return true;
-}
-
-constexpr bool operator!=(const close&, const close&) {
-  return false;
-}
-
-
-struct line {
-  pointf to;
-};
-
-constexpr bool operator==(const line& lhs, const line& rhs) {
-  return lhs.to == rhs.to;
-}
-
-constexpr bool operator!=(const line& lhs, const line& rhs) {
-  return !(lhs == rhs);
-}
-
-
-struct quad {
-  pointf ctrl;
-  pointf end;
-};
-
-constexpr bool operator==(const quad& lhs, const quad& rhs) {
-  return lhs.ctrl == rhs.ctrl && lhs.end == rhs.end;
-}
-
-constexpr bool operator!=(const quad& lhs, const quad& rhs) {
-  return !(lhs == rhs);
-}
-
-
-struct cubic {
-  pointf ctrl1;
-  pointf ctrl2;
-  pointf end;
-};
+class path_cache;
 
-constexpr bool operator==(const cubic& lhs, const cubic& rhs) {
-  return lhs.ctrl1 == rhs.ctrl1 && lhs.ctrl2 == rhs.ctrl2 && lhs.end == rhs.end;
-}
-
-constexpr bool operator!=(const cubic& lhs, const cubic& rhs) {
-  return !(lhs == rhs);
-}
-
-
-struct arc {
-  pointf end;
-  sizef radius;
-  float rotation_angle;
-  arc_size size;
-  sweep_dir dir;
-};
-
-constexpr bool operator==(const arc& lhs, const arc& rhs) {
-  return lhs.end == rhs.end && lhs.radius == rhs.radius && lhs.rotation_angle == rhs.rotation_angle
-    && lhs.size == rhs.size && lhs.dir == rhs.dir;
-}
-
-constexpr bool operator!=(const arc& lhs, const arc& rhs) {
-  return !(lhs == rhs);
-}
-
-}  // namespace path_verbs
+}  // namepsace impl
 
-using path_verb = std::variant<
-  path_verbs::move,
-  path_verbs::close,
-  path_verbs::line,
-  path_verbs::quad,
-  path_verbs::cubic,
-  path_verbs::arc
->;
 
 class path {
 public:
-  using verb_list = std::vector<path_verb>;
+  // verbs are read through a path_view; editing goes through the members below
+  using const_iterator = path_view::iterator;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-  using iterator = verb_list::iterator;
-  using const_iterator = verb_list::const_iterator;
-  using reverse_iterator = verb_list::reverse_iterator;
-  using const_reverse_iterator = verb_list::const_reverse_iterator;
+  path_view view() const { return verbs_.view(); }
 
-  iterator begin() { return verbs().begin(); }
-  const_iterator begin() const { return verbs().begin(); }
-  const_iterator cbegin() const { return verbs().cbegin(); }
+  const_iterator begin() const { return view().begin(); }
+  const_iterator cbegin() const { return begin(); }
 
-  iterator end() { return verbs().end(); }
-  const_iterator end() const { return verbs().end(); }
-  const_iterator cend() const { return verbs().cend(); }
+  const_iterator end() const { return view().end(); }
+  const_iterator cend() const { return end(); }
 
-  reverse_iterator rbegin() { return verbs().rbegin(); }
-  const_reverse_iterator rbegin() const { return verbs().rbegin(); }
-  const_reverse_iterator crbegin() const { return verbs().crbegin(); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const { return rbegin(); }
 
-  reverse_iterator rend() { return verbs().rend(); }
-  const_reverse_iterator rend() const { return verbs().rend(); }
-  const_reverse_iterator crend() const { return verbs().crend(); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const { return rend(); }
 
-  bool empty() const { return verbs().empty(); }
-  std::size_t size() const { return verbs().size(); }
+  bool empty() const { return verbs_.empty(); }
+  std::size_t size() const { return verbs_.size(); }
 
-  path_verb& operator[](std::size_t idx);
-  const path_verb& operator[](std::size_t idx) const;
+  path_verb front() const;
+  path_verb back() const;
 
-  path_verb& front();
-  const path_verb& front() const;
-
-  path_verb& back();
-  const path_verb& back() const;
-
-  void push_back(path_verb verb) { verbs().push_back(std::move(verb)); }
+  void push_back(const path_verb& verb);
 
   template<typename Iter>
-  iterator insert(const_iterator where, Iter first, Iter last) { return verbs().insert(where, first, last); }
-  iterator insert(const_iterator where, path_verb verb) { return verbs().insert(where, std::move(verb)); }
-
-  iterator erase(const_iterator where) { return verbs().erase(where); }
-  iterator erase(const_iterator first, const_iterator last) { return verbs().erase(first, last); }
-  void clear() { verbs().clear(); }
+  const_iterator insert(const_iterator where, Iter first, Iter last) {
+    // gathered separately first, as the range may come from this path
+    impl::path_storage verbs;
+    for (; first != last; ++first) {
+      verbs.push_back(*first);
+    }
+
+    mark_dirty();
+    return verbs_.insert(where, verbs.view());
+  }
+  const_iterator insert(const_iterator where, const path_verb& verb);
+
+  const_iterator erase(const_iterator where);
+  const_iterator erase(const_iterator first, const_iterator last);
+  void clear();
 
   void swap(path& other) noexcept;
 
@@ -228,7 +103,7 @@ public:
 
   path outline() const;
   path transform(const mat33f& tform) const;
-  path combine(const path& other, path_op op) const;
+  path combine(const path& other, path_op op, float tolerance = default_flattening_tolerance) const;
   path widen(float stroke_width, const stroke_style& stroke = {}) const;
 
   float length() const;
@@ -250,13 +125,13 @@ public:
   void stream_to(ID2D1GeometrySink* sink) const;
 
 private:
-  verb_list& verbs();
-  const verb_list& verbs() const;
+  const impl::path_cache& cache() const;
 
-  verb_list verbs_;
+  impl::path_storage verbs_;
   fill_mode fill_mode_ = fill_mode::winding;
 
   mutable impl::d2d_path_geom_ptr d2d_geom_;
+  mutable std::shared_ptr<impl::path_cache> cache_;
 };
 
 
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "ui/gfx/geom/point.h"
+#include "ui/gfx/geom/size.h"
+#include <variant>
+
+// The building blocks of gfx::path, kept free of any Direct2D dependency so that the native path
+// geometry code can be used on every platform. The enum values match the corresponding Direct2D
+// ones, which path.cpp relies on.
+
+namespace gfx {
+
+// the largest distance allowed between a curve and the lines approximating it, in DIPs; this is
+// Direct2D's default
+constexpr float default_flattening_tolerance = 0.25f;
+
+
+enum class fill_mode {
+  winding = 1,
+  even_odd = 0
+};
+
+
+enum class path_op {
+  combine = 0,
+  intersect = 1,
+  diff = 3,
+  symmetric_diff = 2
+};
+
+enum class path_relation {
+  disjoint = 1,
+  contained = 2,
+  contains = 3,
+  overlap = 4
+};
+
+
+enum class arc_size {
+  large_arc = 1,
+  small_arc = 0
+};
+
+enum class sweep_dir {
+  clockwise = 1,
+  counter_clockwise = 0
+};
+
+
+namespace path_verbs {
+
+struct move {
+  pointf to;
+};
+
+constexpr bool operator==(const move& lhs, const move& rhs) {
+  return lhs.to == rhs.to;
+}
+
+constexpr bool operator!=(const move& lhs, const move& rhs) {
+  return !(lhs == rhs);
+}
+
+
+struct close {};
+
+constexpr bool operator==(const close&, const close&) {
+  return true;
+}
+
+constexpr bool operator!=(const close&, const close&) {
+  return false;
+}
+
+
+struct line {
+  pointf to;
+};
+
+constexpr bool operator==(const line& lhs, const line& rhs) {
+  return lhs.to == rhs.to;
+}
+
+constexpr bool operator!=(const line& lhs, const line& rhs) {
+  return !(lhs == rhs);
+}
+
+
+struct quad {
+  pointf ctrl;
+  pointf end;
+};
+
+constexpr bool operator==(const quad& lhs, const quad& rhs) {
+  return lhs.ctrl == rhs.ctrl && lhs.end == rhs.end;
+}
+
+constexpr bool operator!=(const quad& lhs, const quad& rhs) {
+  return !(lhs == rhs);
+}
+
+
+struct cubic {
+  pointf ctrl1;
+  pointf ctrl2;
+  pointf end;
+};
+
+constexpr bool operator==(const cubic& lhs, const cubic& rhs) {
+  return lhs.ctrl1 == rhs.ctrl1 && lhs.ctrl2 == rhs.ctrl2 && lhs.end == rhs.end;
+}
+
+constexpr bool operator!=(const cubic& lhs, const cubic& rhs) {
+  return !(lhs == rhs);
+}
+
+
+struct arc {
+  pointf end;
+  sizef radius;
+  float rotation_angle;
+  arc_size size;
+  sweep_dir dir;
+};
+
+constexpr bool operator==(const arc& lhs, const arc& rhs) {
+  return lhs.end == rhs.end && lhs.radius == rhs.radius && lhs.rotation_angle == rhs.rotation_angle
+    && lhs.size == rhs.size && lhs.dir == rhs.dir;
+}
+
+constexpr bool operator!=(const arc& lhs, const arc& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace path_verbs
+
+using path_verb = std::variant<
+  path_verbs::move,
+  path_verbs::close,
+  path_verbs::line,
+  path_verbs::quad,
+  path_verbs::cubic,
+  path_verbs::arc
+>;
+
+}  // namespace gfx
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "base/span.h"
+#include "ui/gfx/geom/path_verbs.h"
+#include "ui/gfx/geom/point.h"
+#include "ui/gfx/geom/size.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace gfx {
+namespace impl {
+
+class path_storage;
+
+}  // namespace impl
+
+
+enum class verb_kind : std::uint8_t {
+  move,
+  close,
+  line,
+  quad,
+  cubic,
+  arc
+};
+
+// the number of points a verb keeps in the point array; for curves, the control points come first
+constexpr std::size_t point_count(verb_kind kind) {
+  switch (kind) {
+  case verb_kind::move:
+  case verb_kind::line:
+  case verb_kind::arc:
+    return 1;
+  case verb_kind::quad:
+    return 2;
+  case verb_kind::cubic:
+    return 3;
+  default:
+    return 0;
+  }
+}
+
+
+// what an arc verb keeps besides its end point
+struct arc_params {
+  sizef radius;
+  float rotation_angle;
+  arc_size size;
+  sweep_dir dir;
+};
+
+constexpr bool operator==(const arc_params& lhs, const arc_params& rhs) {
+  return lhs.radius == rhs.radius && lhs.rotation_angle == rhs.rotation_angle
+    && lhs.size == rhs.size && lhs.dir == rhs.dir;
+}
+
+constexpr bool operator!=(const arc_params& lhs, const arc_params& rhs) {
+  return !(lhs == rhs);
+}
+
+
+// A read-only view of the verbs of a path, in the compact form the path stores them in (as in
+// Skia's SkPath): one byte per verb, the points of all verbs packed in order, and the remaining
+// parameters of each arc alongside.
+//
+// Iterating yields each verb as a path_verb. Code walking many verbs can switch on kind() and
+// read points() directly instead.
+class path_view {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = path_verb;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = path_verb;  // built on the fly
+
+    iterator() = default;
+
+    verb_kind kind() const { return *verb_; }
+    const pointf* points() const { return point_; }  // point_count(kind()) of them
+    const arc_params& arc() const { return *arc_; }  // only for arcs
+
+    path_verb operator*() const {
+      switch (kind()) {
+      case verb_kind::move:
+        return path_verbs::move{ point_[0] };
+      case verb_kind::close:
+        return path_verbs::close{};
+      case verb_kind::line:
+        return path_verbs::line{ point_[0] };
+      case verb_kind::quad:
+        return path_verbs::quad{ point_[0], point_[1] };
+      case verb_kind::cubic:
+        return path_verbs::cubic{ point_[0], point_[1], point_[2] };
+      default:
+        return path_verbs::arc{ point_[0], arc_->radius, arc_->rotation_angle, arc_->size, arc_->dir };
+      }
+    }
+
+    iterator& operator++() {
+      point_ += point_count(*verb_);
+      arc_ += *verb_ == verb_kind::arc;
+      ++verb_;
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    iterator& operator--() {
+      --verb_;
+      point_ -= point_count(*verb_);
+      arc_ -= *verb_ == verb_kind::arc;
+      return *this;
+    }
+
+    iterator operator--(int) {
+      iterator ret = *this;
+      --*this;
+      return ret;
+    }
+
+    friend bool operator==(const iterator& lhs, const iterator& rhs) {
+      return lhs.verb_ == rhs.verb_;
+    }
+
+    friend bool operator!=(const iterator& lhs, const iterator& rhs) {
+      return !(lhs == rhs);
+    }
+
+  private:
+    friend class path_view;
+    friend class impl::path_storage;
+
+    iterator(const verb_kind* verb, const pointf* point, const arc_params* arc)
+      : verb_(verb), point_(point), arc_(arc) {
+    }
+
+    const verb_kind* verb_ = nullptr;
+    const pointf* point_ = nullptr;
+    const arc_params* arc_ = nullptr;
+  };
+
+
+  path_view() = default;
+  path_view(base::span<const verb_kind> verbs, base::span<const pointf> points,
+    base::span<const arc_params> arcs)
+    : verbs_(verbs), points_(points), arcs_(arcs) {
+  }
+
+  iterator begin() const { return { verbs_.data(), points_.data(), arcs_.data() }; }
+  iterator end() const { return { verbs_.end(), points_.end(), arcs_.end() }; }
+
+  bool empty() const { return verbs_.empty(); }
+  std::size_t size() const { return static_cast<std::size_t>(verbs_.size()); }
+
+  base::span<const verb_kind> verbs() const { return verbs_; }
+  base::span<const pointf> points() const { return points_; }
+  base::span<const arc_params> arcs() const { return arcs_; }
+
+private:
+  base::span<const verb_kind> verbs_;
+  base::span<const pointf> points_;
+  base::span<const arc_params> arcs_;
+};
+
+}  // namespace gfx
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <type_traits>
+
 namespace gfx {
 
 template<typename T>
@@ -35,6 +35,32 @@ void resource_cache::purge_invalid() {
 
 // PRIVATE
 
+cached_resource* resource_cache::do_find_or_create(const resource_key& key, factory_ref factory) {
+  // Use double-checked locking - safe here as exclusive locks always exclude shared ones.
+
+  {
+    std::shared_lock hold_key(key.lock_);
+    if (cached_resource* res = find(key)) {
+      return res;
+    }
+  }
+
+  {
+    std::scoped_lock hold_key(key.lock_);
+
+    if (cached_resource* res = find(key)) {
+      return res;
+    }
+
+    auto res_holder = factory();
+    auto* res = res_holder.get();
+
+    add(key, std::move(res_holder));
+    return res;
+  }
+}
+
+
 void resource_cache::add(const resource_key& key, std::unique_ptr<cached_resource> res) {
   std::scoped_lock hold(entry_lock_);
   ASSERT(entries_.find(&key) == entries_.end()) << "Adding key twice";
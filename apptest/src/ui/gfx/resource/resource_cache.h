@@ -1,5 +1,6 @@
 #pragma once
 
+#include "base/function.h"
 #include "ui/gfx/resource/cached_resource.h"
 #include "ui/gfx/resource/resource_key.h"
 #include <memory>
@@ -29,6 +30,9 @@ private:
   using entry_map = std::unordered_map<const resource_key*, std::unique_ptr<cached_resource>>;
   using entry_iter = entry_map::iterator;
 
+  using factory_ref = base::function_ref<std::unique_ptr<cached_resource>()>;
+
+  cached_resource* do_find_or_create(const resource_key& key, factory_ref factory);
   void add(const resource_key& key, std::unique_ptr<cached_resource> res);
   cached_resource* find(const resource_key& key);
   
@@ -48,29 +52,7 @@ private:
 template<typename F>
 auto resource_cache::find_or_create(const resource_key& key, F&& factory) {
   using res_type = typename std::invoke_result_t<F>::element_type;
-  
-  // Use double-checked locking - safe here as exclusive locks always exclude shared ones.
-
-  {
-    std::shared_lock hold_key(key.lock_);
-    if (cached_resource* res = find(key)) {
-      return static_cast<res_type*>(res);
-    }
-  }
-
-  {
-    std::scoped_lock hold_key(key.lock_);
-
-    if (cached_resource* res = find(key)) {
-      return static_cast<res_type*>(res);
-    }
-
-    auto res_holder = std::forward<F>(factory)();
-    auto* res = res_holder.get();
-
-    add(key, std::move(res_holder));
-    return res;
-  }
+  return static_cast<res_type*>(do_find_or_create(key, factory));
 }
 
 }  // namespace gfx
\ No newline at end of file
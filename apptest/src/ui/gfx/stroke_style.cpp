@@ -6,6 +6,21 @@
 namespace gfx {
 namespace {
 
+static_assert(static_cast<int>(stroke_cap_style::flat) == D2D1_CAP_STYLE_FLAT);
+static_assert(static_cast<int>(stroke_cap_style::square) == D2D1_CAP_STYLE_SQUARE);
+static_assert(static_cast<int>(stroke_cap_style::round) == D2D1_CAP_STYLE_ROUND);
+static_assert(static_cast<int>(stroke_cap_style::tri) == D2D1_CAP_STYLE_TRIANGLE);
+
+static_assert(static_cast<int>(stroke_line_join::miter) == D2D1_LINE_JOIN_MITER);
+static_assert(static_cast<int>(stroke_line_join::bevel) == D2D1_LINE_JOIN_BEVEL);
+static_assert(static_cast<int>(stroke_line_join::round) == D2D1_LINE_JOIN_ROUND);
+static_assert(static_cast<int>(stroke_line_join::limited_miter) == D2D1_LINE_JOIN_MITER_OR_BEVEL);
+
+static_assert(static_cast<int>(stroke_transform_type::normal) == D2D1_STROKE_TRANSFORM_TYPE_NORMAL);
+static_assert(static_cast<int>(stroke_transform_type::fixed) == D2D1_STROKE_TRANSFORM_TYPE_FIXED);
+static_assert(static_cast<int>(stroke_transform_type::hairline) == D2D1_STROKE_TRANSFORM_TYPE_HAIRLINE);
+
+
 auto create_d2d_stroke_style(const D2D1_STROKE_STYLE_PROPERTIES1& props, base::span<const float> dashes) {
   impl::d2d_stroke_style_ptr stroke_style;
   base::win::throw_if_failed(
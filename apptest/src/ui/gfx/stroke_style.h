@@ -2,6 +2,7 @@
 
 #include "base/span.h"
 #include "base/win/com_ptr.h"
+#include "ui/gfx/stroke_types.h"
 #include <d2d1_1.h>
 #include <mutex>
 #include <vector>
@@ -14,27 +15,6 @@ using d2d_stroke_style_ptr = base::win::com_ptr<ID2D1StrokeStyle1>;
 }  // namespace impl
 
 
-enum class stroke_cap_style {
-  flat = D2D1_CAP_STYLE_FLAT,
-  square = D2D1_CAP_STYLE_SQUARE,
-  round = D2D1_CAP_STYLE_ROUND,
-  tri = D2D1_CAP_STYLE_TRIANGLE
-};
-
-enum class stroke_line_join {
-  miter = D2D1_LINE_JOIN_MITER,
-  bevel = D2D1_LINE_JOIN_BEVEL,
-  round = D2D1_LINE_JOIN_ROUND,
-  limited_miter = D2D1_LINE_JOIN_MITER_OR_BEVEL
-};
-
-enum class stroke_transform_type {
-  normal = D2D1_STROKE_TRANSFORM_TYPE_NORMAL,
-  fixed = D2D1_STROKE_TRANSFORM_TYPE_FIXED,
-  hairline = D2D1_STROKE_TRANSFORM_TYPE_HAIRLINE
-};
-
-
 class stroke_style {
 public:
   stroke_transform_type transform_type() const { return transform_type_; }
@@ -0,0 +1,29 @@
+#pragma once
+
+// The enums describing a stroke_style, kept free of any Direct2D dependency so that the native
+// stroker can be used on every platform. The values match the corresponding Direct2D ones, which
+// stroke_style.cpp relies on.
+
+namespace gfx {
+
+enum class stroke_cap_style {
+  flat = 0,
+  square = 1,
+  round = 2,
+  tri = 3
+};
+
+enum class stroke_line_join {
+  miter = 0,  // clipped at the miter limit
+  bevel = 1,
+  round = 2,
+  limited_miter = 3  // beveled beyond the miter limit
+};
+
+enum class stroke_transform_type {
+  normal = 0,
+  fixed = 1,
+  hairline = 2
+};
+
+}  // namespace gfx
\ No newline at end of file
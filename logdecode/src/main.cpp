@@ -0,0 +1,36 @@
+#include "base/logging/binary_log.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+// Decodes a log written by logging::binary_file_sink to stdout.
+int wmain(int argc, const wchar_t** argv) {
+  if (argc != 2) {
+    std::cerr << "usage: logdecode <log file>\n";
+    return 2;
+  }
+
+  std::ifstream file(std::filesystem::path(argv[1]), std::ios::binary);
+  if (!file) {
+    std::cerr << "failed to open " << std::filesystem::path(argv[1]).u8string() << "\n";
+    return 1;
+  }
+  std::string data(std::istreambuf_iterator<char>(file), {});
+
+  std::string line;
+  try {
+    logging::binary_log_reader reader(data);
+    while (reader.read_next(line)) {
+      std::cout << line;
+      line.clear();
+    }
+  } catch (const std::runtime_error& e) {
+    // a log cut short by a crash still decodes up to the last complete message
+    std::cerr << "error: " << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
\ No newline at end of file
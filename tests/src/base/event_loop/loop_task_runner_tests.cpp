@@ -0,0 +1,114 @@
+#include "test.h"
+#include "base/event_loop/test_event_loop.h"
+#include "base/event_loop/loop_task_runner.h"
+#include "base/thread/thread.h"
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace base;
+
+namespace {
+
+std::unique_ptr<thread> make_thread() {
+  return std::make_unique<thread>([] { return std::make_unique<test::test_event_loop>(); });
+}
+
+// Calls `post` from a task on a fresh loop, so that everything it posts is pending at once, and
+// returns the names the tasks logged in the order they ran. The tasks are done once an idle task
+// posted last gets to run.
+template<typename F>
+std::vector<std::string> run_order(F&& post) {
+  auto loop = make_thread();
+  std::vector<std::string> order;  // only touched on the loop thread
+  std::promise<void> done;
+
+  loop->task_runner()->post_task([&] {
+    post(order);
+    loop_task_runner::current()->post_task([&] { done.set_value(); }, task_priority::idle);
+  });
+
+  done.get_future().wait();
+  return order;
+}
+
+// a task which logs `name` when it runs
+auto logger(std::vector<std::string>& order, std::string name) {
+  return [&order, name] { order.push_back(name); };
+}
+
+std::vector<std::string> names(const char* prefix, int first, int last) {
+  std::vector<std::string> ret;
+  for (int i = first; i < last; i++) {
+    ret.push_back(prefix + std::to_string(i));
+  }
+  return ret;
+}
+
+std::vector<std::string> operator+(std::vector<std::string> lhs, const std::vector<std::string>& rhs) {
+  lhs.insert(lhs.end(), rhs.begin(), rhs.end());
+  return lhs;
+}
+
+}  // namespace
+
+
+TEST(loop_task_runner_high_priority_first) {
+  auto order = run_order([](std::vector<std::string>& order) {
+    auto runner = loop_task_runner::current();
+    for (int i = 0; i < 5; i++) {
+      runner->post_task(logger(order, "n" + std::to_string(i)));
+    }
+    for (int i = 0; i < 3; i++) {
+      runner->post_task(logger(order, "h" + std::to_string(i)), task_priority::high);
+    }
+  });
+
+  CHECK(order == names("h", 0, 3) + names("n", 0, 5));
+}
+
+TEST(loop_task_runner_high_priority_streak) {
+  // after 8 high priority tasks in a row, a normal one gets to run
+  auto order = run_order([](std::vector<std::string>& order) {
+    auto runner = loop_task_runner::current();
+    for (int i = 0; i < 4; i++) {
+      runner->post_task(logger(order, "n" + std::to_string(i)));
+    }
+    for (int i = 0; i < 20; i++) {
+      runner->post_task(logger(order, "h" + std::to_string(i)), task_priority::high);
+    }
+  });
+
+  CHECK(order == names("h", 0, 8) + names("n", 0, 1) + names("h", 8, 16) + names("n", 1, 2)
+    + names("h", 16, 20) + names("n", 2, 4));
+}
+
+TEST(loop_task_runner_idle_tasks) {
+  // idle tasks wait for everything else, including tasks posted by the tasks running before them
+  auto order = run_order([](std::vector<std::string>& order) {
+    auto runner = loop_task_runner::current();
+    runner->post_task([&order] {
+      order.push_back("i0");
+      loop_task_runner::current()->post_task(logger(order, "n5"));
+    }, task_priority::idle);
+    runner->post_task(logger(order, "i1"), task_priority::idle);
+
+    struct chain {
+      void operator()() const {
+        order->push_back("n" + std::to_string(index));
+        if (index < 4) {
+          loop_task_runner::current()->post_task(chain{ order, index + 1 });
+        }
+      }
+
+      std::vector<std::string>* order;
+      int index;
+    };
+    runner->post_task(chain{ &order, 0 });
+    runner->post_task(logger(order, "h0"), task_priority::high);
+  });
+
+  CHECK(order == names("h", 0, 1) + names("n", 0, 5) + names("i", 0, 1) + names("n", 5, 6)
+    + names("i", 1, 2));
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "test.h"
+#include "base/event_loop/test_event_loop.h"
+#include "base/event_loop/impl/task_queue.h"
+#include "base/thread/thread.h"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace base;
+using namespace base::impl;
+
+namespace {
+
+constexpr int producer_count = 4;
+
+// a node whose task records `value` into `out` when run
+task_node_ptr make_node(int value, std::vector<int>& out) {
+  return std::make_unique<task_node>(task([value, &out] { out.push_back(value); }, task::clock_type::now()));
+}
+
+void run_tasks(task_list list) {
+  while (!list.empty()) {
+    list.pop()->tsk.run();
+  }
+}
+
+std::unique_ptr<thread> make_thread() {
+  return std::make_unique<thread>([] { return std::make_unique<test::test_event_loop>(); });
+}
+
+}  // namespace
+
+
+TEST(incoming_task_queue_order) {
+  incoming_task_queue queue;
+  std::vector<int> ran;
+
+  CHECK(queue.push(make_node(1, ran)));
+  CHECK(!queue.push(make_node(2, ran)));
+
+  task_list batch;
+  batch.push(make_node(3, ran));
+  batch.push(make_node(4, ran));
+  CHECK(!queue.push_all(std::move(batch)));
+  CHECK(!queue.push(make_node(5, ran)));
+
+  run_tasks(queue.take_all());
+  CHECK((ran == std::vector<int>{ 1, 2, 3, 4, 5 }));
+
+  // empty again
+  CHECK(queue.take_all().empty());
+  CHECK(!queue.push_all(task_list()));
+  CHECK(queue.push(make_node(6, ran)));
+}
+
+TEST(incoming_task_queue_producers) {
+  // several threads push while one takes; each thread's nodes must come out in order
+  constexpr int per_producer = 20000;
+  incoming_task_queue queue;
+  std::vector<std::vector<int>> ran(producer_count);
+  std::atomic<int> producing = producer_count;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producer_count; p++) {
+    producers.emplace_back([&, p] {
+      // every fourth group of four nodes is pushed in one go
+      for (int i = 0; i < per_producer; i += 4) {
+        if (i % 16 == 0) {
+          task_list batch;
+          for (int j = i; j < i + 4; j++) {
+            batch.push(make_node(j, ran[p]));
+          }
+          queue.push_all(std::move(batch));
+        } else {
+          for (int j = i; j < i + 4; j++) {
+            queue.push(make_node(j, ran[p]));
+          }
+        }
+      }
+      producing--;
+    });
+  }
+
+  bool done = false;
+  while (!done) {
+    done = producing == 0;  // checked before taking, so that the last take gets everything
+    run_tasks(queue.take_all());
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+
+  for (const auto& values : ran) {
+    CHECK(values.size() == per_producer);
+    bool in_order = true;
+    for (std::size_t i = 0; i < values.size(); i++) {
+      in_order = in_order && values[i] == static_cast<int>(i);
+    }
+    CHECK(in_order);
+  }
+}
+
+TEST(loop_task_runner_cross_thread_posting) {
+  constexpr int per_producer = 20000;
+  auto consumer = make_thread();
+  auto runner = consumer->task_runner();
+
+  // only touched on the consumer thread
+  std::vector<int> last(producer_count, -1);
+  bool in_order = true;
+  int count = 0;
+  std::promise<void> all_ran;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producer_count; p++) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < per_producer; i++) {
+        runner->post_task([&, p, i] {
+          in_order = in_order && last[p] == i - 1;
+          last[p] = i;
+          if (++count == producer_count * per_producer) {
+            all_ran.set_value();
+          }
+        });
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+
+  all_ran.get_future().wait();
+  CHECK(in_order);
+  CHECK(count == producer_count * per_producer);
+}
+
+
+BENCHMARK(loop_task_runner_cross_thread_posting) {
+  constexpr int per_producer = 250000;
+  auto consumer = make_thread();
+  auto runner = consumer->task_runner();
+
+  test::measure("post and run 1M tasks from 4 threads", 1, [&] {
+    std::atomic<int> count = 0;
+    std::promise<void> all_ran;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producer_count; p++) {
+      producers.emplace_back([&] {
+        for (int i = 0; i < per_producer; i++) {
+          runner->post_task([&] {
+            if (++count == producer_count * per_producer) {
+              all_ran.set_value();
+            }
+          });
+        }
+      });
+    }
+    for (auto& t : producers) {
+      t.join();
+    }
+    all_ran.get_future().wait();
+  });
+}
\ No newline at end of file
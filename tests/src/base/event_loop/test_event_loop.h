@@ -0,0 +1,35 @@
+#pragma once
+
+#include "base/event_loop/event_loop.h"
+#include "base/task_runner/task.h"
+#include <condition_variable>
+#include <mutex>
+
+namespace test {
+
+// An event loop sleeping on a condition variable, which runs anywhere the standard library does.
+class test_event_loop : public base::event_loop {
+public:
+  void sleep(const base::task::delay_type* delay) override {
+    std::unique_lock hold(lock_);
+    if (delay) {
+      woken_cv_.wait_for(hold, *delay, [&] { return woken_; });
+    } else {
+      woken_cv_.wait(hold, [&] { return woken_; });
+    }
+    woken_ = false;
+  }
+
+  void wake_up() override {
+    std::scoped_lock hold(lock_);
+    woken_ = true;
+    woken_cv_.notify_one();
+  }
+
+private:
+  std::mutex lock_;
+  std::condition_variable woken_cv_;
+  bool woken_ = false;
+};
+
+}  // namespace test
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "test.h"
+#include "base/event_loop/test_event_loop.h"
+#include "base/event_loop/delayed_task_handle.h"
+#include "base/event_loop/impl/delayed_task_queue.h"
+#include "base/event_loop/impl/timer_wheel.h"
+#include "base/event_loop/loop_task_runner.h"
+#include "base/thread/thread.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace base;
+using namespace base::impl;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr task::delay_type resolution = 1ms;  // the default of timer_wheel
+
+struct scheduled {
+  task::run_time_type run_time;
+  task_node* in_wheel;
+  task_node* in_heap;
+  bool due_when_pushed;  // such tasks run in the order they were pushed
+  bool popped_by_wheel = false;
+  bool popped_by_heap = false;
+  bool canceled = false;
+};
+
+task_node_ptr make_node(const task::run_time_type& run_time) {
+  return std::make_unique<task_node>(task([] {}, run_time));
+}
+
+// delays from already due to well beyond the top level of the wheel, which spans about 4.6 hours
+task::delay_type random_delay(std::mt19937& rng) {
+  std::uniform_int_distribution<int> kind(0, 9);
+  auto between = [&](task::delay_type from, task::delay_type to) {
+    return task::delay_type(std::uniform_int_distribution<task::delay_type::rep>(from.count(), to.count())(rng));
+  };
+
+  switch (kind(rng)) {
+  case 0:
+    return between(-5ms, 0ms);
+  case 1:
+  case 2:
+    return between(0ms, 1ms);
+  case 3:
+  case 4:
+    return between(1ms, 64ms);
+  case 5:
+    return between(64ms, 4096ms);
+  case 6:
+    return between(4s, 5min);
+  case 7:
+    return between(5min, 5h);
+  default:
+    return between(5h, 12h);
+  }
+}
+
+// mostly small steps, with jumps across whole levels now and then
+task::delay_type random_step(std::mt19937& rng) {
+  std::uniform_int_distribution<int> kind(0, 19);
+  std::uniform_int_distribution<task::delay_type::rep> fraction(0, 999);
+  switch (kind(rng)) {
+  case 0:
+    return 1h * fraction(rng) / 100;
+  case 1:
+    return 1min * fraction(rng) / 100;
+  case 2:
+  case 3:
+    return 1s * fraction(rng) / 100;
+  default:
+    return 3ms * fraction(rng) / 1000;
+  }
+}
+
+// Runs the same random schedule through a timer_wheel and a delayed_task_heap. The heap pops
+// exactly the tasks that are due; the wheel must pop the same tasks, at most one tick late and
+// never early, and in order of their ticks, except for tasks already due when pushed.
+void compare_with_heap(unsigned seed, int steps) {
+  timer_wheel wheel;
+  delayed_task_heap heap;
+  task::run_time_type now = task::clock_type::now();  // just after the epoch of the wheel
+
+  std::vector<scheduled> tasks;
+  std::unordered_map<task_node*, std::size_t> wheel_ids;
+  std::unordered_map<task_node*, std::size_t> heap_ids;
+  std::set<std::pair<task::run_time_type, std::size_t>> in_wheel;  // not yet popped or canceled
+  std::vector<std::size_t> late;  // popped by the heap, but not yet by the wheel
+
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> op(0, 9);
+
+  auto pop_all = [&] {
+    while (task_node_ptr node = heap.pop_due(now)) {
+      std::size_t id = heap_ids.at(node.get());
+      heap_ids.erase(node.get());
+      tasks[id].popped_by_heap = true;
+      late.push_back(id);
+    }
+
+    task::run_time_type last_run_time;
+    bool first = true;
+    while (task_node_ptr node = wheel.pop_due(now)) {
+      std::size_t id = wheel_ids.at(node.get());
+      wheel_ids.erase(node.get());
+      scheduled& s = tasks[id];
+      CHECK(s.popped_by_heap);
+      CHECK(s.run_time <= now);
+      s.popped_by_wheel = true;
+      in_wheel.erase({ s.run_time, id });
+      if (!s.due_when_pushed) {
+        CHECK(first || s.run_time > last_run_time - resolution);
+        last_run_time = s.run_time;
+        first = false;
+      }
+    }
+
+    late.erase(std::remove_if(late.begin(), late.end(), [&](std::size_t id) {
+      return tasks[id].popped_by_wheel;
+    }), late.end());
+    for (std::size_t id : late) {
+      CHECK(tasks[id].run_time > now - resolution);
+    }
+  };
+
+  for (int step = 0; step < steps; step++) {
+    int what = op(rng);
+    if (what < 5) {
+      auto run_time = now + random_delay(rng);
+      auto wheel_node = make_node(run_time);
+      auto heap_node = make_node(run_time);
+      std::size_t id = tasks.size();
+      tasks.push_back({ run_time, wheel_node.get(), heap_node.get(), run_time <= now });
+      wheel_ids[wheel_node.get()] = id;
+      heap_ids[heap_node.get()] = id;
+      in_wheel.insert({ run_time, id });
+      wheel.push(std::move(wheel_node));
+      heap.push(std::move(heap_node));
+    } else if (what < 7) {
+      if (tasks.empty()) {
+        continue;
+      }
+      std::size_t id = std::uniform_int_distribution<std::size_t>(0, tasks.size() - 1)(rng);
+      scheduled& s = tasks[id];
+      if (s.popped_by_heap || s.popped_by_wheel || s.canceled) {
+        continue;
+      }
+      s.canceled = true;
+      wheel_ids.erase(s.in_wheel);
+      in_wheel.erase({ s.run_time, id });
+      wheel.cancel(s.in_wheel);
+      heap.cancel(s.in_heap);
+    } else {
+      now += random_step(rng);
+      pop_all();
+    }
+
+    if (step % 1000 == 0) {
+      wheel.remove_canceled();
+      heap.remove_canceled();
+    }
+
+    CHECK(wheel.size() == in_wheel.size());
+    auto next = wheel.next_run_time();
+    CHECK(next.has_value() == !in_wheel.empty());
+    if (next && !in_wheel.empty()) {
+      auto earliest = in_wheel.begin()->first;
+      CHECK(*next >= earliest);
+      // tasks already due when pushed come first, even if not the earliest
+      CHECK(*next < earliest + resolution || *next <= now);
+    }
+  }
+
+  // nothing is missed
+  now += 24h;
+  pop_all();
+  CHECK(late.empty());
+  CHECK(wheel.size() == 0);
+  CHECK(!wheel.next_run_time());
+  CHECK(!heap.next_run_time());
+  for (const auto& s : tasks) {
+    CHECK(s.canceled || (s.popped_by_wheel && s.popped_by_heap));
+  }
+}
+
+std::unique_ptr<thread> make_thread() {
+  return std::make_unique<thread>([] { return std::make_unique<test::test_event_loop>(); });
+}
+
+// posts delayed tasks through handles, cancels some of them in various ways and checks which ran
+void check_cancelable_tasks(delayed_task_strategy strategy) {
+  auto other = strategy == delayed_task_strategy::heap ? delayed_task_strategy::timer_wheel : delayed_task_strategy::heap;
+  constexpr int count = 100;
+
+  struct state {
+    std::vector<delayed_task_handle> handles = std::vector<delayed_task_handle>(count);
+    std::vector<int> ran;
+  };
+
+  auto loop = make_thread();
+  std::promise<std::vector<int>> result;
+  loop->task_runner()->post_task([&] {
+    auto runner = loop_task_runner::current();
+    auto st = std::make_shared<state>();
+
+    // the tasks are posted with the other strategy, and migrated halfway
+    runner->set_delayed_task_strategy(other);
+    for (int i = 0; i < count; i++) {
+      runner->post_cancelable_task([st, i] { st->ran.push_back(i); }, 1ms * (1 + i % 20), st->handles[i]);
+    }
+    for (int i = 0; i < count; i += 3) {
+      st->handles[i].cancel();
+    }
+    runner->set_delayed_task_strategy(strategy);
+    for (int i = 1; i < count; i += 3) {
+      st->handles[i].cancel();
+    }
+
+    // a handle cancels when destroyed, and follows its task when moved
+    {
+      delayed_task_handle scoped;
+      runner->post_cancelable_task([st] { st->ran.push_back(-1); }, 1ms, scoped);
+    }
+    delayed_task_handle moved = std::move(st->handles[2]);
+    CHECK(!st->handles[2].is_pending());
+    CHECK(moved.is_pending());
+    moved.cancel();
+    CHECK(!moved.is_pending());
+
+    runner->post_task([st, &result] {
+      for (const auto& handle : st->handles) {
+        CHECK(!handle.is_pending());  // either run or canceled
+      }
+      result.set_value(st->ran);
+      st->handles.clear();
+    }, 50ms);
+  });
+
+  std::vector<int> ran = result.get_future().get();
+  std::sort(ran.begin(), ran.end());
+  std::vector<int> expected;
+  for (int i = 0; i < count; i++) {
+    if (i % 3 == 2 && i != 2) {
+      expected.push_back(i);
+    }
+  }
+  CHECK(ran == expected);
+}
+
+}  // namespace
+
+
+TEST(timer_wheel_matches_heap) {
+  for (unsigned seed = 1; seed <= 8; seed++) {
+    compare_with_heap(seed, 20000);
+  }
+}
+
+TEST(timer_wheel_levels) {
+  // one task on every level and in the overflow list, reached by a single jump each
+  timer_wheel wheel;
+  auto now = task::clock_type::now();
+  task::delay_type delays[] = { 10ms, 100ms, 10s, 10min, 10h };
+  for (auto delay : delays) {
+    wheel.push(make_node(now + delay));
+  }
+  CHECK(wheel.size() == 5);
+
+  for (auto delay : delays) {
+    CHECK(!wheel.pop_due(now + delay - 1ms));
+    auto next = wheel.next_run_time();
+    CHECK(next && *next >= now + delay && *next < now + delay + resolution);
+
+    task_node_ptr node = wheel.pop_due(now + delay + resolution);
+    CHECK(node && node->tsk.run_time == now + delay);
+  }
+  CHECK(wheel.size() == 0);
+  CHECK(!wheel.next_run_time());
+}
+
+TEST(loop_task_runner_cancel_with_heap) {
+  check_cancelable_tasks(delayed_task_strategy::heap);
+}
+
+TEST(loop_task_runner_cancel_with_timer_wheel) {
+  check_cancelable_tasks(delayed_task_strategy::timer_wheel);
+}
\ No newline at end of file
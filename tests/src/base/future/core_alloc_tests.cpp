@@ -0,0 +1,160 @@
+#include "test.h"
+#include "base/event_loop/test_event_loop.h"
+#include "base/future/future.h"
+#include "base/future/impl/core_alloc.h"
+#include "base/thread/thread.h"
+#include "base/thread/thread_pool.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace base;
+using namespace base::impl;
+
+namespace {
+
+bool is_aligned(const void* ptr, std::size_t align) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % align == 0;
+}
+
+std::unique_ptr<thread> make_thread() {
+  return std::make_unique<thread>([] { return std::make_unique<test::test_event_loop>(); });
+}
+
+}  // namespace
+
+
+TEST(core_alloc_reuse) {
+  // a freed block is handed out again for any size of the same class
+  void* block = allocate_core(40, 8);
+  free_core(block, 40, 8);
+  void* again = allocate_core(64, 8);
+  CHECK(again == block);
+  free_core(again, 64, 8);
+
+  // but not for another class
+  void* larger = allocate_core(65, 8);
+  CHECK(larger != block);
+  free_core(larger, 65, 8);
+
+  // blocks come back last freed first
+  std::vector<void*> blocks;
+  for (int i = 0; i < 10; i++) {
+    blocks.push_back(allocate_core(100, 16));
+  }
+  for (void* ptr : blocks) {
+    free_core(ptr, 100, 16);
+  }
+  for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+    CHECK(allocate_core(100, 16) == *it);
+  }
+  for (void* ptr : blocks) {
+    free_core(ptr, 100, 16);
+  }
+}
+
+TEST(core_alloc_sizes) {
+  // every size up to the largest class and beyond, including over-aligned blocks
+  for (std::size_t size = 1; size <= 1024; size += 7) {
+    for (std::size_t align : { alignof(int), alignof(std::max_align_t), std::size_t(64) }) {
+      auto block = static_cast<unsigned char*>(allocate_core(size, align));
+      CHECK(is_aligned(block, align));
+      block[0] = 1;
+      block[size - 1] = 2;
+      free_core(block, size, align);
+    }
+  }
+}
+
+TEST(core_alloc_free_on_other_thread) {
+  // blocks freed on another thread are cached by that thread
+  std::vector<void*> blocks;
+  for (int i = 0; i < 100; i++) {
+    blocks.push_back(allocate_core(48, 8));
+  }
+
+  bool reused = true;
+  std::thread([&] {
+    for (void* ptr : blocks) {
+      free_core(ptr, 48, 8);
+    }
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+      reused = reused && allocate_core(48, 8) == *it;
+    }
+    // released when the thread exits
+    for (void* ptr : blocks) {
+      free_core(ptr, 48, 8);
+    }
+  }).join();
+  CHECK(reused);
+}
+
+TEST(core_alloc_future_chain) {
+  // each link allocates a core, freed once the link after it has run
+  constexpr int links = 100000;
+  auto loop = make_thread();
+  std::promise<int> done;
+  loop->task_runner()->post_task([&] {
+    promise<int> root;
+    future<int> fut = root.get_future();
+    for (int i = 0; i < links; i++) {
+      fut = std::move(fut).then([](int value) { return value + 1; });
+    }
+    std::move(fut).then([&](int value) { done.set_value(value); });
+    root.set(0);
+  });
+  CHECK(done.get_future().get() == links);
+}
+
+TEST(core_alloc_cross_thread_futures) {
+  // cores allocated on this thread, fulfilled on pool threads and released on the loop thread
+  constexpr int count = 20000;
+  auto loop = make_thread();
+  thread_pool pool(4);
+  std::atomic<int> sum = 0;
+  std::atomic<int> ran = 0;
+  std::promise<void> all_ran;
+
+  for (int i = 0; i < count; i++) {
+    promise<int> prom;
+    future<int> fut = prom.get_future();
+    pool.task_runner()->post_task([prom = std::move(prom), i]() mutable { prom.set(i); });
+    std::move(fut).then(loop->task_runner(), [&](int value) {
+      sum += value;
+      if (++ran == count) {
+        all_ran.set_value();
+      }
+    });
+  }
+
+  all_ran.get_future().wait();
+  CHECK(sum == count * (count - 1) / 2);
+}
+
+
+BENCHMARK(core_alloc_future_chain) {
+  constexpr int links = 1000000;
+  auto loop = make_thread();
+
+  test::measure("1M continuations", 1, [&] {
+    std::promise<void> done;
+    loop->task_runner()->post_task([&] {
+      promise<int> root;
+      future<int> fut = root.get_future();
+      for (int i = 0; i < links; i++) {
+        fut = std::move(fut).then([](int value) { return value + 1; });
+      }
+      std::move(fut).then([&](int) { done.set_value(); });
+      root.set(0);
+    });
+    done.get_future().wait();
+  });
+
+  test::measure("allocate and free", 1000000, [] {
+    free_core(allocate_core(96, 8), 96, 8);
+  });
+}
\ No newline at end of file
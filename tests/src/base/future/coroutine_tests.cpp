@@ -0,0 +1,205 @@
+#include "test.h"
+#include "base/event_loop/test_event_loop.h"
+#include "base/future/coroutine.h"
+#include "base/future/exceptions.h"
+#include "base/thread/thread.h"
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+using namespace base;
+
+namespace {
+
+std::unique_ptr<thread> make_thread() {
+  return std::make_unique<thread>([] { return std::make_unique<test::test_event_loop>(); });
+}
+
+// runs `fn` on `loop` and waits for it
+template<typename F>
+void run_on(thread& loop, F&& fn) {
+  std::promise<void> done;
+  loop.task_runner()->post_task([&] {
+    fn();
+    done.set_value();
+  });
+  done.get_future().wait();
+}
+
+struct on_destroy {
+  ~on_destroy() { *destroyed = true; }
+
+  std::atomic<bool>* destroyed;
+};
+
+future<int> add_one(future<int> fut, std::thread::id* before, std::thread::id* after) {
+  *before = std::this_thread::get_id();
+  int val = co_await std::move(fut);
+  *after = std::this_thread::get_id();
+  co_return val + 1;
+}
+
+future<int> pass_through(future<int> fut) {
+  co_return co_await std::move(fut);
+}
+
+future<int> recover(future<int> fut) {
+  try {
+    co_await std::move(fut);
+  } catch (const std::runtime_error&) {
+    co_return -1;
+  }
+  co_return 0;
+}
+
+future<void> fail_after(future<int> fut) {
+  co_await std::move(fut);
+  throw std::logic_error("failed");
+}
+
+future<int> track_frame(future<int> fut, std::atomic<bool>* destroyed, std::atomic<bool>* resumed) {
+  on_destroy guard{ destroyed };
+  int val = co_await std::move(fut);
+  *resumed = true;
+  co_return val;
+}
+
+template<typename T, typename Exc>
+bool holds(const expected<T>& val) {
+  try {
+    std::rethrow_exception(val.get_exception());
+  } catch (const Exc&) {
+    return true;
+  } catch (...) {
+  }
+  return false;
+}
+
+std::atomic<int> frames_allocated = 0;
+std::atomic<int> frames_freed = 0;
+std::atomic<std::size_t> bytes_outstanding = 0;
+
+void* counting_allocate(std::size_t size) {
+  frames_allocated++;
+  bytes_outstanding += size;
+  return ::operator new(size);
+}
+
+void counting_deallocate(void* ptr, std::size_t size) {
+  frames_freed++;
+  bytes_outstanding -= size;
+  ::operator delete(ptr);
+}
+
+}  // namespace
+
+
+TEST(coroutine_resumes_on_runner) {
+  auto loop = make_thread();
+
+  // fulfilled from another thread: the coroutine is resumed by a task posted to its runner
+  promise<int> prom;
+  std::thread::id before;
+  std::thread::id after;
+  std::promise<int> result;
+  run_on(*loop, [&] {
+    add_one(prom.get_future(), &before, &after).then([&](int val) { result.set_value(val); });
+  });
+  std::thread([&] { prom.set(41); }).join();
+  CHECK(result.get_future().get() == 42);
+  CHECK(before == after);
+  CHECK(before != std::this_thread::get_id());
+
+  // fulfilled on the runner's own thread: resumed inline, before set() returns
+  run_on(*loop, [&] {
+    promise<int> local;
+    std::thread::id local_before;
+    std::thread::id local_after;
+    int local_result = 0;
+    add_one(local.get_future(), &local_before, &local_after).then(inline_if_current, [&](int val) {
+      local_result = val;
+    });
+    local.set(1);
+    CHECK(local_result == 2);
+    CHECK(local_after == std::this_thread::get_id());
+  });
+}
+
+TEST(coroutine_exceptions) {
+  auto loop = make_thread();
+  promise<int> failing;
+  promise<int> recovering;
+  promise<int> succeeding;
+  std::promise<expected<int>> passed;
+  std::promise<expected<int>> recovered;
+  std::promise<expected<void>> thrown;
+
+  run_on(*loop, [&] {
+    pass_through(failing.get_future()).then([&](expected<int> val) { passed.set_value(std::move(val)); });
+    recover(recovering.get_future()).then([&](expected<int> val) { recovered.set_value(std::move(val)); });
+    fail_after(succeeding.get_future()).then([&](expected<void> val) { thrown.set_value(std::move(val)); });
+  });
+  failing.set_exception(std::runtime_error("awaited"));
+  recovering.set_exception(std::runtime_error("awaited"));
+  succeeding.set(0);
+
+  // an exception from the awaited future is thrown by co_await, and fails the coroutine's future
+  // unless caught; one thrown by the coroutine itself fails its future too
+  auto passed_val = passed.get_future().get();
+  CHECK((holds<int, std::runtime_error>(passed_val)));
+  auto recovered_val = recovered.get_future().get();
+  CHECK(recovered_val.has_value() && recovered_val.get() == -1);
+  auto thrown_val = thrown.get_future().get();
+  CHECK((holds<void, std::logic_error>(thrown_val)));
+}
+
+TEST(coroutine_expired_runner) {
+  auto loop = make_thread();
+  auto other = make_thread();
+  promise<int> prom;
+  std::atomic<bool> destroyed = false;
+  std::atomic<bool> resumed = false;
+  std::promise<expected<int>> result;
+
+  run_on(*loop, [&] {
+    track_frame(prom.get_future(), &destroyed, &resumed).then(other->task_runner(), [&](expected<int> val) {
+      result.set_value(std::move(val));
+    });
+  });
+  loop.reset();
+
+  // with its runner gone, the coroutine is destroyed instead of resumed, abandoning its future
+  prom.set(1);
+  auto val = result.get_future().get();
+  CHECK((holds<int, abandoned_promise>(val)));
+  CHECK(destroyed);
+  CHECK(!resumed);
+}
+
+// installs an allocator for the rest of the process, so it comes last; the frames of the previous
+// tests have all been freed by now
+TEST(coroutine_frame_allocator) {
+  set_coroutine_frame_allocator({ counting_allocate, counting_deallocate });
+
+  auto loop = make_thread();
+  promise<int> prom;
+  std::promise<int> result;
+  run_on(*loop, [&] {
+    pass_through(prom.get_future()).then([&](int val) { result.set_value(val); });
+  });
+  CHECK(frames_allocated == 1);
+  CHECK(frames_freed == 0);
+  CHECK(bytes_outstanding > 0);
+
+  prom.set(7);
+  CHECK(result.get_future().get() == 7);
+  run_on(*loop, [] {});
+  CHECK(frames_freed == 1);
+  CHECK(bytes_outstanding == 0);
+}
\ No newline at end of file
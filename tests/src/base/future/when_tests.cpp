@@ -0,0 +1,148 @@
+#include "test.h"
+#include "base/event_loop/test_event_loop.h"
+#include "base/future/exceptions.h"
+#include "base/future/when.h"
+#include "base/thread/thread.h"
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace base;
+
+namespace {
+
+std::unique_ptr<thread> make_thread() {
+  return std::make_unique<thread>([] { return std::make_unique<test::test_event_loop>(); });
+}
+
+// waits for `fut`, whose continuation runs on `loop`
+template<typename T>
+expected<T> wait(thread& loop, future<T> fut) {
+  std::promise<expected<T>> result;
+  std::move(fut).then(loop.task_runner(), [&](expected<T> val) {
+    result.set_value(std::move(val));
+  });
+  return result.get_future().get();
+}
+
+template<typename Exc, typename T>
+bool holds(const expected<T>& val) {
+  try {
+    std::rethrow_exception(val.get_exception());
+  } catch (const Exc&) {
+    return true;
+  } catch (...) {
+  }
+  return false;
+}
+
+}  // namespace
+
+
+TEST(when_all_empty) {
+  auto loop = make_thread();
+
+  std::vector<future<int>> none;
+  auto results = wait(*loop, when_all(none.begin(), none.end()));
+  CHECK(results.has_value() && results.get().empty());
+
+  auto tuple = wait(*loop, when_all());
+  CHECK(tuple.has_value());
+}
+
+TEST(when_all_mixed_errors) {
+  auto loop = make_thread();
+
+  // every input is reported in its place, whether it succeeded, failed or was abandoned
+  std::vector<future<int>> futs;
+  std::optional<promise<int>> proms[4];
+  for (auto& prom : proms) {
+    prom.emplace();
+    futs.push_back(prom->get_future());
+  }
+  auto all = when_all(futs.begin(), futs.end());
+  std::thread([&] { proms[2]->set(2); }).join();
+  proms[0]->set_exception(std::runtime_error("failed"));
+  proms[3].reset();
+  proms[1]->set(1);
+
+  auto results = wait(*loop, std::move(all));
+  CHECK(results.has_value());
+  const auto& vals = results.get();
+  CHECK(vals.size() == 4);
+  CHECK(holds<std::runtime_error>(vals[0]));
+  CHECK(vals[1].has_value() && vals[1].get() == 1);
+  CHECK(vals[2].has_value() && vals[2].get() == 2);
+  CHECK(holds<abandoned_promise>(vals[3]));
+
+  promise<int> value;
+  promise<void> error;
+  auto tuple = when_all(value.get_future(), error.get_future());
+  error.set_exception(std::logic_error("failed"));
+  value.set(7);
+  auto tuple_results = wait(*loop, std::move(tuple));
+  CHECK(tuple_results.has_value());
+  CHECK(std::get<0>(tuple_results.get()).get() == 7);
+  CHECK(holds<std::logic_error>(std::get<1>(tuple_results.get())));
+
+  // when_any reports an error like any other result
+  promise<int> failing;
+  promise<int> pending;
+  auto any = when_any(failing.get_future(), pending.get_future());
+  failing.set_exception(std::runtime_error("failed"));
+  auto first = wait(*loop, std::move(any));
+  CHECK(first.has_value() && first.get().index == 0);
+  CHECK(holds<std::runtime_error>(first.get().result));
+  pending.set(1);
+}
+
+TEST(when_any_race) {
+  // all inputs fulfilled at once from different threads: exactly one wins, with its own value
+  constexpr int input_count = 4;
+  constexpr int rounds = 500;
+  auto loop = make_thread();
+
+  for (int round = 0; round < rounds; round++) {
+    std::vector<promise<int>> proms(input_count);
+    std::vector<future<int>> futs;
+    for (auto& prom : proms) {
+      futs.push_back(prom.get_future());
+    }
+
+    std::atomic<int> conts_run = 0;
+    std::promise<when_any_result<int>> winner;
+    when_any(futs.begin(), futs.end()).then(loop->task_runner(), [&](when_any_result<int> val) {
+      conts_run++;
+      winner.set_value(std::move(val));
+    });
+
+    std::atomic<int> ready = 0;
+    std::vector<std::thread> setters;
+    for (int i = 0; i < input_count; i++) {
+      setters.emplace_back([&, i] {
+        ready++;
+        while (ready < input_count) {
+        }
+        proms[i].set(i * 10);
+      });
+    }
+    for (auto& t : setters) {
+      t.join();
+    }
+
+    auto result = winner.get_future().get();
+    CHECK(result.index < input_count);
+    CHECK(result.result.has_value() && result.result.get() == static_cast<int>(result.index) * 10);
+    std::promise<void> flushed;
+    loop->task_runner()->post_task([&] { flushed.set_value(); });
+    flushed.get_future().wait();
+    CHECK(conts_run == 1);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "test.h"
+#include "base/logging/logging.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+struct flush_counts {
+  std::atomic<int> writes = 0;
+  std::atomic<int> flushes = 0;
+  std::atomic<int> periodic_flushes = 0;
+};
+
+class counting_sink : public logging::sink {
+public:
+  explicit counting_sink(flush_counts& counts) : counts_(counts) {}
+
+  void write(const char*) override { counts_.writes++; }
+  void flush() override { counts_.flushes++; }
+  void periodic_flush() override { counts_.periodic_flushes++; }
+
+private:
+  flush_counts& counts_;
+};
+
+}  // namespace
+
+
+TEST(logging_flushes) {
+  flush_counts counts;
+  logging::async_options options;
+  options.flush_interval = 10ms;
+  logging::init(std::make_unique<counting_sink>(counts), logging::level::info, false, options);
+
+  // an explicit flush always reaches the sink, even with nothing new to write
+  LOG(info) << "message";
+  logging::flush();
+  CHECK(counts.writes == 1);
+  CHECK(counts.flushes == 1);
+  logging::flush();
+  CHECK(counts.flushes == 2);
+
+  // while idle, the logging thread keeps flushing periodically
+  int periodic = counts.periodic_flushes;
+  for (int i = 0; i < 5000 && counts.periodic_flushes < periodic + 3; i++) {
+    std::this_thread::sleep_for(1ms);
+  }
+  CHECK(counts.periodic_flushes >= periodic + 3);
+  CHECK(counts.flushes == 2);
+
+  logging::init(nullptr, logging::level::info, false);
+}
\ No newline at end of file
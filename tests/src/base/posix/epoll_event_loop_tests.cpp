@@ -0,0 +1,208 @@
+#include "test.h"
+#include "base/event_loop/loop_task_runner.h"
+#include "base/posix/epoll_event_loop.h"
+#include "base/thread/thread.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace base;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::unique_ptr<thread> make_thread() {
+  return std::make_unique<thread>([] { return std::make_unique<posix::epoll_event_loop>(); });
+}
+
+posix::epoll_event_loop& current_loop() {
+  return static_cast<posix::epoll_event_loop&>(*event_loop::current());
+}
+
+// runs `fn` on `loop` and waits for it
+template<typename F>
+void run_on(thread& loop, F&& fn) {
+  std::promise<void> done;
+  loop.task_runner()->post_task([&] {
+    fn();
+    done.set_value();
+  });
+  done.get_future().wait();
+}
+
+void signal_eventfd(int fd) {
+  std::uint64_t val = 1;
+  CHECK(::write(fd, &val, sizeof(val)) == sizeof(val));
+}
+
+}  // namespace
+
+
+TEST(epoll_event_loop_delayed_tasks) {
+  auto loop = make_thread();
+  std::vector<int> order;  // only touched on the loop thread
+  std::promise<void> all_ran;
+
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::duration elapsed[3];
+  auto post = [&](int index, task::delay_type delay) {
+    loop->task_runner()->post_task([&, index] {
+      elapsed[index] = std::chrono::steady_clock::now() - start;
+      order.push_back(index);
+      if (order.size() == 3) {
+        all_ran.set_value();
+      }
+    }, delay);
+  };
+  post(2, 60ms);
+  post(0, 20ms);
+  post(1, 40ms);
+
+  CHECK(all_ran.get_future().wait_for(5s) == std::future_status::ready);
+  CHECK((order == std::vector<int>{ 0, 1, 2 }));
+  CHECK(elapsed[0] >= 20ms);
+  CHECK(elapsed[1] >= 40ms);
+  CHECK(elapsed[2] >= 60ms);
+}
+
+TEST(epoll_event_loop_cross_thread_wake_ups) {
+  auto loop = make_thread();
+
+  // every task has to wake the loop from epoll_wait
+  for (int i = 0; i < 1000; i++) {
+    std::promise<void> ran;
+    loop->task_runner()->post_task([&] { ran.set_value(); });
+    CHECK(ran.get_future().wait_for(5s) == std::future_status::ready);
+  }
+
+  // many producers at once, while the loop goes back and forth between running and sleeping
+  constexpr int producer_count = 4;
+  constexpr int per_producer = 10000;
+  std::atomic<int> count = 0;
+  std::promise<void> all_ran;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producer_count; p++) {
+    producers.emplace_back([&] {
+      for (int i = 0; i < per_producer; i++) {
+        loop->task_runner()->post_task([&] {
+          if (++count == producer_count * per_producer) {
+            all_ran.set_value();
+          }
+        });
+        if (i % 1000 == 0) {
+          std::this_thread::sleep_for(1ms);
+        }
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  CHECK(all_ran.get_future().wait_for(5s) == std::future_status::ready);
+}
+
+TEST(epoll_event_loop_nested) {
+  auto loop = make_thread();
+  std::vector<int> order;
+  std::promise<void> done;
+
+  loop->task_runner()->post_task([&] {
+    CHECK(event_loop::nesting_level() == 1);
+    event_loop& outer = *event_loop::current();
+
+    // tasks posted from another thread and delayed tasks both reach the nested loop
+    std::thread poster([&] {
+      loop->task_runner()->post_task([&] {
+        order.push_back(1);
+        loop_task_runner::current()->post_task([&] {
+          order.push_back(2);
+          CHECK(event_loop::nesting_level() == 2);
+          event_loop::current()->quit();  // the nested loop only
+        }, 20ms);
+      });
+    });
+
+    posix::epoll_event_loop nested;
+    nested.run();
+    poster.join();
+
+    CHECK(event_loop::current() == &outer);
+    CHECK(event_loop::nesting_level() == 1);
+    order.push_back(3);
+
+    // the outer loop goes on running tasks
+    loop_task_runner::current()->post_task([&] {
+      order.push_back(4);
+      done.set_value();
+    });
+  });
+
+  CHECK(done.get_future().wait_for(5s) == std::future_status::ready);
+  CHECK((order == std::vector<int>{ 1, 2, 3, 4 }));
+}
+
+TEST(epoll_event_loop_watches) {
+  auto loop = make_thread();
+  int fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  CHECK(fd >= 0);
+  int other_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  CHECK(other_fd >= 0);
+
+  // the watch removes itself on its third call, after adding another one from the first
+  std::atomic<int> calls = 0;
+  std::atomic<int> other_calls = 0;
+  std::promise<void> third_call;
+  run_on(*loop, [&] {
+    current_loop().add_watch(fd, EPOLLIN, [&](std::uint32_t events) {
+      CHECK((events & EPOLLIN) != 0);
+      std::uint64_t val;
+      CHECK(::read(fd, &val, sizeof(val)) == sizeof(val));
+
+      int call = ++calls;
+      if (call == 1) {
+        current_loop().add_watch(other_fd, EPOLLIN, [&](std::uint32_t) {
+          std::uint64_t val;
+          CHECK(::read(other_fd, &val, sizeof(val)) == sizeof(val));
+          other_calls++;
+        });
+      } else if (call == 3) {
+        current_loop().remove_watch(fd);
+        third_call.set_value();
+      }
+    });
+  });
+
+  auto wait_for = [](std::atomic<int>& counter, int value) {
+    for (int i = 0; i < 5000 && counter < value; i++) {
+      std::this_thread::sleep_for(1ms);
+    }
+    return counter == value;
+  };
+
+  signal_eventfd(fd);
+  CHECK(wait_for(calls, 1));
+  signal_eventfd(other_fd);
+  CHECK(wait_for(other_calls, 1));
+  signal_eventfd(fd);
+  CHECK(wait_for(calls, 2));
+  signal_eventfd(fd);
+  CHECK(third_call.get_future().wait_for(5s) == std::future_status::ready);
+
+  // no longer watched, while the other watch still works
+  signal_eventfd(fd);
+  signal_eventfd(other_fd);
+  CHECK(wait_for(other_calls, 2));
+  run_on(*loop, [] {});
+  CHECK(calls == 3);
+
+  run_on(*loop, [&] { current_loop().remove_watch(other_fd); });
+  ::close(fd);
+  ::close(other_fd);
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "test.h"
+#include "base/posix/file.h"
+#include "base/posix/io_ring.h"
+#include "base/posix/uring_event_loop.h"
+#include "base/thread/thread.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <limits>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <unistd.h>
+
+using namespace base;
+using posix::file;
+
+namespace {
+
+// io_uring may be missing from the kernel (ENOSYS) or disabled by the system (EPERM)
+bool has_io_uring() {
+  try {
+    posix::io_ring ring(4);
+    return true;
+  } catch (const std::system_error& e) {
+    if (e.code().value() != ENOSYS && e.code().value() != EPERM) {
+      throw;
+    }
+    std::printf("  skipped: io_uring is not available (%s)\n", e.code().message().c_str());
+    return false;
+  }
+}
+
+std::unique_ptr<thread> make_thread() {
+  return std::make_unique<thread>([] { return std::make_unique<posix::uring_event_loop>(); });
+}
+
+// a file in the temporary directory, removed once done
+class temp_file {
+public:
+  explicit temp_file(const char* name)
+    : path_(std::filesystem::temp_directory_path() / (std::string(name) + "." + std::to_string(::getpid()))) {
+  }
+
+  ~temp_file() {
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+  }
+
+  const std::filesystem::path& path() const { return path_; }
+
+private:
+  std::filesystem::path path_;
+};
+
+// runs `fn` on `loop` and waits for it
+template<typename F>
+void run_on(thread& loop, F&& fn) {
+  std::promise<void> done;
+  loop.task_runner()->post_task([&] {
+    fn();
+    done.set_value();
+  });
+  done.get_future().wait();
+}
+
+// starts the operation returned by `op` on `loop` and waits for its result
+template<typename F>
+expected<unsigned long> complete(thread& loop, F&& op) {
+  std::promise<expected<unsigned long>> result;
+  loop.task_runner()->post_task([&] {
+    op().then([&](expected<unsigned long> val) {
+      result.set_value(std::move(val));
+    });
+  });
+  return result.get_future().get();
+}
+
+int error_of(const expected<unsigned long>& val) {
+  try {
+    std::rethrow_exception(val.get_exception());
+  } catch (const std::system_error& e) {
+    return e.code().value();
+  } catch (...) {
+  }
+  return 0;
+}
+
+}  // namespace
+
+
+TEST(uring_file_read_write) {
+  if (!has_io_uring()) {
+    return;
+  }
+
+  auto loop = make_thread();
+  temp_file name("uring_file_read_write");
+  file f(name.path(), file::in | file::out, file::create_disp::create_always);
+
+  const std::string text = "hello, world";
+  CHECK(complete(*loop, [&] { return f.write(0, text); }).get() == text.size());
+  CHECK(f.length() == static_cast<file::offset_type>(text.size()));
+
+  char buf[5];
+  CHECK(complete(*loop, [&] { return f.read(7, buf); }).get() == 5);
+  CHECK(std::memcmp(buf, "world", 5) == 0);
+
+  // short reads at the end of the file
+  CHECK(complete(*loop, [&] { return f.read(10, buf); }).get() == 2);
+  CHECK(complete(*loop, [&] { return f.read(100, buf); }).get() == 0);
+}
+
+TEST(uring_file_vectored) {
+  if (!has_io_uring()) {
+    return;
+  }
+
+  auto loop = make_thread();
+  temp_file name("uring_file_vectored");
+  file f(name.path(), file::in | file::out, file::create_disp::create_always);
+
+  // the iovec arrays only live until the calls return, before the batch is submitted
+  char a[] = "abc";
+  char b[] = "defgh";
+  char c[] = "ij";
+  CHECK(complete(*loop, [&] {
+    iovec bufs[] = { { a, 3 }, { b, 5 }, { c, 2 } };
+    return f.writev(0, bufs);
+  }).get() == 10);
+
+  char first[4] = {};
+  char second[6] = {};
+  CHECK(complete(*loop, [&] {
+    iovec bufs[] = { { first, 4 }, { second, 6 } };
+    return f.readv(0, bufs);
+  }).get() == 10);
+  CHECK(std::memcmp(first, "abcd", 4) == 0);
+  CHECK(std::memcmp(second, "efghij", 6) == 0);
+}
+
+TEST(uring_file_fixed_buffers) {
+  if (!has_io_uring()) {
+    return;
+  }
+
+  auto loop = make_thread();
+  temp_file name("uring_file_fixed_buffers");
+  file f(name.path(), file::in | file::out, file::create_disp::create_always);
+
+  std::vector<char> out(4096, 'x');
+  std::vector<char> in(4096);
+  std::memcpy(out.data() + 100, "fixed", 5);
+  run_on(*loop, [&] {
+    iovec bufs[] = { { out.data(), out.size() }, { in.data(), in.size() } };
+    file::register_buffers(bufs);
+  });
+
+  CHECK(complete(*loop, [&] { return f.write_fixed(0, out.data(), 4096, 0); }).get() == 4096);
+  // into the middle of the registered buffer
+  CHECK(complete(*loop, [&] { return f.read_fixed(100, in.data() + 10, 5, 1); }).get() == 5);
+  CHECK(std::memcmp(in.data() + 10, "fixed", 5) == 0);
+
+  run_on(*loop, [] { file::unregister_buffers(); });
+}
+
+TEST(uring_file_batching) {
+  if (!has_io_uring()) {
+    return;
+  }
+
+  // more operations started by one task than fit in the rings at once
+  constexpr int count = 2000;
+  auto loop = make_thread();
+  temp_file name("uring_file_batching");
+  file f(name.path(), file::in | file::out, file::create_disp::create_always);
+
+  std::vector<std::uint32_t> values(count);
+  for (int i = 0; i < count; i++) {
+    values[i] = i * 7919u;
+  }
+
+  auto start_all = [&](auto op) {
+    std::promise<int> failures;
+    loop->task_runner()->post_task([&] {
+      auto remaining = std::make_shared<int>(count);
+      auto failed = std::make_shared<int>(0);
+      for (int i = 0; i < count; i++) {
+        op(i).then([&, remaining, failed](expected<unsigned long> val) {
+          *failed += !val.has_value() || val.get() != sizeof(std::uint32_t);
+          if (--*remaining == 0) {
+            failures.set_value(*failed);
+          }
+        });
+      }
+    });
+    return failures.get_future().get();
+  };
+
+  CHECK(start_all([&](int i) { return f.write(i * sizeof(std::uint32_t), &values[i], sizeof(std::uint32_t)); }) == 0);
+  CHECK(f.length() == static_cast<file::offset_type>(count * sizeof(std::uint32_t)));
+
+  std::vector<std::uint32_t> read_back(count);
+  CHECK(start_all([&](int i) { return f.read(i * sizeof(std::uint32_t), &read_back[i], sizeof(std::uint32_t)); }) == 0);
+  CHECK(read_back == values);
+}
+
+TEST(uring_file_errors) {
+  if (!has_io_uring()) {
+    return;
+  }
+
+  auto loop = make_thread();
+  temp_file name("uring_file_errors");
+  {
+    file f(name.path(), file::out, file::create_disp::create_always);
+    char buf[4];
+    CHECK(error_of(complete(*loop, [&] { return f.read(0, buf); })) == EBADF);
+
+    // requests longer than an sqe can describe fail without being submitted; neither the buffer
+    // nor the iovec array is touched
+    unsigned long too_long = std::numeric_limits<std::uint32_t>::max() + 1ul;
+    CHECK(error_of(complete(*loop, [&] { return f.write(0, buf, too_long); })) == EINVAL);
+    CHECK(error_of(complete(*loop, [&] { return f.readv(0, span<const iovec>(nullptr, too_long)); })) == EINVAL);
+  }
+
+  bool threw = false;
+  try {
+    file f(name.path(), file::in, file::create_disp::create_only);
+  } catch (const std::system_error& e) {
+    threw = e.code().value() == EEXIST;
+  }
+  CHECK(threw);
+}
\ No newline at end of file
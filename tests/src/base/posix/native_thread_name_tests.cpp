@@ -0,0 +1,56 @@
+#include "test.h"
+#include "base/thread/thread_name.h"
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <utility>
+#include <pthread.h>
+
+using namespace base;
+
+namespace {
+
+std::string truncated(std::string name, std::size_t max_size) {
+  impl::truncate_thread_name(name, max_size);
+  return name;
+}
+
+// names a new thread `name`, and returns the names it then has for the os and for base
+std::pair<std::string, std::string> name_thread(const std::string& name) {
+  std::pair<std::string, std::string> names;
+  std::thread([&] {
+    set_current_thread_name(name);
+    char native[16] = {};
+    CHECK(::pthread_getname_np(::pthread_self(), native, sizeof(native)) == 0);
+    names = { native, get_current_thread_name() };
+  }).join();
+  return names;
+}
+
+}  // namespace
+
+
+TEST(truncate_thread_name) {
+  CHECK(truncated("short", 15) == "short");
+  CHECK(truncated("exactly15bytes.", 15) == "exactly15bytes.");
+  CHECK(truncated("sixteen bytes...", 15) == "sixteen bytes..");
+
+  // "é" is two bytes, "€" three and "𝄞" four; none of them is split
+  CHECK(truncated("aaaaaaaaaaaaaa\xc3\xa9", 15) == "aaaaaaaaaaaaaa");
+  CHECK(truncated("aaaaaaaaaaaaa\xe2\x82\xac", 15) == "aaaaaaaaaaaaa");
+  CHECK(truncated("aaaaaaaaaaaa\xf0\x9d\x84\x9e", 15) == "aaaaaaaaaaaa");
+  CHECK(truncated("aaaaaaaaaaa\xf0\x9d\x84\x9e", 15) == "aaaaaaaaaaa\xf0\x9d\x84\x9e");
+  CHECK(truncated("\xf0\x9d\x84\x9e\xf0\x9d\x84\x9e", 3).empty());
+}
+
+TEST(native_thread_name) {
+  auto [native, name] = name_thread("worker");
+  CHECK(native == "worker");
+  CHECK(name == "worker");
+
+  // linux keeps 15 bytes, without splitting the "€" straddling the limit; base keeps the whole name
+  std::string long_name = "render worker \xe2\x82\xac 2";
+  auto [long_native, long_base] = name_thread(long_name);
+  CHECK(long_native == "render worker ");
+  CHECK(long_base == long_name);
+}
\ No newline at end of file
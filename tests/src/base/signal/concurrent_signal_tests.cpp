@@ -0,0 +1,202 @@
+#include "test.h"
+#include "base/signal/concurrent_signal.h"
+#include "base/signal/scoped_slot_handle.h"
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace base;
+
+namespace {
+
+constexpr int emitter_count = 4;
+constexpr int connector_count = 2;
+
+// counts the instances alive, which lets a slot tell how long the snapshots referring to it live
+struct instance_counter {
+  instance_counter(std::atomic<int>& alive) : alive(&alive) { ++alive; }
+  instance_counter(const instance_counter& other) : alive(other.alive) { ++*alive; }
+  ~instance_counter() { --*alive; }
+
+  std::atomic<int>* alive;
+};
+
+}  // namespace
+
+
+TEST(concurrent_signal_basics) {
+  concurrent_signal<int> sig;
+  int sum = 0;
+  slot_handle ones = sig.connect([&](int value) { sum += value; });
+  slot_handle tens;
+  tens = sig.connect([&](int value) {
+    sum += 10 * value;
+    tens.disconnect();  // during emission
+  });
+  slot_handle hundreds = sig.connect([&](int value) { sum += 100 * value; });
+
+  sig(1);
+  CHECK(sum == 111);
+  CHECK(!tens.connected());
+  sig(1);
+  CHECK(sum == 212);
+
+  hundreds.block();
+  sig(1);
+  CHECK(sum == 213);
+  hundreds.block(false);
+
+  {
+    scoped_slot_handle scoped = sig.connect([&](int) { sum += 1000; });
+    sig(0);
+    CHECK(sum == 1213);
+  }
+  sig(0);
+  CHECK(sum == 1213);
+
+  // connecting during emission doesn't call the new slot until the next one
+  int nested_calls = 0;
+  slot_handle nested;
+  slot_handle connector = sig.connect([&](int) {
+    if (!nested.connected()) {
+      nested = sig.connect([&](int) { nested_calls++; });
+    }
+  });
+  sig(0);
+  CHECK(nested_calls == 0);
+  sig(0);
+  CHECK(nested_calls == 1);
+
+  ones.disconnect();
+  ones.disconnect();
+  CHECK(!ones.connected());
+}
+
+TEST(concurrent_signal_stress) {
+  // emitters run flat out while other threads connect and disconnect; the slots left connected
+  // at the end are each called exactly once by the last emission
+  constexpr int connections = 500;
+  constexpr int kept_every = 50;
+  concurrent_signal<> sig;
+  std::atomic<long> calls = 0;
+  std::atomic<bool> stop = false;
+
+  std::vector<std::thread> emitters;
+  for (int t = 0; t < emitter_count; t++) {
+    emitters.emplace_back([&] {
+      while (!stop) {
+        sig();
+      }
+    });
+  }
+
+  std::vector<std::vector<slot_handle>> kept(connector_count);
+  std::vector<std::thread> connectors;
+  for (int t = 0; t < connector_count; t++) {
+    connectors.emplace_back([&, t] {
+      for (int i = 0; i < connections; i++) {
+        slot_handle handle = sig.connect([&] { calls++; });
+        if (i % kept_every == 0) {
+          kept[t].push_back(handle);
+          continue;
+        }
+        if (i % 2 == 0) {
+          std::this_thread::yield();
+        }
+        handle.disconnect();
+      }
+    });
+  }
+
+  for (auto& t : connectors) {
+    t.join();
+  }
+  stop = true;
+  for (auto& t : emitters) {
+    t.join();
+  }
+
+  long before = calls;
+  sig();
+  CHECK(calls - before == connector_count * connections / kept_every);
+
+  for (auto& handles : kept) {
+    for (auto& handle : handles) {
+      handle.disconnect();
+    }
+  }
+  before = calls;
+  sig();
+  CHECK(calls == before);
+}
+
+TEST(concurrent_signal_reclaims_while_emitting) {
+  // emissions never stop, so no moment is free of them; each snapshot must still be freed as soon
+  // as the emissions walking it are done, as every emitter walks a single snapshot at a time
+  constexpr int publishes = 20000;
+  concurrent_signal<> sig;
+  std::atomic<bool> stop = false;
+  std::atomic<int> alive = 0;
+
+  std::vector<std::thread> emitters;
+  for (int t = 0; t < emitter_count; t++) {
+    emitters.emplace_back([&] {
+      while (!stop) {
+        sig();
+      }
+    });
+  }
+
+  // the slot is referred to by the snapshot made when connecting, which is retired on disconnecting
+  int most_alive = 0;
+  for (int i = 0; i < publishes; i++) {
+    sig.connect([counter = instance_counter(alive)] {}).disconnect();
+    most_alive = std::max(most_alive, alive.load());
+  }
+  CHECK(most_alive <= emitter_count + 1);
+
+  stop = true;
+  for (auto& t : emitters) {
+    t.join();
+  }
+  sig.connect([] {}).disconnect();
+  CHECK(alive == 0);
+}
+
+
+BENCHMARK(concurrent_signal_emit) {
+  for (int slot_count : { 1, 10, 1000 }) {
+    concurrent_signal<int> sig;
+    std::atomic<long> sum = 0;
+    std::vector<slot_handle> handles;
+    for (int i = 0; i < slot_count; i++) {
+      handles.push_back(sig.connect([&](int value) { sum.fetch_add(value, std::memory_order_relaxed); }));
+    }
+
+    // about the same number of slot calls for each slot count
+    int emissions = 1000000 / slot_count;
+    std::string slots = std::to_string(slot_count) + (slot_count == 1 ? " slot" : " slots");
+
+    test::measure(("emit to " + slots).c_str(), emissions, [&] { sig(1); });
+
+    test::measure(("emit to " + slots + " from 4 threads").c_str(), 1, [&] {
+      std::vector<std::thread> emitters;
+      for (int t = 0; t < emitter_count; t++) {
+        emitters.emplace_back([&] {
+          for (int i = 0; i < emissions / emitter_count; i++) {
+            sig(1);
+          }
+        });
+      }
+      for (auto& t : emitters) {
+        t.join();
+      }
+    });
+
+    test::measure(("connect and disconnect with " + slots).c_str(), 100000 / slot_count + 100, [&] {
+      sig.connect([](int) {}).disconnect();
+    });
+  }
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "test.h"
+#include "base/signal/signal.h"
+#include "base/task_runner/task_runner.h"
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace base;
+
+namespace {
+
+// keeps the posted tasks until the test runs them
+class manual_task_runner : public task_runner {
+public:
+  bool runs_tasks_on_current_thread() const override { return true; }
+
+  std::size_t pending() const { return tasks_.size(); }
+
+  void run_all() {
+    while (!tasks_.empty()) {
+      std::vector<task> tasks;
+      tasks.swap(tasks_);
+      for (auto& tsk : tasks) {
+        tsk.run();
+      }
+    }
+  }
+
+protected:
+  void do_post_task(task&& tsk) override { tasks_.push_back(std::move(tsk)); }
+
+private:
+  std::vector<task> tasks_;
+};
+
+}  // namespace
+
+
+TEST(queued_slot_batching) {
+  auto runner = std::make_shared<manual_task_runner>();
+  signal<int> sig;
+  std::vector<int> received[3];
+  std::vector<slot_handle> handles;
+  for (auto& values : received) {
+    handles.push_back(sig.connect([&values](int value) { values.push_back(value); }, runner));
+  }
+
+  // a burst of emissions to any number of slots on one runner costs a single task
+  for (int i = 0; i < 100; i++) {
+    sig(i);
+  }
+  CHECK(runner->pending() == 1);
+  for (auto& values : received) {
+    CHECK(values.empty());
+  }
+
+  runner->run_all();
+  std::vector<int> expected;
+  for (int i = 0; i < 100; i++) {
+    expected.push_back(i);
+  }
+  for (auto& values : received) {
+    CHECK(values == expected);
+  }
+
+  // and the next burst posts another one
+  sig(100);
+  sig(101);
+  CHECK(runner->pending() == 1);
+  runner->run_all();
+  CHECK((received[0].size() == 102 && received[0].back() == 101));
+}
+
+TEST(queued_slot_latest) {
+  auto runner = std::make_shared<manual_task_runner>();
+  signal<int> sig;
+  std::vector<int> all;
+  std::vector<int> latest;
+  slot_handle all_handle = sig.connect([&](int value) { all.push_back(value); }, runner);
+  slot_handle latest_handle = sig.connect([&](int value) { latest.push_back(value); }, runner,
+    queued_delivery::latest);
+
+  for (int i = 1; i <= 10; i++) {
+    sig(i);
+  }
+  CHECK(runner->pending() == 1);
+  runner->run_all();
+  CHECK(all.size() == 10);
+  CHECK((latest == std::vector<int>{ 10 }));
+
+  sig(11);
+  sig(12);
+  runner->run_all();
+  CHECK((latest == std::vector<int>{ 10, 12 }));
+}
+
+TEST(queued_slot_expired_runner) {
+  auto runner = std::make_shared<manual_task_runner>();
+  signal<std::shared_ptr<int>> sig;
+  int calls = 0;
+  slot_handle handle = sig.connect([&](const std::shared_ptr<int>&) { calls++; }, runner);
+
+  // the arguments of queued emissions are held until delivered or dropped
+  auto arg = std::make_shared<int>(0);
+  sig(arg);
+  sig(arg);
+  CHECK(arg.use_count() == 3);
+
+  // destroying the runner destroys the task without running it, which drops the emissions
+  runner.reset();
+  CHECK(arg.use_count() == 1);
+
+  // and those emitted from now on are dropped right away, instead of piling up
+  for (int i = 0; i < 1000; i++) {
+    sig(arg);
+    CHECK(arg.use_count() == 1);
+  }
+  CHECK(calls == 0);
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "test.h"
+#include "base/thread/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace base;
+using namespace std::chrono_literals;
+
+namespace {
+
+// keeps every worker of `runner` busy with a task that reposts itself until `stop` is set
+void saturate(const thread_pool_task_runner::ptr& runner, std::atomic<bool>& stop, std::atomic<int>& running) {
+  struct spinner {
+    void operator()() const {
+      if (!stop->load()) {
+        runner->post_task(*this);
+      } else {
+        --*running;
+      }
+    }
+
+    thread_pool_task_runner* runner;
+    std::atomic<bool>* stop;
+    std::atomic<int>* running;
+  };
+
+  for (int i = 0; i < runner->worker_count(); i++) {
+    ++running;
+    runner->post_task(spinner{ runner.get(), &stop, &running });
+  }
+}
+
+}  // namespace
+
+
+TEST(thread_pool_runs_everything) {
+  thread_pool pool(4);
+  constexpr int count = 10000;
+  std::atomic<int> ran = 0;
+  std::promise<void> all_ran;
+  auto run = [&] {
+    if (++ran == count) {
+      all_ran.set_value();
+    }
+  };
+
+  // half posted one at a time, half in batches, some of them from the workers
+  for (int i = 0; i < count / 4; i++) {
+    pool.task_runner()->post_task(run);
+    pool.task_runner()->post_task([&] { pool.task_runner()->post_task(run); });
+  }
+  for (int i = 0; i < count / 2; i += 100) {
+    std::vector<task::callback_type> batch;
+    for (int j = 0; j < 100; j++) {
+      batch.push_back(run);
+    }
+    pool.task_runner()->post_tasks(std::move(batch));
+  }
+
+  CHECK(all_ran.get_future().wait_for(10s) == std::future_status::ready);
+}
+
+TEST(thread_pool_delayed_task_order) {
+  thread_pool pool(2);
+  std::promise<std::chrono::steady_clock::time_point> later;
+  std::promise<std::chrono::steady_clock::time_point> sooner;
+
+  auto start = std::chrono::steady_clock::now();
+  pool.task_runner()->post_task([&] { later.set_value(std::chrono::steady_clock::now()); }, 60ms);
+  pool.task_runner()->post_task([&] { sooner.set_value(std::chrono::steady_clock::now()); }, 20ms);
+
+  auto sooner_time = sooner.get_future().get();
+  auto later_time = later.get_future().get();
+  CHECK(sooner_time - start >= 20ms);
+  CHECK(later_time - start >= 60ms);
+  CHECK(sooner_time <= later_time);
+}
+
+TEST(thread_pool_delayed_task_while_saturated) {
+  // due delayed tasks must not wait for the immediate tasks to run out
+  thread_pool pool(2);
+  std::atomic<bool> stop = false;
+  std::atomic<int> running = 0;
+  saturate(pool.task_runner(), stop, running);
+
+  std::promise<void> ran;
+  pool.task_runner()->post_task([&] { ran.set_value(); }, 10ms);
+  std::promise<void> ran_at;
+  pool.task_runner()->post_task([&] { ran_at.set_value(); }, std::chrono::steady_clock::now() + 20ms);
+
+  CHECK(ran.get_future().wait_for(5s) == std::future_status::ready);
+  CHECK(ran_at.get_future().wait_for(5s) == std::future_status::ready);
+
+  stop = true;
+  while (running) {
+    std::this_thread::yield();
+  }
+}
\ No newline at end of file
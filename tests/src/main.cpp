@@ -0,0 +1,80 @@
+#include "test.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace test {
+namespace {
+
+struct registered_test {
+  const char* name;
+  test_function fn;
+  bool is_benchmark;
+};
+
+std::vector<registered_test>& registry() {
+  static std::vector<registered_test> tests;
+  return tests;
+}
+
+int failures = 0;  // in the running test
+
+}  // namespace
+
+
+registrar::registrar(const char* name, test_function fn, bool is_benchmark) {
+  registry().push_back({ name, fn, is_benchmark });
+}
+
+void add_failure(const char* file, int line, const char* expr) {
+  std::printf("%s(%d): check failed: %s\n", file, line, expr);
+  failures++;
+}
+
+void check_near(const char* file, int line, const char* expr, double actual, double expected,
+  double tolerance) {
+  if (!(std::abs(actual - expected) <= tolerance)) {
+    std::printf("%s(%d): %s is %.9g, expected %.9g (within %g)\n", file, line, expr, actual,
+      expected, tolerance);
+    failures++;
+  }
+}
+
+}  // namespace test
+
+
+int main(int argc, char** argv) {
+  bool benchmarks = false;
+  const char* filter = "";
+  for (int i = 1; i < argc; i++) {
+    if (std::string_view(argv[i]) == "--bench") {
+      benchmarks = true;
+    } else {
+      filter = argv[i];
+    }
+  }
+
+  int run = 0;
+  int failed = 0;
+  for (const auto& t : test::registry()) {
+    if (t.is_benchmark != benchmarks || !std::strstr(t.name, filter)) {
+      continue;
+    }
+
+    std::printf("%s\n", t.name);
+    std::fflush(stdout);
+    test::failures = 0;
+    t.fn();
+    run++;
+    if (test::failures) {
+      std::printf("%s FAILED\n", t.name);
+      failed++;
+    }
+  }
+
+  std::printf("%d of %d %s passed\n", run - failed, run, benchmarks ? "benchmarks" : "tests");
+  return failed ? 1 : 0;
+}
\ No newline at end of file
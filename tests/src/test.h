@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// A minimal test runner. TEST functions register themselves at startup and are all run by
+// main(), or only those whose name contains the filter given on its command line. A failed
+// CHECK reports the failure and lets the test go on. BENCHMARK functions only run with --bench.
+
+#define TEST(name) \
+  static void test_##name(); \
+  static const ::test::registrar test_##name##_registrar(#name, test_##name, false); \
+  static void test_##name()
+
+#define BENCHMARK(name) \
+  static void bench_##name(); \
+  static const ::test::registrar bench_##name##_registrar(#name, bench_##name, true); \
+  static void bench_##name()
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      ::test::add_failure(__FILE__, __LINE__, #cond); \
+    } \
+  } while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+  do { \
+    ::test::check_near(__FILE__, __LINE__, #actual, (actual), (expected), (tolerance)); \
+  } while (false)
+
+namespace test {
+
+using test_function = void (*)();
+
+struct registrar {
+  registrar(const char* name, test_function fn, bool is_benchmark);
+};
+
+void add_failure(const char* file, int line, const char* expr);
+void check_near(const char* file, int line, const char* expr, double actual, double expected,
+  double tolerance);
+
+
+// runs `fn` `iterations` times and prints the average time per call
+template<typename F>
+void measure(const char* what, int iterations, F&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    fn();
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  std::printf("  %s: %.3f us\n", what, elapsed.count() / iterations);
+}
+
+}  // namespace test
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "test.h"
+#include "ui/gfx/geom/test_paths.h"
+#include "ui/gfx/geom/impl/fill_bands.h"
+#include "ui/gfx/geom/impl/path_segments.h"
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace gfx;
+using namespace gfx::impl;
+
+namespace {
+
+// counts the crossings of a ray to the right with every edge of `flat`
+bool brute_force_contains(const flat_path& flat, const pointf& pt, fill_mode mode) {
+  int winding = 0;
+  for (const auto& contour : flat.contours) {
+    for (std::size_t i = contour.begin; i < contour.end; i++) {
+      pointf a = flat.points[i];
+      pointf b = flat.points[i + 1 < contour.end ? i + 1 : contour.begin];
+      if (a.y() == b.y()) {
+        continue;
+      }
+
+      int dir = a.y() < b.y() ? 1 : -1;
+      if (dir < 0) {
+        std::swap(a, b);
+      }
+      if (pt.y() >= a.y() && pt.y() < b.y()) {
+        double x = a.x() + (pt.y() - static_cast<double>(a.y())) * (static_cast<double>(b.x()) - a.x())
+          / (static_cast<double>(b.y()) - a.y());
+        if (x > pt.x()) {
+          winding += dir;
+        }
+      }
+    }
+  }
+  return mode == fill_mode::winding ? winding != 0 : (winding & 1) != 0;
+}
+
+// the number of points at which `p.bands()` and the brute force reference differ
+int count_mismatches(const test::test_path& p, const std::vector<pointf>& points) {
+  flat_path flat = flatten(p.segments(), precise_flattening_tolerance);
+  int mismatches = 0;
+  for (fill_mode mode : { fill_mode::winding, fill_mode::even_odd }) {
+    for (const auto& pt : points) {
+      mismatches += p.bands().contains(pt, mode) != brute_force_contains(flat, pt, mode);
+    }
+  }
+  return mismatches;
+}
+
+void add_random_circles(test::test_path& p, std::mt19937& rng, int count) {
+  std::uniform_real_distribution<float> coord(0, 300);
+  for (int i = 0; i < count; i++) {
+    test::add_circle(p.verbs, { coord(rng), coord(rng) }, 5 + coord(rng) / 6);
+  }
+}
+
+std::vector<pointf> random_points(std::mt19937& rng, int count) {
+  std::uniform_real_distribution<float> coord(-15, 315);
+  std::vector<pointf> ret;
+  for (int i = 0; i < count; i++) {
+    ret.push_back({ coord(rng), coord(rng) });
+  }
+  return ret;
+}
+
+}  // namespace
+
+
+TEST(fill_bands_nested_rects) {
+  test::test_path p;
+  test::add_rect(p.verbs, 0, 0, 100, 100);
+  test::add_rect(p.verbs, 25, 25, 50, 50);
+  const fill_bands& bands = p.bands();
+
+  CHECK(bands.contains({ 10, 10 }, fill_mode::winding));
+  CHECK(bands.contains({ 10, 10 }, fill_mode::even_odd));
+  CHECK(bands.contains({ 50, 50 }, fill_mode::winding));
+  CHECK(!bands.contains({ 50, 50 }, fill_mode::even_odd));
+  CHECK(!bands.contains({ 150, 50 }, fill_mode::winding));
+  CHECK(!bands.contains({ 50, -1 }, fill_mode::winding));
+
+  // the left side and top are in, the right side and bottom are not
+  CHECK(bands.contains({ 0, 0 }, fill_mode::winding));
+  CHECK(bands.contains({ 0, 50 }, fill_mode::winding));
+  CHECK(bands.contains({ 50, 0 }, fill_mode::winding));
+  CHECK(!bands.contains({ 100, 50 }, fill_mode::winding));
+  CHECK(!bands.contains({ 50, 100 }, fill_mode::winding));
+}
+
+TEST(fill_bands_shared_edges) {
+  // a point on the edge between two adjacent shapes hits exactly one of them
+  test::test_path left;
+  test::add_rect(left.verbs, 0, 0, 50, 50);
+  test::test_path right;
+  test::add_polygon(right.verbs, { { 50, 0 }, { 90, 25 }, { 50, 50 } });
+
+  for (float y : { 10.f, 25.f, 49.5f }) {
+    bool in_left = left.bands().contains({ 50, y }, fill_mode::winding);
+    bool in_right = right.bands().contains({ 50, y }, fill_mode::winding);
+    CHECK(in_left != in_right);
+  }
+}
+
+TEST(fill_bands_empty) {
+  test::test_path p;
+  CHECK(!p.bands().contains({ 0, 0 }, fill_mode::winding));
+  CHECK(!p.bands().contains({ 0, 0 }, fill_mode::even_odd));
+
+  // a line has no area
+  test::test_path line;
+  line.verbs.move_to({ 0, 0 });
+  line.verbs.line_to({ 100, 100 });
+  CHECK(!line.bands().contains({ 50, 50 }, fill_mode::winding));
+  CHECK(!line.bands().contains({ 49, 50 }, fill_mode::winding));
+}
+
+TEST(fill_bands_random_circles) {
+  std::mt19937 rng(1);
+  test::test_path p;
+  add_random_circles(p, rng, 50);
+  CHECK(count_mismatches(p, random_points(rng, 5000)) == 0);
+}
+
+TEST(fill_bands_comb) {
+  // many tall, thin teeth, so that every band overlaps most edges
+  test::test_path p;
+  for (int i = 0; i < 2000; i++) {
+    float x = static_cast<float>(i * 3);
+    test::add_polygon(p.verbs, { { x, 0 }, { x + 2, 0 }, { x + 1, 1000 } });
+  }
+
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<float> x(-10, 6010);
+  std::uniform_real_distribution<float> y(-10, 1010);
+  std::vector<pointf> points;
+  for (int i = 0; i < 2000; i++) {
+    points.push_back({ x(rng), y(rng) });
+  }
+  CHECK(count_mismatches(p, points) == 0);
+}
+
+
+BENCHMARK(fill_bands_random_circles) {
+  std::mt19937 rng(1);
+  test::test_path p;
+  add_random_circles(p, rng, 200);
+  p.segments();
+
+  test::measure("build for 200 circles", 1, [&] { p.bands(); });
+
+  std::vector<pointf> points = random_points(rng, 100000);
+  std::size_t i = 0;
+  test::measure("contains", static_cast<int>(points.size()), [&] {
+    volatile bool hit = p.bands().contains(points[i++], fill_mode::winding);
+    (void)hit;
+  });
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "test.h"
+#include "ui/gfx/geom/test_paths.h"
+#include "ui/gfx/geom/impl/path_measure.h"
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/util.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace gfx;
+using namespace gfx::impl;
+
+TEST(path_measure_circle) {
+  test::test_path p;
+  test::add_circle(p.verbs, { 50, 50 }, 40);
+
+  CHECK_NEAR(p.measure().length(), 2 * pi<double> * 40, 0.02);
+  CHECK_NEAR(p.bands().area(fill_mode::winding), pi<double> * 40 * 40, 1);
+
+  rectf bounds = segment_bounds(p.segments());
+  CHECK_NEAR(bounds.x(), 10, 1e-3);
+  CHECK_NEAR(bounds.y(), 10, 1e-3);
+  CHECK_NEAR(bounds.right(), 90, 1e-3);
+  CHECK_NEAR(bounds.bottom(), 90, 1e-3);
+
+  // clockwise from (90, 50), a quarter of the way round is at the bottom
+  auto [pt, tangent] = p.measure().point_tangent_at(p.measure().length() / 4);
+  CHECK_NEAR(pt.x(), 50, 0.02);
+  CHECK_NEAR(pt.y(), 90, 0.02);
+  CHECK_NEAR(tangent.x(), -1, 1e-3);
+  CHECK_NEAR(tangent.y(), 0, 0.01);
+
+  // distances past the end are clamped
+  auto [end, end_tangent] = p.measure().point_tangent_at(1e9f);
+  CHECK_NEAR(end.x(), 90, 1e-3);
+  CHECK_NEAR(end.y(), 50, 1e-3);
+}
+
+TEST(path_measure_rotated_ellipse) {
+  float rotation = 0.5f;
+  test::test_path p;
+  test::add_ellipse(p.verbs, { 0, 0 }, 30, 10, rotation);
+
+  double c = std::cos(rotation);
+  double s = std::sin(rotation);
+  double half_width = std::sqrt(30 * 30 * c * c + 10 * 10 * s * s);
+  double half_height = std::sqrt(30 * 30 * s * s + 10 * 10 * c * c);
+  rectf bounds = segment_bounds(p.segments());
+  CHECK_NEAR(bounds.x(), -half_width, 0.01);
+  CHECK_NEAR(bounds.right(), half_width, 0.01);
+  CHECK_NEAR(bounds.y(), -half_height, 0.01);
+  CHECK_NEAR(bounds.bottom(), half_height, 0.01);
+
+  CHECK_NEAR(p.bands().area(fill_mode::winding), pi<double> * 30 * 10, 0.5);
+
+  // Ramanujan's approximation of the perimeter, far more precise than needed here
+  double h = (30.0 - 10) * (30.0 - 10) / ((30.0 + 10) * (30.0 + 10));
+  CHECK_NEAR(p.measure().length(), pi<double> * (30 + 10) * (1 + 3 * h / (10 + std::sqrt(4 - 3 * h))), 0.02);
+}
+
+TEST(path_measure_nested_rects) {
+  test::test_path p;
+  test::add_rect(p.verbs, 0, 0, 100, 100);
+  test::add_rect(p.verbs, 25, 25, 50, 50);
+
+  CHECK_NEAR(p.bands().area(fill_mode::winding), 100 * 100, 1e-3);
+  CHECK_NEAR(p.bands().area(fill_mode::even_odd), 100 * 100 - 50 * 50, 1e-3);
+  CHECK_NEAR(p.measure().length(), 4 * 100 + 4 * 50, 1e-3);
+
+  // a hole running the other way is left out with either fill mode
+  test::test_path holed;
+  test::add_rect(holed.verbs, 0, 0, 100, 100);
+  test::add_rect(holed.verbs, 25, 25, 50, 50, sweep_dir::counter_clockwise);
+  CHECK_NEAR(holed.bands().area(fill_mode::winding), 100 * 100 - 50 * 50, 1e-3);
+  CHECK_NEAR(holed.bands().area(fill_mode::even_odd), 100 * 100 - 50 * 50, 1e-3);
+}
+
+TEST(path_measure_self_intersecting) {
+  // an open bowtie: closed for filling, but not for measuring
+  test::test_path bowtie;
+  bowtie.verbs.move_to({ 0, 0 });
+  bowtie.verbs.line_to({ 100, 100 });
+  bowtie.verbs.line_to({ 100, 0 });
+  bowtie.verbs.line_to({ 0, 100 });
+  CHECK_NEAR(bowtie.bands().area(fill_mode::winding), 5000, 0.01);
+  CHECK_NEAR(bowtie.measure().length(), 100 + 2 * std::sqrt(2.0) * 100, 0.01);
+
+  // a pentagram has its inner pentagon filled with winding but not with even_odd
+  test::test_path star;
+  for (int i = 0; i < 5; i++) {
+    pointf pt = point_for_angle(-half_pi<float> + i * 4 * pi<float> / 5, 100);
+    if (i == 0) {
+      star.verbs.move_to(pt);
+    } else {
+      star.verbs.line_to(pt);
+    }
+  }
+  star.verbs.close();
+  double inner_radius = 100 * std::cos(deg_to_rad(72.0)) / std::cos(deg_to_rad(36.0));
+  double inner_area = 2.5 * inner_radius * inner_radius * std::sin(deg_to_rad(72.0));
+  double winding = star.bands().area(fill_mode::winding);
+  double even_odd = star.bands().area(fill_mode::even_odd);
+  CHECK_NEAR(winding - even_odd, inner_area, 0.05);
+}
+
+TEST(path_measure_cubic) {
+  test::test_path p;
+  p.verbs.move_to({ 0, 0 });
+  p.verbs.cubic_to({ 100, -80 }, { -50, 120 }, { 60, 30 });
+
+  // against dense sampling of the curve
+  const path_segment& seg = p.segments().segments.at(0);
+  float left = 0, top = 0, right = 0, bottom = 0;
+  double length = 0;
+  pointf prev = seg.eval(0);
+  for (int i = 1; i <= 200000; i++) {
+    pointf pt = seg.eval(i / 200000.f);
+    left = std::min(left, pt.x());
+    top = std::min(top, pt.y());
+    right = std::max(right, pt.x());
+    bottom = std::max(bottom, pt.y());
+    length += mag(pt - prev);
+    prev = pt;
+  }
+
+  rectf bounds = segment_bounds(p.segments());
+  CHECK_NEAR(bounds.x(), left, 1e-3);
+  CHECK_NEAR(bounds.y(), top, 1e-3);
+  CHECK_NEAR(bounds.right(), right, 1e-3);
+  CHECK_NEAR(bounds.bottom(), bottom, 1e-3);
+  CHECK_NEAR(p.measure().length(), length, 0.01);
+}
+
+TEST(path_measure_empty) {
+  test::test_path p;
+  CHECK_NEAR(p.measure().length(), 0, 0);
+  CHECK_NEAR(p.bands().area(fill_mode::winding), 0, 0);
+  CHECK(p.segments().figures.empty());
+
+  auto [pt, tangent] = p.measure().point_tangent_at(3);
+  CHECK_NEAR(mag(tangent), 0, 0);
+}
+
+
+BENCHMARK(path_measure_circles) {
+  test::test_path p;
+  for (int i = 0; i < 200; i++) {
+    test::add_circle(p.verbs, { static_cast<float>(i * 7 % 300), static_cast<float>(i * 13 % 300) },
+      static_cast<float>(20 + i % 30));
+  }
+
+  test::measure("measure of 200 circles", 1, [&] { p.measure(); });
+  test::measure("area of 200 circles", 1, [&] { p.bands().area(fill_mode::winding); });
+
+  float length = p.measure().length();
+  int i = 0;
+  test::measure("point_tangent_at", 1000000, [&] {
+    volatile float x = p.measure().point_tangent_at(length * (i++ % 997) / 997).first.x();
+    (void)x;
+  });
+}
\ No newline at end of file
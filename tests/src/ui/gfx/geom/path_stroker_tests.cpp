@@ -0,0 +1,245 @@
+#include "test.h"
+#include "ui/gfx/geom/test_paths.h"
+#include "ui/gfx/geom/impl/fill_bands.h"
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/geom/impl/path_stroker.h"
+#include "ui/gfx/util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+using namespace gfx;
+using namespace gfx::impl;
+
+namespace {
+
+// the area covered by the stroke, counting overlaps once
+double stroke_area(const test::test_path& p, const stroke_params& params) {
+  return fill_bands(p.stroke(params)->pieces()).area(fill_mode::winding);
+}
+
+// tests every piece, which are all convex and run clockwise
+bool brute_force_contains(const flat_path& pieces, const pointf& pt) {
+  for (const auto& contour : pieces.contours) {
+    bool inside = true;
+    for (std::size_t i = contour.begin; inside && i + 1 < contour.end; i++) {
+      const pointf& a = pieces.points[i];
+      const pointf& b = pieces.points[i + 1];
+      inside = (static_cast<double>(b.x()) - a.x()) * (pt.y() - a.y())
+        >= (static_cast<double>(b.y()) - a.y()) * (pt.x() - a.x());
+    }
+    if (inside) {
+      return true;
+    }
+  }
+  return false;
+}
+
+double distance_to_segment(const pointf& pt, const pointf& a, const pointf& b) {
+  pointf d = b - a;
+  float len_squared = mag_squared(d);
+  float t = len_squared > 0 ? std::clamp(((pt.x() - a.x()) * d.x() + (pt.y() - a.y()) * d.y()) / len_squared, 0.f, 1.f) : 0.f;
+  return mag(pt - (a + d * t));
+}
+
+// many random, crossing lines, each its own figure
+segment_list random_lines(std::mt19937& rng, int count) {
+  std::uniform_real_distribution<float> coord(0, 1000);
+  segment_list ret;
+  for (int i = 0; i < count; i++) {
+    ret.segments.push_back({ segment_kind::line, { { coord(rng), coord(rng) }, { coord(rng), coord(rng) } } });
+    ret.figures.push_back({ ret.segments.size() - 1, ret.segments.size(), false });
+  }
+  return ret;
+}
+
+}  // namespace
+
+
+TEST(path_stroker_caps) {
+  test::test_path line;
+  line.verbs.move_to({ 0, 0 });
+  line.verbs.line_to({ 100, 0 });
+
+  stroke_params params;
+  params.width = 10;
+  CHECK_NEAR(stroke_area(line, params), 100 * 10, 1e-3);
+  CHECK(line.stroke(params)->contains({ 50, 4.9f }));
+  CHECK(!line.stroke(params)->contains({ 50, 5.1f }));
+  CHECK(!line.stroke(params)->contains({ -1, 0 }));
+
+  params.start_cap = params.end_cap = stroke_cap_style::square;
+  CHECK_NEAR(stroke_area(line, params), 110 * 10, 1e-3);
+  CHECK(line.stroke(params)->contains({ -4.5f, 4.5f }));
+
+  params.start_cap = params.end_cap = stroke_cap_style::tri;
+  CHECK_NEAR(stroke_area(line, params), 100 * 10 + 2 * 25, 1e-3);
+
+  params.start_cap = params.end_cap = stroke_cap_style::round;
+  CHECK_NEAR(stroke_area(line, params), 100 * 10 + pi<double> * 5 * 5, 6);
+  CHECK(line.stroke(params)->contains({ -4.5f, 0 }));
+  CHECK(!line.stroke(params)->contains({ -4.5f, 4 }));
+}
+
+TEST(path_stroker_joins) {
+  test::test_path corner;
+  corner.verbs.move_to({ 0, 0 });
+  corner.verbs.line_to({ 100, 0 });
+  corner.verbs.line_to({ 100, 100 });
+
+  stroke_params params;
+  params.width = 10;
+  CHECK_NEAR(stroke_area(corner, params), 2000, 1e-3);
+  CHECK(corner.stroke(params)->contains({ 104.5f, -4.5f }));
+
+  params.line_join = stroke_line_join::bevel;
+  CHECK_NEAR(stroke_area(corner, params), 2000 - 12.5, 1e-3);
+  CHECK(!corner.stroke(params)->contains({ 104.5f, -4.5f }));
+
+  params.line_join = stroke_line_join::round;
+  CHECK_NEAR(stroke_area(corner, params), 2000 - 25 + pi<double> * 25 / 4, 1.5);
+
+  // a right angle needs a miter limit of sqrt(2)
+  params.line_join = stroke_line_join::limited_miter;
+  CHECK_NEAR(stroke_area(corner, params), 2000, 1e-3);
+  params.miter_limit = 1.4f;
+  CHECK_NEAR(stroke_area(corner, params), 2000 - 12.5, 1e-3);
+
+  // the miter is cut at 1.4 half widths from the vertex, 5 * sqrt(2) being its full length
+  params.line_join = stroke_line_join::miter;
+  double cut = 5 * std::sqrt(2.0) - 7;
+  CHECK_NEAR(stroke_area(corner, params), 2000 - cut * cut, 0.01);
+}
+
+TEST(path_stroker_closed) {
+  test::test_path square;
+  test::add_rect(square.verbs, 0, 0, 100, 100);
+
+  // caps don't apply to closed figures
+  stroke_params params;
+  params.width = 10;
+  params.start_cap = params.end_cap = stroke_cap_style::round;
+  CHECK_NEAR(stroke_area(square, params), 110 * 110 - 90 * 90, 0.01);
+  CHECK(square.stroke(params)->contains({ -4.5f, -4.5f }));
+
+  params.line_join = stroke_line_join::bevel;
+  CHECK_NEAR(stroke_area(square, params), 110 * 110 - 90 * 90 - 4 * 12.5, 0.01);
+}
+
+TEST(path_stroker_dashes) {
+  test::test_path line;
+  line.verbs.move_to({ 0, 0 });
+  line.verbs.line_to({ 100, 0 });
+
+  // in units of the width: dashes at [2.5, 7.5], [12.5, 17.5], ... once offset
+  stroke_params params;
+  params.width = 2;
+  params.dashes = { 5, 5 };
+  CHECK_NEAR(stroke_area(line, params), 100, 1e-3);
+  params.dash_offset = 2.5f;
+  auto stroke = line.stroke(params);
+  CHECK_NEAR(stroke_area(line, params), 100, 1e-3);
+  CHECK(stroke->contains({ 2, 0 }));
+  CHECK(!stroke->contains({ 7, 0 }));
+  CHECK(stroke->contains({ 17, 0 }));
+
+  // round dots every 4
+  params.dash_offset = 0;
+  params.dashes = { 0, 2 };
+  params.dash_cap = stroke_cap_style::round;
+  stroke = line.stroke(params);
+  CHECK(stroke->contains({ 40, 0.5f }));
+  CHECK(!stroke->contains({ 42, 0 }));
+
+  // patterns that can't be drawn are stroked solid
+  params.dash_cap = stroke_cap_style::flat;
+  params.dashes = { 1e-9f, 1e-9f };
+  CHECK_NEAR(stroke_area(line, params), 200, 1e-3);
+  params.dashes = { -1, 2 };
+  CHECK_NEAR(stroke_area(line, params), 200, 1e-3);
+}
+
+TEST(path_stroker_round_distance) {
+  // with round joins and caps, the stroke is every point within half the width of the path
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> coord(0, 200);
+  test::test_path p;
+  std::vector<pointf> points;
+  for (int i = 0; i < 12; i++) {
+    points.push_back({ coord(rng), coord(rng) });
+    if (i == 0) {
+      p.verbs.move_to(points.back());
+    } else {
+      p.verbs.line_to(points.back());
+    }
+  }
+
+  stroke_params params;
+  params.width = 16;
+  params.start_cap = params.end_cap = stroke_cap_style::round;
+  params.line_join = stroke_line_join::round;
+  auto stroke = p.stroke(params);
+
+  // round parts are flattened, so points near the outline may go either way
+  double margin = default_flattening_tolerance + 0.01;
+  int tested = 0;
+  for (int i = 0; i < 5000; i++) {
+    pointf pt = { coord(rng), coord(rng) };
+    double dist = HUGE_VAL;
+    for (std::size_t j = 0; j + 1 < points.size(); j++) {
+      dist = std::min(dist, distance_to_segment(pt, points[j], points[j + 1]));
+    }
+    if (std::abs(dist - params.width / 2) > margin) {
+      CHECK(stroke->contains(pt) == (dist < params.width / 2));
+      tested++;
+    }
+  }
+  CHECK(tested > 4000);
+}
+
+TEST(path_stroker_hit_grid) {
+  std::mt19937 rng(3);
+  stroke_params params;
+  params.width = 2;
+  flat_path pieces = stroke_segments(random_lines(rng, 1000), params, default_flattening_tolerance);
+  stroke_hit_grid grid(pieces);
+
+  std::uniform_real_distribution<float> coord(-10, 1010);
+  int mismatches = 0;
+  int hits = 0;
+  for (int i = 0; i < 5000; i++) {
+    pointf pt = { coord(rng), coord(rng) };
+    bool hit = grid.contains(pt);
+    mismatches += hit != brute_force_contains(pieces, pt);
+    hits += hit;
+  }
+  CHECK(mismatches == 0);
+  CHECK(hits > 0);
+
+  // on the outline of a piece, as edges are included
+  for (std::size_t i = 0; i < pieces.points.size(); i += 97) {
+    CHECK(grid.contains(pieces.points[i]));
+  }
+
+  flat_path none;
+  CHECK(!stroke_hit_grid(none).contains({ 0, 0 }));
+}
+
+
+BENCHMARK(path_stroker_hit_grid) {
+  std::mt19937 rng(3);
+  stroke_params params;
+  params.width = 2;
+  flat_path pieces = stroke_segments(random_lines(rng, 4000), params, default_flattening_tolerance);
+
+  test::measure("build for 4000 crossing lines", 1, [&] { stroke_hit_grid grid(pieces); });
+
+  stroke_hit_grid grid(pieces);
+  std::uniform_real_distribution<float> coord(0, 1000);
+  test::measure("contains", 100000, [&] {
+    volatile bool hit = grid.contains({ coord(rng), coord(rng) });
+    (void)hit;
+  });
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ui/gfx/geom/impl/path_cache.h"
+#include "ui/gfx/geom/impl/path_segments.h"
+#include "ui/gfx/geom/impl/path_storage.h"
+#include "ui/gfx/geom/path_verbs.h"
+#include "ui/gfx/geom/point.h"
+#include <cmath>
+#include <initializer_list>
+#include <memory>
+
+namespace test {
+
+// The verbs of a path and the data derived from them, held as gfx::path holds them. The data is
+// computed on first use, so all verbs must be added before.
+struct test_path {
+  const gfx::impl::segment_list& segments() const { return cache.segments(verbs.view()); }
+  const gfx::impl::path_measure& measure() const { return cache.measure(verbs.view()); }
+  const gfx::impl::fill_bands& bands() const { return cache.bands(verbs.view()); }
+  std::shared_ptr<const gfx::impl::stroked_path> stroke(const gfx::impl::stroke_params& params) const {
+    return cache.stroke(verbs.view(), params);
+  }
+
+  gfx::impl::path_storage verbs;
+  gfx::impl::path_cache cache;
+};
+
+
+// all shapes run clockwise (as seen with y pointing down) unless `dir` says otherwise
+
+inline void add_ellipse(gfx::impl::path_storage& verbs, const gfx::pointf& center, float rx, float ry,
+  float rotation = 0, gfx::sweep_dir dir = gfx::sweep_dir::clockwise) {
+  gfx::pointf rel = { rx * std::cos(rotation), rx * std::sin(rotation) };
+  gfx::arc_params arc = { { rx, ry }, rotation, gfx::arc_size::small_arc, dir };
+  verbs.move_to(center + rel);
+  verbs.arc_to(center - rel, arc);
+  verbs.arc_to(center + rel, arc);
+  verbs.close();
+}
+
+inline void add_circle(gfx::impl::path_storage& verbs, const gfx::pointf& center, float radius,
+  gfx::sweep_dir dir = gfx::sweep_dir::clockwise) {
+  add_ellipse(verbs, center, radius, radius, 0, dir);
+}
+
+inline void add_polygon(gfx::impl::path_storage& verbs, std::initializer_list<gfx::pointf> points) {
+  for (const auto& pt : points) {
+    if (&pt == points.begin()) {
+      verbs.move_to(pt);
+    } else {
+      verbs.line_to(pt);
+    }
+  }
+  verbs.close();
+}
+
+inline void add_rect(gfx::impl::path_storage& verbs, float x, float y, float w, float h,
+  gfx::sweep_dir dir = gfx::sweep_dir::clockwise) {
+  if (dir == gfx::sweep_dir::clockwise) {
+    add_polygon(verbs, { { x, y }, { x + w, y }, { x + w, y + h }, { x, y + h } });
+  } else {
+    add_polygon(verbs, { { x, y }, { x, y + h }, { x + w, y + h }, { x + w, y } });
+  }
+}
+
+
+// a flattened polygon, closed
+inline gfx::impl::flat_path flat_polygon(std::initializer_list<gfx::pointf> points) {
+  gfx::impl::flat_path ret;
+  ret.points.assign(points.begin(), points.end());
+  ret.points.push_back(*points.begin());
+  ret.contours.push_back({ 0, ret.points.size(), true });
+  return ret;
+}
+
+}  // namespace test
\ No newline at end of file